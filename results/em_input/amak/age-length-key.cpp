@@ -0,0 +1,349 @@
+#include <admodel.h>
+#include "age-length-key.h"
+
+age_length_key::~age_length_key()
+{}
+
+age_length_key::age_length_key()
+: m_l1(1), m_l2(0), m_dTol(1.e-10)
+{}
+
+age_length_key::age_length_key(const dvector& _len_bins)
+: m_dTol(1.e-10)
+{
+	set_bins(_len_bins);
+}
+
+
+void age_length_key::set_bins(const dvector& _len_bins)
+{
+	/*
+	len_bins - bin mid-points.
+
+	Each bin is its mid-point plus and minus half the width of the first
+	bin (as in the original ALK function), so with equal bin widths the
+	upper edge of one bin is the lower edge of the next and is stored once.
+	*/
+	m_l1 = _len_bins.indexmin();
+	m_l2 = _len_bins.indexmax();
+
+	double xs = m_l2 > m_l1 ? 0.5 * (_len_bins(m_l1+1) - _len_bins(m_l1)) : 0.5;
+
+	dvector edge(1, 2*(m_l2-m_l1+1));
+	m_nLo.allocate(m_l1,m_l2);
+	m_nHi.allocate(m_l1,m_l2);
+
+	int ne = 0;
+	for(int j = m_l1; j <= m_l2; j++ )
+	{
+		double lo = _len_bins(j) - xs;
+		if( ne == 0 || fabs(lo - edge(ne)) > 1.e-10 * (1. + fabs(lo)) )
+			edge(++ne) = lo;
+		m_nLo(j) = ne;
+		edge(++ne) = _len_bins(j) + xs;
+		m_nHi(j) = ne;
+	}
+	m_dEdge.allocate(1,ne);
+	m_dEdge = edge(1,ne);
+}
+
+
+void age_length_key::set_tolerance(double _tol)
+{
+	m_dTol = _tol;
+}
+
+
+int age_length_key::nedges() const
+{
+	return m_dEdge.indexmax();
+}
+
+
+int age_length_key::band_width(int age) const
+{
+	return m_nLast(age) - m_nFirst(age) + 1;
+}
+
+
+/*
+	Keeps the key and, for each age, the first and last bin with a
+	proportion above the tolerance (the largest bin if none is).
+*/
+void age_length_key::set_band(const dmatrix& P)
+{
+	int a1 = P.rowmin(), a2 = P.rowmax();
+	if( !allocated(m_dP) || m_dP.rowmin() != a1 || m_dP.rowmax() != a2 )
+	{
+		m_dP.deallocate();
+		m_dP.allocate(a1,a2,m_l1,m_l2);
+		m_dfP.deallocate();
+		m_dfP.allocate(a1,a2,m_l1,m_l2);
+		m_nFirst.deallocate();
+		m_nFirst.allocate(a1,a2);
+		m_nLast.deallocate();
+		m_nLast.allocate(a1,a2);
+	}
+	m_dP = P;
+	m_dfP.initialize();
+	for(int i = a1; i <= a2; i++ )
+	{
+		int f = m_l1, l = m_l2;
+		while( f < l && P(i,f) <= m_dTol ) f++;
+		while( l > f && P(i,l) <= m_dTol ) l--;
+		if( P(i,f) <= m_dTol )
+		{
+			for(int j = m_l1; j <= m_l2; j++ )
+				if( P(i,j) > P(i,f) ) f = j;
+			l = f;
+		}
+		m_nFirst(i) = f;
+		m_nLast(i)  = l;
+	}
+}
+
+
+/*
+	Proportions at length for one age, with their derivatives with respect
+	to the mean and standard deviation.  With z_e = (x_e - mu)/sig at edge e
+	and q_j = Phi(z_hi) - Phi(z_lo),
+
+		d q_j / d mu  = -[phi(z_hi) - phi(z_lo)] / sig
+		d q_j / d sig = -[z_hi phi(z_hi) - z_lo phi(z_lo)] / sig
+
+	and p_j = q_j / sum(q), so d p_j = (d q_j - p_j sum(d q)) / sum(q).
+*/
+void age_length_key::evaluate(double mu, double sig, dvector& p, dvector& dmu, dvector& dsig) const
+{
+	int ne = m_dEdge.indexmax();
+	dvector cdf(1,ne);
+	dvector pdf(1,ne);
+	dvector z(1,ne);
+	for(int e = 1; e <= ne; e++ )
+	{
+		z(e)   = (m_dEdge(e) - mu) / sig;
+		cdf(e) = cumd_norm(z(e));
+		pdf(e) = 0.3989422804014327 * exp(-0.5 * z(e) * z(e));
+	}
+
+	double S = 0, Smu = 0, Ssig = 0;
+	for(int j = m_l1; j <= m_l2; j++ )
+	{
+		int lo = m_nLo(j), hi = m_nHi(j);
+		p(j)    = cdf(hi) - cdf(lo);
+		dmu(j)  = -(pdf(hi) - pdf(lo)) / sig;
+		dsig(j) = -(z(hi) * pdf(hi) - z(lo) * pdf(lo)) / sig;
+		S    += p(j);
+		Smu  += dmu(j);
+		Ssig += dsig(j);
+	}
+	p /= S;
+	for(int j = m_l1; j <= m_l2; j++ )
+	{
+		dmu(j)  = (dmu(j)  - p(j) * Smu)  / S;
+		dsig(j) = (dsig(j) - p(j) * Ssig) / S;
+	}
+}
+
+
+dmatrix age_length_key::key(const dvector& mu, const dvector& sig)
+{
+	int a1 = mu.indexmin(), a2 = mu.indexmax();
+	dmatrix P(a1,a2,m_l1,m_l2);
+	dvector dmu(m_l1,m_l2);
+	dvector dsig(m_l1,m_l2);
+	for(int i = a1; i <= a2; i++ )
+		evaluate(mu(i), sig(i), P(i), dmu, dsig);
+	set_band(P);
+	return(P);
+}
+
+
+/*
+	The key is evaluated in doubles and one adjoint is pushed onto the
+	gradient stack for the whole matrix.  Row i depends only on mu_i and
+	sig_i, so the adjoint is two dot products per age with the saved
+	partials.  The pointer to the key is saved for the derivatives that
+	transform(n,P) leaves in m_dfP.
+*/
+dvar_matrix age_length_key::key(const dvar_vector& mu, const dvar_vector& sig)
+{
+	RETURN_ARRAYS_INCREMENT();
+	int a1 = mu.indexmin(), a2 = mu.indexmax();
+	dmatrix P(a1,a2,m_l1,m_l2);
+	dmatrix dPdmu(a1,a2,m_l1,m_l2);
+	dmatrix dPdsig(a1,a2,m_l1,m_l2);
+	for(int i = a1; i <= a2; i++ )
+		evaluate(value(mu(i)), value(sig(i)), P(i), dPdmu(i), dPdsig(i));
+	set_band(P);
+
+	dvar_matrix vP = nograd_assign(P);
+
+	save_identifier_string("alk1");
+	save_pointer_value((void*)this);
+	mu.save_dvar_vector_position();
+	sig.save_dvar_vector_position();
+	dPdmu.save_dmatrix_value();
+	dPdmu.save_dmatrix_position();
+	dPdsig.save_dmatrix_value();
+	dPdsig.save_dmatrix_position();
+	vP.save_dvar_matrix_position();
+	save_identifier_string("alk2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dfkey);
+
+	RETURN_ARRAYS_DECREMENT();
+	return(vP);
+}
+
+/*
+	Adjoint of key: restores the saved partials (in reverse order of
+	saving) and contracts them with the derivatives of the key, those of
+	the key's own dvariables and those in m_dfP.  The transforms come
+	after the key, so their adjoints have all run; m_dfP is cleared for
+	the next evaluation.
+*/
+void age_length_key::dfkey(void)
+{
+	verify_identifier_string("alk2");
+	dvar_matrix_position Ppos     = restore_dvar_matrix_position();
+	dmatrix dfP                   = restore_dvar_matrix_derivatives(Ppos);
+	dmatrix_position dsigpos      = restore_dmatrix_position();
+	dmatrix dPdsig                = restore_dmatrix_value(dsigpos);
+	dmatrix_position dmupos       = restore_dmatrix_position();
+	dmatrix dPdmu                 = restore_dmatrix_value(dmupos);
+	dvar_vector_position sigpos   = restore_dvar_vector_position();
+	dvar_vector_position mupos    = restore_dvar_vector_position();
+	age_length_key* alk           = (age_length_key*)restore_pointer_value();
+	verify_identifier_string("alk1");
+
+	int a1 = dfP.rowmin(), a2 = dfP.rowmax();
+	dvector dfmu(a1,a2);
+	dvector dfsig(a1,a2);
+	for(int i = a1; i <= a2; i++ )
+	{
+		for(int j = alk->m_nFirst(i); j <= alk->m_nLast(i); j++ )
+		{
+			dfP(i,j) += alk->m_dfP(i,j);
+			alk->m_dfP(i,j) = 0;
+		}
+		dfmu(i)  = dfP(i) * dPdmu(i);
+		dfsig(i) = dfP(i) * dPdsig(i);
+	}
+	dfmu.save_dvector_derivatives(mupos);
+	dfsig.save_dvector_derivatives(sigpos);
+}
+
+
+/*
+	Numbers at length from numbers at age with the last key, summing over
+	the band of each age only.  The adjoint finds the key and its band
+	through the pointer saved on the gradient stack, so the key must not
+	change before the gradient is computed (it is set once per
+	evaluation, before the predictions).
+*/
+dvar_vector age_length_key::transform(const dvar_vector& n) const
+{
+	RETURN_ARRAYS_INCREMENT();
+	int a1 = n.indexmin(), a2 = n.indexmax();
+	dvector lc(m_l1,m_l2);
+	lc.initialize();
+	for(int i = a1; i <= a2; i++ )
+	{
+		double ni = value(n(i));
+		for(int j = m_nFirst(i); j <= m_nLast(i); j++ )
+			lc(j) += ni * m_dP(i,j);
+	}
+
+	dvar_vector vlc = nograd_assign(lc);
+
+	save_identifier_string("alkt1");
+	save_pointer_value((void*)this);
+	n.save_dvar_vector_position();
+	vlc.save_dvar_vector_position();
+	save_identifier_string("alkt2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dftransform);
+
+	RETURN_ARRAYS_DECREMENT();
+	return(vlc);
+}
+
+void age_length_key::dftransform(void)
+{
+	verify_identifier_string("alkt2");
+	dvar_vector_position lcpos    = restore_dvar_vector_position();
+	dvector dflc                  = restore_dvar_vector_derivatives(lcpos);
+	dvar_vector_position npos     = restore_dvar_vector_position();
+	const age_length_key* alk     = (const age_length_key*)restore_pointer_value();
+	verify_identifier_string("alkt1");
+
+	int a1 = npos.indexmin(), a2 = npos.indexmax();
+	dvector dfn(a1,a2);
+	for(int i = a1; i <= a2; i++ )
+	{
+		double d = 0;
+		for(int j = alk->m_nFirst(i); j <= alk->m_nLast(i); j++ )
+			d += dflc(j) * alk->m_dP(i,j);
+		dfn(i) = d;
+	}
+	dfn.save_dvector_derivatives(npos);
+}
+
+
+/*
+	As above, with the key estimated: P is the dvar_matrix returned by the
+	last key(), and the adjoint also adds d/dP = dflc(j) n(i), over the
+	band, to m_dfP, which the adjoint of that key() passes on.
+*/
+dvar_vector age_length_key::transform(const dvar_vector& n, const dvar_matrix& P) const
+{
+	RETURN_ARRAYS_INCREMENT();
+	int a1 = n.indexmin(), a2 = n.indexmax();
+	dvector nv = value(n);
+	dvector lc(m_l1,m_l2);
+	lc.initialize();
+	for(int i = a1; i <= a2; i++ )
+	{
+		for(int j = m_nFirst(i); j <= m_nLast(i); j++ )
+			lc(j) += nv(i) * m_dP(i,j);
+	}
+
+	dvar_vector vlc = nograd_assign(lc);
+
+	save_identifier_string("alkk1");
+	save_pointer_value((void*)this);
+	n.save_dvar_vector_position();
+	nv.save_dvector_value();
+	nv.save_dvector_position();
+	vlc.save_dvar_vector_position();
+	save_identifier_string("alkk2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dftransform_key);
+
+	RETURN_ARRAYS_DECREMENT();
+	return(vlc);
+}
+
+void age_length_key::dftransform_key(void)
+{
+	verify_identifier_string("alkk2");
+	dvar_vector_position lcpos    = restore_dvar_vector_position();
+	dvector dflc                  = restore_dvar_vector_derivatives(lcpos);
+	dvector_position nvpos        = restore_dvector_position();
+	dvector nv                    = restore_dvector_value(nvpos);
+	dvar_vector_position npos     = restore_dvar_vector_position();
+	const age_length_key* alk     = (const age_length_key*)restore_pointer_value();
+	verify_identifier_string("alkk1");
+
+	int a1 = npos.indexmin(), a2 = npos.indexmax();
+	dvector dfn(a1,a2);
+	for(int i = a1; i <= a2; i++ )
+	{
+		double d = 0;
+		for(int j = alk->m_nFirst(i); j <= alk->m_nLast(i); j++ )
+		{
+			d               += dflc(j) * alk->m_dP(i,j);
+			alk->m_dfP(i,j) += dflc(j) * nv(i);
+		}
+		dfn(i) = d;
+	}
+	dfn.save_dvector_derivatives(npos);
+}
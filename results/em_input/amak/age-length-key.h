@@ -0,0 +1,72 @@
+/**
+	This is a class for the age-length key, the matrix of proportions at
+	length for each age, from normal lengths at age.
+
+	The bin edges are set once from the length bins, and an edge shared by
+	two adjacent bins is evaluated once (one normal CDF per edge and age,
+	rather than two per bin).  key() returns the key in doubles, for when
+	the growth parameters are fixed, or as a dvar_matrix with a single
+	adjoint for the whole matrix, from the analytic derivatives of the
+	normal CDF, for when they are estimated.
+
+	The key is banded: each age only has mass within a few standard
+	deviations of its mean length.  key() keeps the values of the last key
+	and, for each age, the first and last bin with a proportion above the
+	tolerance.  transform() converts numbers at age to numbers at length
+	over those bins only, in the forward pass and in its adjoint.  With
+	the key estimated, the adjoint of transform() adds its derivatives
+	with respect to the key, over the band, to an adjoint buffer of the
+	key kept here; the adjoint of key() takes them from there, so no full
+	matrix of derivatives is saved for each transform.
+*/
+
+#include <admodel.h>
+
+#ifndef AGE_LENGTH_KEY_H
+#define AGE_LENGTH_KEY_H
+
+class age_length_key
+{
+private:
+	int         m_l1;
+	int         m_l2;
+
+	dvector     m_dEdge;	// Distinct bin edges, in increasing order.
+	ivector     m_nLo;		// Edge number of the lower edge of each bin.
+	ivector     m_nHi;		// Edge number of the upper edge of each bin.
+
+	double      m_dTol;		// Proportions at or below this are outside the band.
+	dmatrix     m_dP;		// Last key.
+	ivector     m_nFirst;	// First bin of the band for each age.
+	ivector     m_nLast;	// Last bin of the band for each age.
+	mutable dmatrix m_dfP;	// Adjoint of the last key, from transform(n,P), over the band.
+
+	void evaluate(double mu, double sig, dvector& p, dvector& dmu, dvector& dsig) const;
+	void set_band(const dmatrix& P);
+
+	static void dfkey(void);
+	static void dftransform(void);
+	static void dftransform_key(void);
+
+public:
+	~age_length_key();
+	age_length_key();
+	age_length_key(const dvector& _len_bins);
+
+	/* setters */
+	void set_bins(const dvector& _len_bins);
+	void set_tolerance(double _tol);
+
+	int  nedges() const;
+	int  band_width(int age) const;
+
+	dmatrix     key(const dvector& mu, const dvector& sig);
+	dvar_matrix key(const dvar_vector& mu, const dvar_vector& sig);
+
+	/* numbers at length from numbers at age, with the last key */
+	dvar_vector transform(const dvar_vector& n) const;
+	dvar_vector transform(const dvar_vector& n, const dvar_matrix& P) const;
+};
+
+
+#endif
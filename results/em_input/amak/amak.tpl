@@ -66,16 +66,22 @@ DATA_SECTION
   !!CLASS ofstream mceval_srv("mceval_srv.dat")
   !!CLASS ofstream mceval_M("mceval_M.dat")
   !!CLASS ofstream mceval_proj("mceval_proj.dat")
-  !!long int lseed=iseed;
-  !!CLASS random_number_generator rng(iseed);
   
   int oper_mod
+  int use_hcr // in-process harvest control rules in the operating model (-hcr)
+  int n_threads // threads for the in-process HCR replicates and mceval projections (-nthreads)
   int mcmcmode
   int mcflag
+  int retro_opt // retro years to peel off from the command line (-retro), -1 if not given
+  int write_wst // 1 = write the fitted parameters to the warm start file at the end, 0 after -mcmc or -mceval
 
   !! oper_mod = 0;
+  !! use_hcr  = 0;
+  !! n_threads = 1;
   !! mcmcmode = 0;
   !! mcflag   = 1;
+  !! retro_opt = -1;
+  !! write_wst = (option_match(argc,argv,"-mcmc") > -1 || option_match(argc,argv,"-mceval") > -1) ? 0 : 1;
  LOCAL_CALCS
   write_input_log<<version_info<<endl;
   tmpstring=adprogram_name + adstring(".dat");
@@ -102,10 +108,71 @@ DATA_SECTION
     cmp_no = atoi(argv[on+1]);
     cout<<"Got to operating model option "<<oper_mod<<endl;
   }
+  if ( (on=option_match(argc,argv,"-hcr"))>-1)
+  {
+    use_hcr = 1;
+    cout<<"In-process harvest control rules in the operating model"<<endl;
+  }
+  if ( (on=option_match(argc,argv,"-iseed"))>-1)
+  {
+    iseed = atoi(argv[on+1]);
+    cout<<"Seed for simulated data "<<iseed<<endl;
+  }
+  if ( (on=option_match(argc,argv,"-nthreads"))>-1)
+  {
+    n_threads = (on+1<argc) ? atoi(argv[on+1]) : 0;
+    if (n_threads<1)
+    {
+      cerr<<"-nthreads needs a number of threads of at least 1 -- using 1"<<endl;
+      n_threads = 1;
+    }
+    cout<<"Operating model replicates and projections on "<<n_threads<<" threads"<<endl;
+  }
   if ( (on=option_match(argc,argv,"-mcmc"))>-1)
   {
     mcmcmode = 1;
   }
+  if ( (on=option_match(argc,argv,"-scen"))>-1)
+  {
+    if (on>argc-2 | argv[on+1][0] == '-') 
+    { 
+      cerr << "Invalid projection scenario file command line option"
+         " -- ignored" << endl;  
+    }
+    else
+    {
+      scenfile_name = adstring(argv[on+1]);
+      cout<<"Projection scenarios from "<<scenfile_name<<endl;
+    }
+  }
+  if ( (on=option_match(argc,argv,"-retro"))>-1)
+  {
+    retro_opt = atoi(argv[on+1]);
+    cout<<"Retrospective peel of "<<retro_opt<<" years"<<endl;
+  }
+  if ( (on=option_match(argc,argv,"-wst"))>-1)
+  {
+    if (on>argc-2 | argv[on+1][0] == '-') 
+    { 
+      cerr << "Invalid warm start file command line option"
+         " -- ignored" << endl;  
+    }
+    else
+    {
+      wstfile_name = adstring(argv[on+1]);
+      cout<<"Warm start from "<<wstfile_name<<endl;
+    }
+  }
+  if ( (on=option_match(argc,argv,"-rtab"))>-1)
+  {
+    if (on>argc-2 | argv[on+1][0] == '-') 
+    { 
+      cerr << "Invalid retrospective table command line option"
+         " -- ignored" << endl;  
+    }
+    else
+      rtabfile_name = adstring(argv[on+1]);
+  }
   global_datafile= new cifstream(cntrlfile_name);
   if (!global_datafile)
   {
@@ -139,6 +206,7 @@ DATA_SECTION
 
   int nages
   !!  nages = oldest_age - rec_age + 1;
+  !! alk.set_bins(len_bins);
   int styr_rec
   int styr_sp
   int endyr_sp
@@ -331,6 +399,7 @@ DATA_SECTION
   init_int use_age_err      // nonzero value means use...
   !! log_input(use_age_err);
   init_int retro            // Retro years to peel off (0 means full dataset)
+  !! if (retro_opt>=0) retro = retro_opt;
   !! log_input(retro);
   init_number steepnessprior
   init_number cvsteepnessprior
@@ -457,6 +526,49 @@ DATA_SECTION
   number catchbiomass_pen
   !!catchbiomass_pen= 1./(2*cv_catchbiomass*cv_catchbiomass);
   init_int nproj_yrs
+  // Projection scenario table (Future_projections), from the file given with -scen:
+  //   number of scenarios, then one row per scenario: type value, with type
+  //   1 = multiple of the terminal-year F, 2 = fraction of Fmsy, 3 = fixed catch (biomass)
+  // Without -scen: 1, 0.75, 0.5, 0.25 and 0 times the terminal-year F
+  int nscen_proj
+ LOCAL_CALCS
+  nscen_proj = 5;
+  if (length(scenfile_name)>0)
+  {
+    cifstream scenin(scenfile_name);
+    if (!scenin)
+    {
+      cerr<<"Cannot open projection scenario file "<<scenfile_name<<endl;
+      exit(1);
+    }
+    scenin >> nscen_proj;
+  }
+ END_CALCS
+  ivector type_proj(1,nscen_proj)
+  vector val_proj(1,nscen_proj)
+ LOCAL_CALCS
+  type_proj = PROJ_FMULT;
+  if (length(scenfile_name)==0)
+    val_proj.fill("{1.0,0.75,0.5,0.25,0.0}");
+  else
+  {
+    cifstream scenin(scenfile_name);
+    int ntmp;
+    scenin >> ntmp;
+    for (int is=1;is<=nscen_proj;is++)
+    {
+      scenin >> type_proj(is) >> val_proj(is);
+      if (type_proj(is)<PROJ_FMULT || type_proj(is)>PROJ_CATCH)
+      {
+        cerr<<"Projection scenario "<<is<<" has unknown type "<<type_proj(is)<<endl;
+        exit(1);
+      }
+    }
+  }
+  log_input(nscen_proj);
+  log_input(type_proj);
+  log_input(val_proj);
+ END_CALCS
 
   int styr_fut
   int endyr_fut            // LAst year for projections
@@ -1105,6 +1217,45 @@ DATA_SECTION
   obs_lva_ind = square(obs_lse_ind);
  END_CALCS
 
+  // Year->observation maps for the index predictions: each distinct year with an
+  // index value, age or length composition has one mid-survey abundance vector
+  ivector nyrs_ind_abund(1,nind)
+  imatrix slot_ind_yr(1,nind,styr,endyr)
+ LOCAL_CALCS
+  slot_ind_yr.initialize();
+  nyrs_ind_abund.initialize();
+  for (int k=1;k<=nind;k++)
+  {
+    for (int i=1;i<=nyrs_ind(k);i++)
+      slot_ind_yr(k,yrs_ind(k,i)) = 1;
+    for (int i=1;i<=nyrs_ind_age(k);i++)
+      slot_ind_yr(k,yrs_ind_age(k,i)) = 1;
+    for (int i=1;i<=nyrs_ind_length(k);i++)
+      slot_ind_yr(k,yrs_ind_length(k,i)) = 1;
+    for (int iyr=styr;iyr<=endyr;iyr++)
+      if (slot_ind_yr(k,iyr))
+        slot_ind_yr(k,iyr) = ++nyrs_ind_abund(k);
+  }
+ END_CALCS
+  imatrix yrs_ind_abund(1,nind,1,nyrs_ind_abund)
+  imatrix slot_ind(1,nind,1,nyrs_ind)
+  imatrix slot_ind_age(1,nind,1,nyrs_ind_age)
+  imatrix slot_ind_length(1,nind,1,nyrs_ind_length)
+ LOCAL_CALCS
+  for (int k=1;k<=nind;k++)
+  {
+    for (int iyr=styr;iyr<=endyr;iyr++)
+      if (slot_ind_yr(k,iyr))
+        yrs_ind_abund(k,slot_ind_yr(k,iyr)) = iyr;
+    for (int i=1;i<=nyrs_ind(k);i++)
+      slot_ind(k,i) = slot_ind_yr(k,yrs_ind(k,i));
+    for (int i=1;i<=nyrs_ind_age(k);i++)
+      slot_ind_age(k,i) = slot_ind_yr(k,yrs_ind_age(k,i));
+    for (int i=1;i<=nyrs_ind_length(k);i++)
+      slot_ind_length(k,i) = slot_ind_yr(k,yrs_ind_length(k,i));
+  }
+ END_CALCS
+
   ////////////////////////////////////////////////////////////////////////////////////
  LOCAL_CALCS
   for (k=1; k<=nfsh;k++)
@@ -1150,6 +1301,24 @@ DATA_SECTION
 
   int do_fmort;
   !! do_fmort=0;
+  int do_logistic_normal; // 1 = -ln or -lnar1 on command line: logistic-normal composition likelihood
+  !! do_logistic_normal=0;
+  int phase_tau;          // tau is estimated only with the logistic normal
+  !! phase_tau=-3;
+  int phase_rho_ln;       // AR(1) correlation across bins, estimated only with -lnar1
+  !! phase_rho_ln=-4;
+  ivector ln_src_fsh_age(1,nfsh)     // logistic normal engine source for each composition (0 = none)
+  ivector ln_src_fsh_length(1,nfsh)
+  ivector ln_src_ind_age(1,nind)
+  ivector ln_src_ind_length(1,nind)
+  int do_dirichlet_multinomial; // 1 = -dm on command line: Dirichlet-multinomial composition likelihood
+  !! do_dirichlet_multinomial=0;
+  int phase_dm;           // log theta of the Dirichlet-multinomial, estimated only with -dm
+  !! phase_dm=-3;
+  int msy_iter;           // Newton iterations of the last Fmsy search (get_msy)
+  !! msy_iter=0;
+  ivector spr_iter(1,3)   // Newton iterations of the F35%, F50% and F40% searches (get_spr_rates)
+  !! spr_iter.initialize();
   int Popes;
  LOCAL_CALCS
   Popes=0; // option to do Pope's approximation (not presently flagged outside of code)
@@ -1200,6 +1369,27 @@ DATA_SECTION
     int on=0;
     if ( (on=option_match(ad_comm::argc,ad_comm::argv,"-uFmort"))>-1)
       do_fmort=1;
+    if ( (on=option_match(ad_comm::argc,ad_comm::argv,"-ln"))>-1)
+    {
+      do_logistic_normal=1;
+      phase_tau=3;
+    }
+    if ( (on=option_match(ad_comm::argc,ad_comm::argv,"-lnar1"))>-1)
+    {
+      do_logistic_normal=1;
+      phase_tau=3;
+      phase_rho_ln=4;
+    }
+    if ( (on=option_match(ad_comm::argc,ad_comm::argv,"-dm"))>-1)
+    {
+      do_dirichlet_multinomial=1;
+      phase_dm=3;
+    }
+    if (do_logistic_normal && do_dirichlet_multinomial)
+    {
+      cerr<<"-ln or -lnar1 and -dm choose different composition likelihoods -- use only one"<<endl;
+      exit(1);
+    }
   }
 
   // Compute an initial Rzero value based on exploitation 
@@ -1222,7 +1412,7 @@ DATA_SECTION
 
 PARAMETER_SECTION
  // Biological Parameters
-  init_bounded_number tau(0.01,3.,-3)
+  init_bounded_number tau(0.01,3.,phase_tau)
   init_bounded_number Mest(.02,4.8,phase_M)
   init_bounded_vector Mage_offset(1,npars_Mage,-3,3,phase_Mage)
   vector Mage(1,nages)
@@ -1328,7 +1518,6 @@ PARAMETER_SECTION
 
  // Stuff for SPR and yield projections
   number sigmar_fut
-  vector f_tmp(1,nfsh)
   number SB0
   number SBF50
   number SBF40
@@ -1343,9 +1532,6 @@ PARAMETER_SECTION
 
   init_vector rec_dev_future(styr_fut,endyr_fut,phase_proj);
   vector Sp_Biom_future(styr_fut-rec_age,endyr_fut);
-  3darray F_future(1,nfsh,styr_fut,endyr_fut,1,nages);
-  matrix Z_future(styr_fut,endyr_fut,1,nages);
-  matrix S_future(styr_fut,endyr_fut,1,nages);
   matrix catage_future(styr_fut,endyr_fut,1,nages);
   number avg_rec_dev_future
   vector avg_F_future(1,5)
@@ -1377,6 +1563,7 @@ PARAMETER_SECTION
 
   matrix pred_ind(1,nind,1,nyrs_ind)
   3darray eac_ind(1,nind,1,nyrs_ind_age,1,nages)
+  3darray ind_abund(1,nind,1,nyrs_ind_abund,1,nages) // mid-survey abundance by year (see slot_ind)
 
  // Likelihood value names         
   number sigma
@@ -1398,6 +1585,12 @@ PARAMETER_SECTION
   objective_function_value obj_fun
   vector obj_comps(1,14)
   init_number repl_F(5)
+  // Parameters added after repl_F, so existing .pin and .par files keep their order
+  // AR(1) correlation of the logistic-normal residuals
+  init_bounded_number rho_ln(-0.99,0.99,phase_rho_ln)
+  // Dirichlet-multinomial log theta, one per fishery and index (shared by its age and length compositions)
+  init_bounded_vector log_dm_theta_fsh(1,nfsh,-10.,10.,phase_dm)
+  init_bounded_vector log_dm_theta_ind(1,nind,-10.,10.,phase_dm)
 
   sdreport_number repl_yld
   sdreport_number repl_SSB
@@ -1429,8 +1622,9 @@ PARAMETER_SECTION
   sdreport_vector pred_ind_nextyr(1,nind);
   sdreport_number OFL;
   // NOTE TO DAVE: Need to have a phase switch for sdreport variables(
-  matrix catch_future(1,4,styr_fut,endyr_fut); // Note, don't project for F=0 (it will bomb)
-  sdreport_matrix SSB_fut(1,5,styr_fut,endyr_fut)
+  matrix catch_future(1,nscen_proj,styr_fut,endyr_fut);
+  matrix rec_future(1,nscen_proj,styr_fut,endyr_fut);
+  sdreport_matrix SSB_fut(1,nscen_proj,styr_fut,endyr_fut)
   !! write_input_log <<"logRzero "<<log_Rzero<<endl;
   !! write_input_log <<"logmeanrec "<<mean_log_rec<<endl;
   !! write_input_log<< "exp(log_sigmarprior "<<exp(log_sigmarprior)<<endl;
@@ -1545,11 +1739,63 @@ PARAMETER_SECTION
 
 PRELIMINARY_CALCS_SECTION
   tau=0.2;
+  rho_ln=0.;
+  ln_src_fsh_age.initialize();
+  ln_src_fsh_length.initialize();
+  ln_src_ind_age.initialize();
+  ln_src_ind_length.initialize();
+  if (do_logistic_normal)
+  {
+    // Data-only part of the logistic normal (bin pooling, observed log ratios), done once
+    // for every composition source; Age_Like only gathers the expected values each evaluation
+    for (k=1;k<=nfsh;k++)
+    {
+      if (nyrs_fsh_age(k)>0)    ln_src_fsh_age(k)    = ln_engine.add_source(oac_fsh(k));
+      if (nyrs_fsh_length(k)>0) ln_src_fsh_length(k) = ln_engine.add_source(olc_fsh(k));
+    }
+    for (k=1;k<=nind;k++)
+    {
+      if (nyrs_ind_age(k)>0)    ln_src_ind_age(k)    = ln_engine.add_source(oac_ind(k));
+      if (nyrs_ind_length(k)>0) ln_src_ind_length(k) = ln_engine.add_source(olc_ind(k));
+    }
+  }
+  if (do_dirichlet_multinomial)
+  {
+    // Data-only lgamma terms of the Dirichlet-multinomial, computed once
+    for (k=1;k<=nfsh;k++)
+    {
+      dm_fsh_age.push_back(nyrs_fsh_age(k)>0 ? 
+                 dirichlet_multinomial(oac_fsh(k),n_sample_fsh_age(k)) : dirichlet_multinomial());
+      dm_fsh_length.push_back(nyrs_fsh_length(k)>0 ? 
+                 dirichlet_multinomial(olc_fsh(k),n_sample_fsh_length(k)) : dirichlet_multinomial());
+    }
+    for (k=1;k<=nind;k++)
+    {
+      dm_ind_age.push_back(nyrs_ind_age(k)>0 ? 
+                 dirichlet_multinomial(oac_ind(k),n_sample_ind_age(k)) : dirichlet_multinomial());
+      dm_ind_length.push_back(nyrs_ind_length(k)>0 ? 
+                 dirichlet_multinomial(olc_ind(k),n_sample_ind_length(k)) : dirichlet_multinomial());
+    }
+  }
+  // Initial values first, then the warm start, so that M and the age-length key below are
+  // built from the restored parameters
+  if (npars_Mage>0)
+    Mage_offset = Mage_offset_in;
+  if (length(wstfile_name)>0)
+  {
+    // warm start from a previous fit, matched by label and year (see warm-start.h)
+    if (wst.read(wstfile_name)>0)
+    {
+      warm_start_items();
+      write_input_log<<"# Warm start from "<<wstfile_name<<": "<<wst.nrestored()<<" values"<<endl;
+    }
+    else
+      cerr<<"No warm start values in "<<wstfile_name<<" -- ignored"<<endl;
+  }
   // Initialize age-specific changes in M if they are specified
   M(styr) = Mest;
   if (npars_Mage>0)
   {
-    Mage_offset = Mage_offset_in;
     int jj=1;
     for (j=1;j<=nages;j++)
     {
@@ -1616,7 +1862,7 @@ PROCEDURE_SECTION
   }
 
   // Main model calcs---------------------
-  if(active(log_Linf)||active(log_k)||active(log_sdage))
+  if (growth_active())
     Get_Age2length();
   Get_Selectivity();
   Get_Mortality();
@@ -1677,7 +1923,7 @@ FUNCTION write_mceval
       else
         mceval_sr << "curve "<<stock <<" 99 "<<endl;
     }
-    for (k=1;k<=5;k+=4)
+    for (k=1;k<=nscen_proj;k+=(nscen_proj>1 ? nscen_proj-1 : 1)) // first and last scenarios
 		{
       for (i=styr_fut;i<=endyr_fut;i++)
 		  {
@@ -1700,21 +1946,11 @@ FUNCTION write_mceval
       mceval_sr   <<"est "<< Sp_Biom(i-rec_age-1)<<" "<<natage(i,1)<< endl;
       mceval_M<<i <<" "<< M(i,2) <<" "<<M(i,4)<<endl;
     }
-		dvariable Rtmp;
-    for (k=1;k<=5;k++)
-		{
-      for (i=styr_fut;i<=endyr_fut;i++)
-		  {
-		   if (int(i-rec_age)<styr_fut)
-        Rtmp = natage(i-rec_age,1) ;     
-		   else
-        Rtmp = SRecruit( SSB_fut(k,i-rec_age) ) * mfexp(rec_dev_future(i)) ;     
-				if (k!=5)
-          mceval_proj<<mc_count<<" "<<k<<" "<<i <<" "<<SSB_fut(k,i)<<" "<<catch_future(k,i)<<" "<< Rtmp <<endl;
-				else
-          mceval_proj<<mc_count<<" "<<k<<" "<<i <<" "<<SSB_fut(k,i)<<" 0 "<< Rtmp <<endl;
-      }
-    }
+    // one line per draw: for each scenario, SSB, catch and recruits by projection year
+    mceval_proj<<mc_count;
+    for (k=1;k<=nscen_proj;k++)
+      mceval_proj<<" "<<SSB_fut(k)<<" "<<catch_future(k)<<" "<<rec_future(k);
+    mceval_proj<<endl;
     
   // styr_sp  = styr_rec - rec_age - 1 ;    // First year of spawning biomass  
   //sdreport_vector recruits(styr,endyr+1)
@@ -1743,16 +1979,13 @@ FUNCTION write_mceval
   ABCBiom   << " "<< 
   F35       << " "<<
   F40       << " "<<
-  F50       << " "<<
-  SSB_fut(1,endyr_fut) << " "<< 
-  SSB_fut(2,endyr_fut) << " "<< 
-  SSB_fut(3,endyr_fut) << " "<< 
-  SSB_fut(4,endyr_fut) << " "<< 
-  SSB_fut(5,endyr_fut) << " "<< 
-  catch_future(1,styr_fut)    << " "<<  
-  catch_future(2,styr_fut)    << " "<<  
-  catch_future(3,styr_fut)    << " "<<  
-  catch_future(4,styr_fut)    << " "<<  endl;
+  F50       << " ";
+  for (k=1;k<=nscen_proj;k++)
+    mceval<< SSB_fut(k,endyr_fut) << " ";
+  for (k=1;k<=nscen_proj;k++)
+    if (val_proj(k)>0)
+      mceval<< catch_future(k,styr_fut) << " ";
+  mceval<< endl;
 
 
 //-----TRANSFORMATION FUNCION AGE->LENGTH--------------------------------------------------
@@ -1776,32 +2009,20 @@ FUNCTION Get_Age2length
   for (i=2;i<=nages;i++)
     mu_age(i) = Linf*(1.-exp(-k_coeff))+exp(-k_coeff)*mu_age(i-1); // the mean length by age group
   sigma_age=sdage*mu_age; // standard deviation of length-at-age
-  P_age2len = ALK( mu_age, sigma_age, len_bins);
+  if (growth_active())
+    P_age2len = alk.key(mu_age, sigma_age);
+  else
+    P_age2len = alk.key(value(mu_age), value(sigma_age));
 
-FUNCTION dvar_matrix ALK(dvar_vector& mu, dvar_vector& sig, dvector& x)
-  //RETURN_ARRAYS_INCREMENT();
-  int i, j;
-  dvariable z1;
-  dvariable z2;
-  int si,ni; si=mu.indexmin(); ni=mu.indexmax();
-  int sj,nj; sj=x.indexmin(); nj=x.indexmax();
-  dvar_matrix pdf(si,ni,sj,nj);
-  double xs;
-  pdf.initialize();
-  for(i=si;i<=ni;i++) //loop over ages
-  {
-    for(j=sj;j<=nj;j++) //loop over length bins
-    {
-      if (j<nj)
-        xs=0.5*(x[sj+1]-x[sj]);  // accounts for variable bin-widths...?
-      z1=((x(j)-xs)-mu(i))/sig(i);
-      z2=((x(j)+xs)-mu(i))/sig(i);
-      pdf(i,j)=cumd_norm(z2)-cumd_norm(z1);
-    }//end nbins
-    pdf(i)/=sum(pdf(i));
-  }//end nage
-  //RETURN_ARRAYS_DECREMENT();
-  return(pdf);
+FUNCTION int growth_active()
+  return(active(log_Linf)||active(log_k)||active(log_Lo)||active(log_sdage));
+
+FUNCTION dvar_vector age2len(const dvar_vector& n)
+  // length composition from numbers at age, over the band of the key for each age;
+  // the key is a constant while growth is fixed
+  if (growth_active())
+    return(alk.transform(n,P_age2len));
+  return(alk.transform(n));
 
 //---------------------------------------------------------------------------
 
@@ -2157,30 +2378,31 @@ FUNCTION Get_Survey_Predictions
       for (iyr=ii+1;iyr<=nyrs_ind(k);iyr++)
         q_ind(k,iyr)  = q_ind(k,ii);
     }
+    // Mid-survey abundance, computed once for each year with index, age or length data
+    for (i=1;i<=nyrs_ind_abund(k);i++)
+    {        
+      iyr = yrs_ind_abund(k,i);
+      ind_abund(k,i) = elem_prod(pow(S(iyr),ind_month_frac(k)),elem_prod(sel_ind(k,iyr),natage(iyr)));  
+    }
     for (i=1;i<=nyrs_ind(k);i++)
     {        
       iyr=yrs_ind(k,i);
-      pred_ind(k,i) = q_ind(k,i) * pow(elem_prod(natage(iyr),pow(S(iyr),ind_month_frac(k))) * 
-                                     elem_prod(sel_ind(k,iyr) , wt_ind(k,iyr)),q_power_ind(k));
+      pred_ind(k,i) = q_ind(k,i) * pow(ind_abund(k,slot_ind(k,i)) * wt_ind(k,iyr),q_power_ind(k));
     }
     for (i=1;i<=nyrs_ind_age(k);i++)
     {        
-      iyr = yrs_ind_age(k,i); 
-      dvar_vector tmp_n   = elem_prod(pow(S(iyr),ind_month_frac(k)),elem_prod(sel_ind(k,iyr),natage(iyr)));  
+      dvar_vector& tmp_n  = ind_abund(k,slot_ind_age(k,i));
       sum_tmp             = sum(tmp_n);
       if (use_age_err)
         eac_ind(k,i)      = age_err * tmp_n/sum_tmp;
       else
         eac_ind(k,i)      = tmp_n/sum_tmp;
     }
-    dvar_vector tmp_n(1,nages);
     for (i=1;i<=nyrs_ind_length(k);i++)
     {        
-      iyr          = yrs_ind_length(k,i); 
-      tmp_n        = elem_prod(pow(S(iyr),ind_month_frac(k)),elem_prod(sel_ind(k,iyr),natage(iyr)));  
+      dvar_vector& tmp_n  = ind_abund(k,slot_ind_length(k,i));
       sum_tmp      = sum(tmp_n);
-      tmp_n       /= sum_tmp;
-      elc_ind(k,i) = tmp_n * P_age2len ;
+      elc_ind(k,i) = age2len(tmp_n)/sum_tmp;
     }
     iyr=yrs_ind(k,nyrs_ind(k));
     dvar_vector natagetmp = elem_prod(S(endyr),natage(endyr));
@@ -2197,17 +2419,18 @@ FUNCTION Get_Fishery_Predictions
   {
     for (i=1; i<=nyrs_fsh_age(k); i++)
     {
+      dvar_vector& cat_tmp = catage(k,yrs_fsh_age(k,i));
       if (use_age_err)
-        eac_fsh(k,i) = age_err * catage(k,yrs_fsh_age(k,i))/sum(catage(k,yrs_fsh_age(k,i)));
+        eac_fsh(k,i) = age_err * cat_tmp;
       else
-        eac_fsh(k,i) = catage(k,yrs_fsh_age(k,i))/sum(catage(k,yrs_fsh_age(k,i)));
+        eac_fsh(k,i) = cat_tmp;
       eac_fsh(k,i) /= sum(eac_fsh(k,i));
     }
 
  // predicted length compositions !!
     for (i=1; i<=nyrs_fsh_length(k); i++)
     {
-      elc_fsh(k,i) = catage(k,yrs_fsh_length(k,i))*P_age2len;
+      elc_fsh(k,i) = age2len(catage(k,yrs_fsh_length(k,i)));
       elc_fsh(k,i) /= sum(elc_fsh(k,i));
     }
   }
@@ -2601,46 +2824,75 @@ FUNCTION Srv_Like
 
 FUNCTION Age_Like
   age_like_fsh.initialize();
-	dvariable nsamtheta;
+  length_like_fsh.initialize();
+  length_like_ind.initialize();
+  age_like_ind.initialize();
+	dvariable dm_theta;
+  if (do_logistic_normal)
+  {
+    // logistic normal for every composition source in one batched call (one adjoint for all),
+    // variance tau and AR(1) correlation rho_ln shared by all sources
+    for (k=1;k<=nfsh;k++)
+    {
+      if (ln_src_fsh_age(k))    ln_engine.set_expected(ln_src_fsh_age(k),eac_fsh(k));
+      if (ln_src_fsh_length(k)) ln_engine.set_expected(ln_src_fsh_length(k),elc_fsh(k));
+    }
+    for (k=1;k<=nind;k++)
+    {
+      if (ln_src_ind_age(k))    ln_engine.set_expected(ln_src_ind_age(k),eac_ind(k));
+      if (ln_src_ind_length(k)) ln_engine.set_expected(ln_src_ind_length(k),elc_ind(k));
+    }
+    if (ln_engine.sources()>0)
+    {
+      dvar_vector ln_nll = ln_engine.negative_loglikelihood(tau,rho_ln);
+      for (k=1;k<=nfsh;k++)
+      {
+        if (ln_src_fsh_age(k))    age_like_fsh(k)    = ln_nll(ln_src_fsh_age(k));
+        if (ln_src_fsh_length(k)) length_like_fsh(k) = ln_nll(ln_src_fsh_length(k));
+      }
+      for (k=1;k<=nind;k++)
+      {
+        if (ln_src_ind_age(k))    age_like_ind(k)    = ln_nll(ln_src_ind_age(k));
+        if (ln_src_ind_length(k)) length_like_ind(k) = ln_nll(ln_src_ind_length(k));
+      }
+    }
+    return;
+  }
+  if (do_dirichlet_multinomial)
+  {
+    // Dirichlet-multinomial (linear parameterization), theta = exp(log_dm_theta) per fishery/index;
+    // data-only lgamma terms cached in PRELIMINARY_CALCS, one adjoint per composition matrix
+    for (k=1;k<=nfsh;k++)
+    {
+      dm_theta = mfexp(log_dm_theta_fsh(k));
+      if (nyrs_fsh_age(k)>0)    age_like_fsh(k)    = dm_fsh_age[k-1].negative_loglikelihood(eac_fsh(k),dm_theta);
+      if (nyrs_fsh_length(k)>0) length_like_fsh(k) = dm_fsh_length[k-1].negative_loglikelihood(elc_fsh(k),dm_theta);
+    }
+    for (k=1;k<=nind;k++)
+    {
+      dm_theta = mfexp(log_dm_theta_ind(k));
+      if (nyrs_ind_age(k)>0)    age_like_ind(k)    = dm_ind_age[k-1].negative_loglikelihood(eac_ind(k),dm_theta);
+      if (nyrs_ind_length(k)>0) length_like_ind(k) = dm_ind_length[k-1].negative_loglikelihood(elc_ind(k),dm_theta);
+    }
+    return;
+  }
+
   for (k=1;k<=nfsh;k++)
     for (int i=1;i<=nyrs_fsh_age(k);i++)
       age_like_fsh(k) -= n_sample_fsh_age(k,i)*(oac_fsh(k,i) + 0.001) * log(eac_fsh(k,i) + 0.001 ) ;
   age_like_fsh -= offset_fsh;
-  /*
-  logistic_normal cMyAgeComp(oac_fsh(1),eac_fsh(1));
-  age_like_fsh = cMyAgeComp.negative_loglikelihood(tau);
-        // dirichlet-multinomial
-  for (k=1;k<=nfsh;k++)
-    for (int i=1;i<=nyrs_fsh_age(k);i++)
-		{
-			 nsamtheta = n_sample_fsh_age(k,i)*theta ;
-       age_like_fsh(k) -= lgamma( nsamtheta );
-       age_like_fsh(k) += lgamma( n_sample_fsh_age(k,i) + nsamtheta );
-       for(j=1; j<=nages; j++)
-			 {
-         age_like_fsh(k) -= lgamma( AgeComp_at(AgeI,YearI) + 
-				            theta*n_samp(YearI)*(Cn_at(AgeI,YearI)/tmp_sum*0.9999 + 0.0001/(AgeMax+1)) );
-         age_like_fsh(k) += lgamma( theta*n_samp(YearI)*(Cn_at(AgeI,YearI)/tmp_sum*0.9999 + 0.0001/(AgeMax+1)) );
-       }
-       n_effective(YearI) = 1/(1+theta) + n_samp(YearI)*(theta/(1+theta));
-     }
-	
-  */
 
 //-----------------------------------NEW-----------------------
-  length_like_fsh.initialize();
   for (k=1;k<=nfsh;k++)
     for (int i=1;i<=nyrs_fsh_length(k);i++)
       length_like_fsh(k) -= n_sample_fsh_length(k,i)*(olc_fsh(k,i) + 0.001) * log(elc_fsh(k,i) + 0.001 ) ;
   length_like_fsh -= offset_lfsh;
 //----------------------------------------------------------
-  length_like_ind.initialize();
   for (k=1;k<=nind;k++)
     for (int i=1;i<=nyrs_ind_length(k);i++)
       length_like_ind(k) -= n_sample_ind_length(k,i)*(olc_ind(k,i) + 0.001) * log(elc_ind(k,i) + 0.001 ) ;
   length_like_ind -= offset_lind;
 //----------------------------------------------------------
-  age_like_ind.initialize();
   for (k=1;k<=nind;k++)
     for (int i=1;i<=nyrs_ind_age(k);i++)
       age_like_ind(k) -= n_sample_ind_age(k,i)*(oac_ind(k,i) + 0.001) * log(eac_ind(k,i) + 0.001 ) ;
@@ -2652,94 +2904,114 @@ FUNCTION Oper_Model
   get_msy();
   Write_SimDatafile();
   Write_Datafile();
-  dmatrix new_ind(1,nind,1,nyrs_ind);
-  new_ind.initialize();
 
   int nsims;
   ifstream sim_in("nsims.dat");
   sim_in >> nsims; sim_in.close();
 
-  dvector ran_ind_vect(1,nind);
   ofstream SaveOM("Om_Out.dat",ios::app);
-  double C_tmp;
-  dvariable Fnow;
+  // The simulations are value-only: the projection runs in doubles (oper_proj<double>),
+  // so nothing goes on the gradient stack however large nsims is
+  oper_proj<double> om;
+  {
+    dmatrix sel_tmp(1,nfsh,1,nages);
+    dmatrix wt_tmp(1,nfsh,1,nages);
+    for (k=1;k<=nfsh;k++)
+    {
+      sel_tmp(k) = value(sel_fsh(k,endyr));
+      wt_tmp(k)  = wt_fsh(k,endyr);
+    }
+    om.set_fishery(value(Fratio),sel_tmp,wt_tmp,wt_pop);
+  }
+  om.set_biology(wt_mature,spmo_frac);
+  om.set_sr(SrType,value(alpha),value(beta),value(phizero),value(Bzero),value(mean_log_rec));
+  dvector M_tac  = value(M(endyr));    // M in the catch equation for the TAC
+  dvector M_proj(1,nages);             // M in the projection
+  M_proj = value(mean(M));
+  double M_cap   = value(natmort(styr));
+  double Fmsy_d  = value(Fmsy);
+  dvector rec_mult = mfexp(value(rec_dev_future));
+
   // Initialize recruitment in first year
+  dvector Sp_Biom_om0(styr_fut-rec_age,endyr_fut);
+  dmatrix nage_om0(styr_fut-1,endyr_fut,1,nages);
+  Sp_Biom_om0.initialize();
   for (i=styr_fut-rec_age;i<styr_fut;i++)
-    Sp_Biom_future(i) = Sp_Biom(i);
-  nage_future(styr_fut)(2,nages)              = ++elem_prod(natage(endyr)(1,nages-1),S(endyr)(1,nages-1));
-  nage_future(styr_fut,nages)                += natage(endyr,nages)*S(endyr,nages);
-
-  // assume survival same as in last year...
-  Sp_Biom_future(styr_fut) = elem_prod(nage_future(styr_fut),pow(S(endyr),spmo_frac)) * wt_mature; 
+    Sp_Biom_om0(i) = value(Sp_Biom(i));
+  nage_om0(styr_fut-1) = value(natage(endyr));
+  for (i=styr_fut;i<=endyr_fut;i++)
+    nage_om0(i) = value(nage_future(i));
+  om.graduate(nage_om0(styr_fut-1),value(S(endyr)),nage_om0(styr_fut));
+
+  // Management procedure: in-process rule for cmp_no (-hcr), otherwise ctac.dat/ComputeTAC.bat.
+  // In-process rules get one object per replicate, and the replicates run on n_threads
+  // threads (-nthreads); the file protocol shares its files, so it runs one replicate at a time.
+  // ADMB arrays are not thread-safe to create or destroy, so the rules and the arrays of every
+  // replicate are made here, on the calling thread, and the replicates only use their elements
+  hcr_setup mp_setup;
+  mp_setup.index.allocate(1,nyrs_ind(1));
+  mp_setup.index = obs_ind(1);
+  mp_setup.M     = M_cap;
+  int nthr = (use_hcr && hcr_rules.has(cmp_no)) ? n_threads : 1;
+  std::vector<hcr*> mp(nsims+1);
+  for (int isim=1;isim<=nsims;isim++)
+    mp[isim] = use_hcr ? hcr_rules.create(cmp_no,mp_setup) : new hcr_file(cmp_no);
+  dmatrix  ran_ind_all(1,nsims,1,nind);
+  dmatrix  Z_all(1,nsims,1,nages);
+  dmatrix  S_all(1,nsims,1,nages);
+  dmatrix  C_all(1,nsims,1,nages);
+  dmatrix  Sp_Biom_all(1,nsims,styr_fut-rec_age,endyr_fut);
+  d3_array nage_all(1,nsims,styr_fut-1,endyr_fut,1,nages);
   for (int isim=1;isim<=nsims;isim++)
   {
-    cout<<isim<<" "<<cmp_no<<" "<<mc_count<<" "<<endl;
-    // Copy file to get mean for Mgt Strategies
-    system("init_stuff.bat");
+    Sp_Biom_all(isim) = Sp_Biom_om0;
+    nage_all(isim)    = nage_om0;
+  }
+  double M_proj_mean = mean(M_proj);
+  // streams of this draw: replicate (mc_count-1)*nsims+isim (see rng-stream.h)
+  unsigned long rep0 = (unsigned long)(mc_count-1)*nsims;
+  rng_service sim_rng(iseed);
+  std::vector<std::string> OmBuf(nsims+1);
+  replicate_pool pool(nthr);
+  pool.run(nsims, [&](int isim)
+  {
+    int i, j;      // not the model's loop counters, which are shared between threads
+    std::ostringstream SaveOM;
+    dvector& ran_ind_vect = ran_ind_all(isim);
+    dvector& Z_om         = Z_all(isim);
+    dvector& S_om         = S_all(isim);
+    dvector& C_om         = C_all(isim);
+    dvector& Sp_Biom_om   = Sp_Biom_all(isim);
+    dmatrix& nage_om      = nage_all(isim);
+    double new_ind, C_tmp, Fnow, last_ind;
+
+    mp[isim]->start();
     for (i=styr_fut;i<=endyr_fut;i++)
     {
       // Some unit normals...for generating data
-      ran_ind_vect.fill_randn(rng);
-      cout<<ran_ind_vect<<endl;
+      sim_rng.stream(rep0+isim,i,RNG_OM_INDEX).fill_randn(ran_ind_vect);
       // Create new indices observations
       // for (k = 1 ; k<= nind ; k++) new_ind(k) = mfexp(ran_ind_vect(k)*.2)*value(nage_future(i)*q_ind(k,nyrs_ind(k))*sel_ind(k,endyr)); // use value function since converts to a double
       // new_ind(1) = mfexp(ran_ind_vect(1)*0.2)*value(sum(nage_future(i)*q_ind(1,nyrs_ind(1))));
-      if(styr_fut==i)
-        new_ind(1) = mfexp(ran_ind_vect(1)*0.2)*value(wt_ind(1,endyr)*(natage(i-1)));
-      else
-        new_ind(1) = mfexp(ran_ind_vect(1)*0.2)*value(wt_ind(1,endyr)*(nage_future(i-1)));
-      // now for Selecting which MP to use
-      // Append new indices observation to datafile
-      ifstream tacin("ctac.dat");
-      int nobstmp;
-      tacin >> nobstmp ;
-      dvector t_tmp(1,nobstmp);
-      tacin >> t_tmp;
-      tacin.close();
-      ofstream octac("ctac.dat");
-      octac<<nobstmp+1<<endl;
-      octac<<t_tmp<<endl;
-      octac<<new_ind(1)<<endl;
-      octac.close();
-      system("ComputeTAC.bat " + (itoa(cmp_no,10))); // commandline function to get TAC (catchnext.dat)
-     // Now read in TAC (actual catch)
-     ifstream CatchNext("CatchNext.dat");
-     CatchNext >> C_tmp; 
-     CatchNext.close();
-     //if (cmp_no==5) C_tmp=value((natmort(styr))*mean(t_tmp(nobstmp-2,nobstmp)));
-     //if (cmp_no==6) C_tmp=value((natmort(styr))*.75*mean(t_tmp(nobstmp-2,nobstmp)));
-     if (cmp_no==5) 
-     {
-       C_tmp = min(C_tmp*1.1,value((natmort(styr)*t_tmp(nobstmp))));
-       ofstream cnext("CatchNext.dat");
-       cnext <<C_tmp<<endl;
-       cnext.close();
-     }
-     if (cmp_no==6) 
-     {
-       C_tmp = min(C_tmp*1.1,value(natmort(styr)*.75*t_tmp(nobstmp)));
-       ofstream cnext("CatchNext.dat");
-       cnext <<C_tmp<<endl;
-       cnext.close();
-     }
-
-     Fnow = SolveF2(endyr,nage_future(i), C_tmp);
-
-      F_future(1,i) = sel_fsh(1,endyr) * Fnow;
-      //Z_future(i)   = F_future(1,i) + max(natmort);
-      Z_future(i)   = F_future(1,i) + mean(M);
-      S_future(i)   = mfexp(-Z_future(i));
-      nage_future(i,1)  = SRecruit( Sp_Biom_future(i-rec_age) ) * mfexp(rec_dev_future(i)) ;     
-      Sp_Biom_future(i) = wt_mature * elem_prod(nage_future(i),pow(S_future(i),spmo_frac)) ;
+      new_ind = mfexp(ran_ind_vect(1)*0.2)*(wt_ind(1,endyr)*nage_om(i-1));
+      // now for Selecting which MP to use: add the new index observation and get the TAC (actual catch)
+      last_ind = mp[isim]->latest();
+      C_tmp    = mp[isim]->tac(new_ind);
+      if (cmp_no==5) 
+        C_tmp = min(C_tmp*1.1,M_cap*last_ind);
+      if (cmp_no==6) 
+        C_tmp = min(C_tmp*1.1,M_cap*.75*last_ind);
+      mp[isim]->taken(C_tmp);
+
+      Fnow = om.solve_F(nage_om(i),M_tac,C_tmp);
+
+      om.mortality(Fnow,M_proj,Z_om,S_om);
+      nage_om(i,1)  = om.recruit(Sp_Biom_om(i-rec_age)) * rec_mult(i);
+      Sp_Biom_om(i) = om.spawners(nage_om(i),S_om);
       // Now graduate for the next year....
       if (i<endyr_fut)
-      {
-        nage_future(i+1)(2,nages) = ++elem_prod(nage_future(i)(1,nages-1),S_future(i)(1,nages-1));
-        nage_future(i+1,nages)   += nage_future(i,nages)*S_future(i,nages);
-      }
-      catage_future(i) = 0.; 
-      for (k = 1 ; k<= nfsh ; k++)
-        catage_future(i) += elem_prod(nage_future(i) , elem_prod(F_future(k,i) , elem_div( ( 1.- S_future(i) ) , Z_future(i))));
+        om.graduate(nage_om(i),S_om,nage_om(i+1));
+      om.catch_at_age(nage_om(i),Fnow,Z_om,S_om,C_om);
   
       SaveOM << model_name       <<
         " "  << cmp_no           <<
@@ -2747,125 +3019,111 @@ FUNCTION Oper_Model
         " "  << isim             <<
         " "  << i                <<
         " "  << Fnow             <<
-        " "  << Fnow/Fmsy        <<
-        " "  << Sp_Biom_future(i-rec_age)                       <<
-        " "  << nage_future(i)                                  <<
-        " "  << catage_future(i)*wt_fsh(1,endyr)                <<
-        " "  << mean(M)                                   <<
-        " "  << t_tmp(nobstmp)                                  <<
+        " "  << Fnow/Fmsy_d      <<
+        " "  << Sp_Biom_om(i-rec_age);
+      for (j=1;j<=nages;j++)
+        SaveOM << " " << nage_om(i,j);
+      SaveOM <<
+        " "  << C_om*wt_fsh(1,endyr)                            <<
+        " "  << M_proj_mean                                     <<
+        " "  << last_ind                                        <<
       endl;
     }
+    OmBuf[isim] = SaveOM.str();
+  });
+  for (int isim=1;isim<=nsims;isim++)
+  {
+    cout<<isim<<" "<<cmp_no<<" "<<mc_count<<" "<<endl;
+    SaveOM << OmBuf[isim];
+    delete mp[isim];
   }
   // if (mc_count>5) exit(1);
   SaveOM.close();
   if (!mceval_phase())
     exit(1);
 
-FUNCTION void get_future_Fs(const int& i,const int& iscenario)
-    f_tmp.initialize();
-    dvar_matrix F_fut_tmp(1,nfsh,1,nages);
-    for (k=1;k<=nfsh;k++) F_fut_tmp(k) =F(k,endyr);
-    switch (iscenario)
-    {
-      case 1:
-        // f_tmp = F35;
-        for (int k=1;k<=nfsh;k++) f_tmp(k) = mean(F(k,endyr));
-        // for (int k=1;k<=nfsh;k++) f_tmp(k) = SolveF2(endyr,nage_future(i), 1.0  * catch_lastyr(k));
-        break;
-      case 2:
-        // for (int k=1;k<=nfsh;k++) f_tmp(k) = Fratio(k)*Fmsy; // mean(F(k,endyr));
-        for (int k=1;k<=nfsh;k++) f_tmp(k) = mean(F(k,endyr));
-        f_tmp *= 0.75;
-        break;
-      case 3:
-        for (int k=1;k<=nfsh;k++) f_tmp(k) = mean(F(k,endyr));
-        f_tmp *= 0.5;
-        break;
-      case 4:
-        // for (int k=1;k<=nfsh;k++) f_tmp(k) = .25*mean(F(k,endyr));
-        // F_fut_tmp *= 0.25;
-        for (int k=1;k<=nfsh;k++) f_tmp(k) = mean(F(k,endyr));
-        f_tmp *= 0.25;
-      case 5:
-        f_tmp = 0.0;
-        F_fut_tmp = 0.0;
-        break;
-    }
-    Z_future(i) = M(endyr);
-    for (k=1;k<=nfsh;k++)
-    {
-      F_future(k,i) = sel_fsh(k,endyr) * f_tmp(k);
-      Z_future(i)  += F_future(k,i);
-    }
-    S_future(i) = mfexp(-Z_future(i));
-
 FUNCTION Future_projections
-  // Need to check on treatment of Fratio--whether it should be included or not
+  // The rows of the scenario table (type_proj, val_proj) are projected by proj_scenarios as
+  // a batch, year by year.  With derivatives (sdreport of SSB_fut) the batch runs in
+  // dvariables; in the mceval phase only values are needed, so it runs in doubles, split
+  // into blocks of rows on n_threads threads, with the arrays of each block allocated here
+  // beforehand.  nage_future, Sp_Biom_future and catage_future are from the last scenario,
+  // filled by the batch that projects it
   SSB_fut.initialize();
   catch_future.initialize();
-  for (int iscen=1;iscen<=5;iscen++)
+  rec_future.initialize();
+  dvar_vector Sp_lag(styr_fut-rec_age,styr_fut-1);
+  for (i=styr_fut-rec_age;i<styr_fut;i++)
+    Sp_lag(i) = wt_mature * elem_prod(natage(i),pow(S(i),spmo_frac)) ;
+  dvar_vector Fbar(1,nfsh);
+  dvar_matrix sel_tmp(1,nfsh,1,nages);
+  dmatrix     wt_tmp(1,nfsh,1,nages);
+  for (k=1;k<=nfsh;k++)
   {
-   // Future Sp_Biom set equal to estimated Sp_Biom w/ right lag
-    // Sp_Biom_future(styr_fut-rec_age,styr_fut-1) = Sp_Biom(endyr-rec_age+1,endyr);
-    for (i=styr_fut-rec_age;i<styr_fut;i++)
-      Sp_Biom_future(i) = wt_mature * elem_prod(natage(i),pow(S(i),spmo_frac)) ;
-
-    nage_future(styr_fut)(2,nages) = ++elem_prod(natage(endyr)(1,nages-1),S(endyr)(1,nages-1));
-    nage_future(styr_fut,nages)   += natage(endyr,nages)*S(endyr,nages);
-    Sp_Biom_future(styr_fut)       = wt_mature * elem_prod(nage_future(i),pow(S_future(i),spmo_frac)) ;
-    // Future Recruitment (and Sp_Biom)
-    for (i=styr_fut;i<endyr_fut;i++)
-    {
-      nage_future(i,1)  = SRecruit( Sp_Biom_future(i-rec_age) ) * mfexp(rec_dev_future(i)) ;     
-      get_future_Fs(i,iscen);
-      // Now graduate for the next year....
-      nage_future(i+1)(2,nages) = ++elem_prod(nage_future(i)(1,nages-1),S_future(i)(1,nages-1));
-      nage_future(i+1,nages)   += nage_future(i,nages)*S_future(i,nages);
-      Sp_Biom_future(i) = wt_mature * elem_prod(nage_future(i),pow(S_future(i),spmo_frac)) ;
-    }
-    nage_future(endyr_fut,1)  = SRecruit( Sp_Biom_future(endyr_fut-rec_age) ) * mfexp(rec_dev_future(endyr_fut)) ;     
-    get_future_Fs(endyr_fut,iscen);
-    Sp_Biom_future(endyr_fut)  = wt_mature * elem_prod(nage_future(endyr_fut),pow(S_future(endyr_fut),spmo_frac)) ;
-    /*
-		if (iscen==1)
-    {
-      for (i=endyr+1;i<=endyr_fut;i++)
-      {                   
-        N_NoFsh(i,1)        = nage_future(i,1);
-        // Adjustment for no-fishing recruits (ratio of R_nofish/R_fish)
-        N_NoFsh(i,1)       *= SRecruit(Sp_Biom_NoFish(i-rec_age)) / SRecruit(Sp_Biom_future(i-rec_age));
-        N_NoFsh(i)(2,nages) = ++N_NoFsh(i-1)(1,nages-1)*exp(-mean(natmort));
-        N_NoFsh(i,nages)   +=   N_NoFsh(i-1,nages)*exp(-mean(natmort));
-        Sp_Biom_NoFish(i)   = (N_NoFsh(i)*pow(exp(-mean(natmort)),spmo_frac) * wt_mature); 
-        // Sp_Biom_NoFishRatio(i)  = Sp_Biom_future(i) / Sp_Biom_NoFish(i) ;
-      }
-    }
-    */
-    // Now get catch at future ages
-    dvar_vector catage_tmp(1,nages);
-    for (i=styr_fut; i<=endyr_fut; i++)
-    {
-      catage_future(i).initialize();
-      if (iscen!=5) 
-      {
-        for (k = 1 ; k<= nfsh ; k++)
-        {
-          catage_tmp.initialize();
-          catage_tmp = elem_prod(nage_future(i) , elem_prod(F_future(k,i) , 
-                                elem_div( ( 1.- S_future(i) ) , Z_future(i))));
-          catage_future(i) += catage_tmp;
-          catch_future(iscen,i)  += catage_tmp*wt_fsh(k,endyr);
-        }
-      }
-      SSB_fut(iscen,i) = Sp_Biom_future(i);
-    }
-  }   //End of loop over F's
+    Fbar(k)    = mean(F(k,endyr));
+    sel_tmp(k) = sel_fsh(k,endyr);
+    wt_tmp(k)  = wt_fsh(k,endyr);
+  }
+  if (mceval_phase())
+  {
+    oper_proj<double> proj;
+    proj.set_fishery(value(Fratio),value(sel_tmp),wt_tmp,wt_pop);
+    proj.set_biology(wt_mature,spmo_frac);
+    proj.set_sr(SrType,value(alpha),value(beta),value(phizero),value(Bzero),value(mean_log_rec));
+    proj_scenarios<double> scen(styr_fut,endyr_fut,rec_age,proj);
+    scen.set_start(value(natage(endyr)),value(S(endyr)),value(Sp_lag));
+    scen.set_fishery(value(M(endyr)),value(sel_tmp),value(Fbar),wt_tmp);
+    scen.set_reference(value(Fmsy),value(Fratio));
+    scen.set_recruitment(mfexp(value(rec_dev_future)));
+    dmatrix SSB_tmp(1,nscen_proj,styr_fut,endyr_fut);
+    dmatrix catch_tmp(1,nscen_proj,styr_fut,endyr_fut);
+    dmatrix rec_tmp(1,nscen_proj,styr_fut,endyr_fut);
+    int nblk = n_threads < nscen_proj ? n_threads : nscen_proj;
+    std::vector< proj_batch<double> > blk(nblk+1);
+    for (int iblk=1;iblk<=nblk;iblk++)
+      scen.allocate(blk[iblk],(iblk-1)*nscen_proj/nblk+1,iblk*nscen_proj/nblk);
+    proj_scenario<double> sc;
+    scen.allocate(sc);
+    replicate_pool pool(nblk);
+    pool.run(nblk,[&](int iblk)
+    {
+      scen.project_batch(type_proj,val_proj,blk[iblk],SSB_tmp,catch_tmp,rec_tmp,iblk==nblk ? &sc : 0);
+    });
+    SSB_fut      = SSB_tmp;
+    catch_future = catch_tmp;
+    rec_future   = rec_tmp;
+    nage_future    = sc.N;
+    Sp_Biom_future = sc.Sp;
+    catage_future  = sc.C;
+  }
+  else
+  {
+    oper_proj<dvariable> proj;     // same projection steps as the operating model, on dvariables
+    proj.set_fishery(Fratio,sel_tmp,wt_tmp,wt_pop);
+    proj.set_biology(wt_mature,spmo_frac);
+    proj.set_sr(SrType,alpha,beta,phizero,Bzero,mean_log_rec);
+    proj_scenarios<dvariable> scen(styr_fut,endyr_fut,rec_age,proj);
+    scen.set_start(natage(endyr),S(endyr),Sp_lag);
+    scen.set_fishery(M(endyr),sel_tmp,Fbar,wt_tmp);
+    scen.set_reference(Fmsy,Fratio);
+    scen.set_recruitment(mfexp(rec_dev_future));
+    proj_batch<dvariable> blk;
+    scen.allocate(blk,1,nscen_proj);
+    proj_scenario<dvariable> sc;
+    scen.allocate(sc);
+    scen.project_batch(type_proj,val_proj,blk,SSB_fut,catch_future,rec_future,&sc);
+    nage_future    = sc.N;
+    Sp_Biom_future = sc.Sp;
+    catage_future  = sc.C;
+  }
   Sp_Biom(endyr+1) = Sp_Biom_future(endyr+1);
 
 FUNCTION get_msy
   /** Function calculates used in calculating MSY and MSYL for a designated component of the
   population, given values for stock recruitment and selectivity...  
-  Fmsy is the trial value of MSY example of the use of "funnel" to reduce the amount of storage for derivative calculations 
+  Fmsy is found in doubles (get_Fmsy); one Newton step on dvariables at the solution, with
+  the analytic d(yield)/dF (dyield_dF), then carries the derivatives of Fmsy with respect to
+  the parameters without changing its value
   */
 
   dvariable sumF=0.;
@@ -2874,49 +3132,14 @@ FUNCTION get_msy
   for (k=1;k<=nfsh;k++)
     Fratio(k) = sum(F(k,endyr)) / sumF;
 
-  dvariable Stmp;
   dvariable Rtmp;
-  double df=1.e-05;
-  dvariable F1;
-  F1.initialize();
-  F1 = (0.8*natmortprior);
-  dvariable F2;
-  dvariable F3;
-  dvariable yld1;
-  dvariable yld2;
-  dvariable yld3;
-  dvariable dyld;
-  dvariable dyldp;
-  int breakout=0;
-  // Newton Raphson stuff to go here
-  for (int ii=1;ii<=8;ii++)
-  {
-    if (mceval_phase()&&(F1>5||F1<0.01)) 
-    {
-      ii=8;
-      if (F1>5) F1=5.0; 
-      else      F1=0.001; 
-      breakout    = 1;
-    }
-    F2     = F1 + df*.5;
-    F3     = F2 - df;
-    // yld1   = yield(Fratio,F1, Stmp,Rtmp); // yld2   = yield(Fratio,F2,Stmp,Rtmp); // yld3   = yield(Fratio,F3,Stmp,Rtmp);
-    yld1   = yield(Fratio,F1);
-    yld2   = yield(Fratio,F2);
-    yld3   = yield(Fratio,F3);
-    dyld   = (yld2 - yld3)/df;                          // First derivative (to find the root of this)
-    dyldp  = (yld2 + yld3 - 2.*yld1)/(.25*df*df);       // Second derivative (for Newton Raphson)
-    if (breakout==0)
-    {
-      F1    -= dyld/dyldp;
-    }
-    else
-    {
-      if (F1>5) 
-        cout<<"Fmsy v. high "<< endl;// yld1<<" "<< yld2<<" "<< yld3<<" "<< F1<<" "<< F2<<" "<< F3<<" "<< endl;
-      else      
-        cout<<"Fmsy v. low "<< endl;// yld1<<" "<< yld2<<" "<< yld3<<" "<< F1<<" "<< F2<<" "<< F3<<" "<< endl;
-    }
+  double d2yld;
+  double Fd = get_Fmsy(get_per_recruit(endyr,styr),d2yld);
+  dvariable F1 = Fd;
+  if (d2yld<0.)
+  {
+    dvariable dyld = dyield_dF(Fratio,Fd,endyr,styr);
+    F1 -= (dyld - value(dyld))/d2yld;
   }
   {
     dvar_vector ttt(1,5);
@@ -2940,7 +3163,7 @@ FUNCTION get_msy
 FUNCTION void get_msy(int iyr)
   /** Function calculates used in calculating MSY and MSYL for a designated component of the
   population, given values for stock recruitment and selectivity...  
-  Fmsy is the trial value of MSY example of the use of "funnel" to reduce the amount of storage for derivative calculations */
+  Fmsy is found in doubles (get_Fmsy), as in get_msy() but for year iyr */
 
   dvariable sumF=0.;
   for (k=1;k<=nfsh;k++)
@@ -2948,49 +3171,14 @@ FUNCTION void get_msy(int iyr)
   for (k=1;k<=nfsh;k++)
     Fratio(k) = sum(F(k,iyr)) / sumF;
 
-  dvariable Stmp;
   dvariable Rtmp;
-  double df=1.e-05;
-  dvariable F1;
-  F1.initialize();
-  F1 = (0.8*natmortprior);
-  dvariable F2;
-  dvariable F3;
-  dvariable yld1;
-  dvariable yld2;
-  dvariable yld3;
-  dvariable dyld;
-  dvariable dyldp;
-  int breakout=0;
-  // Newton Raphson stuff to go here
-  for (int ii=1;ii<=8;ii++)
-  {
-    if (mceval_phase()&&(F1>5||F1<0.01)) 
-    {
-      ii=8;
-      if (F1>5) F1=5.0; 
-      else      F1=0.001; 
-      breakout    = 1;
-    }
-    F2     = F1 + df*.5;
-    F3     = F2 - df;
-    // yld1   = yield(Fratio,F1, Stmp,Rtmp); // yld2   = yield(Fratio,F2,Stmp,Rtmp); // yld3   = yield(Fratio,F3,Stmp,Rtmp);
-    yld1   = yield(Fratio,F1,iyr);
-    yld2   = yield(Fratio,F2,iyr);
-    yld3   = yield(Fratio,F3,iyr);
-    dyld   = (yld2 - yld3)/df;                          // First derivative (to find the root of this)
-    dyldp  = (yld2 + yld3 - 2.*yld1)/(.25*df*df);   // Second derivative (for Newton Raphson)
-    if (breakout==0)
-    {
-      F1    -= dyld/dyldp;
-    }
-    else
-    {
-      if (F1>5) 
-        cout<<"Fmsy v. high "<< endl;// yld1<<" "<< yld2<<" "<< yld3<<" "<< F1<<" "<< F2<<" "<< F3<<" "<< endl;
-      else      
-        cout<<"Fmsy v. low "<< endl;// yld1<<" "<< yld2<<" "<< yld3<<" "<< F1<<" "<< F2<<" "<< F3<<" "<< endl;
-    }
+  double d2yld;
+  double Fd = get_Fmsy(get_per_recruit(iyr,iyr),d2yld);
+  dvariable F1 = Fd;
+  if (d2yld<0.)
+  {
+    dvariable dyld = dyield_dF(Fratio,Fd,iyr,iyr);
+    F1 -= (dyld - value(dyld))/d2yld;
   }
   {
     dvar_vector ttt(1,5);
@@ -3246,40 +3434,148 @@ FUNCTION Profile_F
   /** NOTE THis will need to be conditional on SrType too Function calculates 
   used in calculating MSY and MSYL for a designated component of the
   population, given values for stock recruitment and selectivity...  
-  Fmsy is the trial value of MSY example of the use of "funnel" to 
-  reduce the amount of storage for derivative calculations 
+  Fmsy is the trial value of MSY. All 500 values of F are evaluated in one
+  call of the per-recruit engine (per-recruit.cpp), in doubles
   */
   cout << "Doing a profile over F...."<<endl;
   ofstream prof_F("Fprof.yld");
- dvariable sumF=0.;
+  dvariable sumF=0.;
   for (k=1;k<=nfsh;k++)
     sumF += sum(F(k,endyr));
   for (k=1;k<=nfsh;k++)
     Fratio(k) = sum(F(k,endyr)) / sumF;
-  dvariable Stmp;
-  dvariable Rtmp;
-  double df=1.e-7;
-  dvariable F1=.05;
-  dvariable F2;
-  dvariable F3;
-  dvariable yld1;
-  dvariable yld2;
-  dvariable yld3;
-  dvariable dyld;
-  dvariable dyldp;
+  per_recruit pr = get_per_recruit(endyr,styr);
+  dvector Fgrid(1,500);
+  for (int ii=1;ii<=500;ii++)
+    Fgrid(ii) = double(ii)/500;
+  dvector phi;
+  dvector ypr;
+  dvector bpr;
+  pr.evaluate(Fgrid,phi,ypr,bpr);
   prof_F <<"Profile of stock, yield, and recruitment over F"<<endl;
   prof_F << model_name<<" "<<datafile_name<<endl;
   prof_F <<endl<<endl<<"F  Stock  Yld  Recruit SPR"<<endl;
   prof_F <<0.0<<" "<< Bzero <<" "<<0.0<<" "<<Rzero<< " 1.00"<<endl; 
-  dvar_vector ttt(1,5);
+  dvector ttt(1,5);
   for (int ii=1;ii<=500;ii++)
   {
-    F1    = double(ii)/500;
-    yld1  = yield(Fratio,F1,Stmp,Rtmp);
-    ttt   = yld(Fratio,F1);
-    prof_F <<F1<<" "<< ttt << endl; 
+    double Req = Requil(phi(ii));
+    ttt(1) = phi(ii)*Req;                // Bmsy
+    ttt(2) = ypr(ii)*Req;                // MSY
+    ttt(3) = Req;                        // Eq Recruitment
+    ttt(4) = phi(ii)/value(phizero);     // SPR
+    ttt(5) = bpr(ii)*Req;                // BmsyTot
+    prof_F <<Fgrid(ii)<<" "<< ttt << endl; 
   } 
 
+FUNCTION per_recruit get_per_recruit(int iyr_sel, int iyr_M)
+  /** Per-recruit engine (doubles) for the current Fratio, with fishery selectivity
+  and catch weights of year iyr_sel and natural mortality of year iyr_M, as in yld() */
+  dvector zsel(1,nages);
+  dvector ysel(1,nages);
+  zsel.initialize();
+  ysel.initialize();
+  for (k=1;k<=nfsh;k++)
+  {
+    zsel += value(Fratio(k)) * value(sel_fsh(k,iyr_sel));
+    ysel += value(Fratio(k)) * elem_prod(value(sel_fsh(k,iyr_sel)),wt_fsh(k,iyr_sel));
+  }
+  return per_recruit(value(M(iyr_M)),zsel,ysel,wt_mature,wt_pop,spmo_frac);
+
+FUNCTION double dyield_dF(const per_recruit& pr, double Ftmp, double& d2yld)
+  /** Exact first (returned) and second (d2yld) derivative of equilibrium yield
+  Req(phi(F)) * ypr(F) with respect to F */
+  double phi[3];
+  double ypr[3];
+  double dR[2];
+  pr.derivatives(Ftmp,phi,ypr);
+  double R = Requil(phi[0],dR);
+  d2yld = dR[1]*phi[1]*phi[1]*ypr[0] + dR[0]*phi[2]*ypr[0] + 2.*dR[0]*phi[1]*ypr[1] + R*ypr[2];
+  return dR[0]*phi[1]*ypr[0] + R*ypr[1];
+
+FUNCTION dvariable dyield_dF(const dvar_vector& Fratio, double Ftmp, int iyr_sel, int iyr_M)
+  /** d(yield)/dF at Ftmp on dvariables, dR/dphi phi' ypr + R ypr', with phi' and ypr' from
+  the same recursion over ages as per_recruit_kernel (per-recruit.cpp): L = d log(n)/dF, and
+  selectivity and mortality as in yield() for years iyr_sel and iyr_M.  Gives get_msy the
+  derivatives of the first-order condition with respect to the parameters in one pass */
+  RETURN_ARRAYS_INCREMENT();
+  dvar_vector zsel(1,nages);
+  dvar_vector ysel(1,nages);
+  zsel.initialize();
+  ysel.initialize();
+  for (k=1;k<=nfsh;k++)
+  {
+    zsel += Fratio(k) * sel_fsh(k,iyr_sel);
+    ysel += Fratio(k) * elem_prod(sel_fsh(k,iyr_sel),wt_fsh(k,iyr_sel));
+  }
+  dvariable n = 1.;
+  dvariable L = 0.;
+  dvariable phi = 0.;
+  dvariable dphi = 0.;
+  dvariable ypr = 0.;
+  dvariable dypr = 0.;
+  dvariable z, e, t, h, dh, q, dq;
+  for (j=1;j<=nages;j++)
+  {
+    z = M(iyr_M,j) + Ftmp*zsel(j);
+    e = mfexp(-z);
+    if (j==nages)
+    {
+      // plus group
+      n /= (1.-e);
+      L -= zsel(j)*e/(1.-e);
+    }
+    t     = n*wt_mature(j)*mfexp(-spmo_frac*z);
+    phi  += t;
+    dphi += t*(L - spmo_frac*zsel(j));
+    h     = (1.-e)/z;
+    dh    = (z*e - (1.-e))/(z*z);
+    q     = Ftmp*h;
+    dq    = h + Ftmp*dh*zsel(j);
+    ypr  += n*ysel(j)*q;
+    dypr += n*ysel(j)*(L*q + dq);
+    n    *= e;
+    L    -= zsel(j);
+  }
+  dvariable dyld = dRequil(phi)*dphi*ypr + Requil(phi)*dypr;
+  RETURN_ARRAYS_DECREMENT();
+  return dyld;
+
+FUNCTION double get_Fmsy(const per_recruit& pr, double& d2yld)
+  /** Fmsy as the root of d(yield)/dF on [0.001,5] by safeguarded Newton with exact
+  derivatives (dyield_dF), to a relative step of 1e-12.  Returns the end point if the
+  root is outside, with d2yld = 0; sets msy_iter */
+  double lo = 0.001;
+  double hi = 5.0;
+  msy_iter  = 0;
+  d2yld     = 0.;
+  double dd;
+  if (dyield_dF(pr,hi,dd)>0.) 
+  {
+    cout<<"Fmsy v. high "<< endl;
+    return hi;
+  }
+  if (dyield_dF(pr,lo,dd)<0.) 
+  {
+    cout<<"Fmsy v. low "<< endl;
+    return lo;
+  }
+  double F1 = 0.8*natmortprior;
+  if (F1<=lo || F1>=hi) F1 = 0.5*(lo+hi);
+  for (msy_iter=1;msy_iter<=50;msy_iter++)
+  {
+    double g  = dyield_dF(pr,F1,d2yld);
+    double F2 = per_recruit_newton_step(F1,g,d2yld,lo,hi);
+    if (fabs(F2-F1)<=1.e-12*F1 || g==0.)
+    {
+      F1 = F2;
+      break;
+    }
+    F1 = F2;
+  }
+  dyield_dF(pr,F1,d2yld);
+  return F1;
+
 FUNCTION dvar_vector SRecruit(const dvar_vector& Stmp)
   RETURN_ARRAYS_INCREMENT();
   dvar_vector RecTmp(Stmp.indexmin(),Stmp.indexmax());
@@ -3421,6 +3717,77 @@ FUNCTION dvariable Requil(dvariable& phi)
   RETURN_ARRAYS_DECREMENT();
   return RecTmp;
 
+FUNCTION dvariable dRequil(dvariable& phi)
+  /** Derivative of the equilibrium recruitment Requil(phi) with respect to phi, on
+  dvariables (as dR[0] of Requil(double,double*)) */
+  RETURN_ARRAYS_INCREMENT();
+  dvariable dR;
+  dR = 0.;
+  switch (SrType)
+  {
+    case 1:
+      dR = Bzero/alpha * (1. - alpha + log(phizero) - log(phi)) / (phi*phi);
+      break;
+    case 2:
+      dR = alpha/(beta*phi*phi);
+      break;
+    case 4:
+      dR = (1. - alpha - log(phi)) / (beta*phi*phi);
+      break;
+  }
+  RETURN_ARRAYS_DECREMENT();
+  return dR;
+
+FUNCTION double Requil(double phi)
+  /** Equilibrium recruitment in doubles, same as Requil(dvariable&) */
+  double RecTmp=0.;
+  switch (SrType)
+  {
+    case 1:
+      RecTmp =  value(Bzero) * (value(alpha) + log(phi) - log(value(phizero)) ) / (value(alpha)*phi);
+      break;
+    case 2:
+      RecTmp =  (phi-value(alpha))/(value(beta)*phi);
+      break;
+    case 3:
+      RecTmp =  exp(value(mean_log_rec));
+      break;
+    case 4:
+      RecTmp =  (log(phi)+value(alpha)) / (value(beta)*phi);
+      break;
+  }
+  return RecTmp;
+
+FUNCTION double Requil(double phi, double* dR)
+  /** Equilibrium recruitment in doubles with its first and second derivatives with
+  respect to phi in dR[0] and dR[1] */
+  double R = Requil(phi);
+  double c = 0.;
+  double K = 0.;
+  dR[0] = 0.;
+  dR[1] = 0.;
+  switch (SrType)
+  {
+    case 1:
+      c = value(Bzero)/value(alpha);
+      K = value(alpha) - log(value(phizero));
+      break;
+    case 2:
+      dR[0] =  value(alpha)/(value(beta)*phi*phi);
+      dR[1] = -2.*dR[0]/phi;
+      return R;
+    case 3:
+      return R;
+    case 4:
+      c = 1./value(beta);
+      K = value(alpha);
+      break;
+  }
+  // R = c (K + log(phi)) / phi
+  dR[0] = c*(1. - K - log(phi))/(phi*phi);
+  dR[1] = c*(2.*K + 2.*log(phi) - 3.)/(phi*phi*phi);
+  return R;
+
 FUNCTION write_mceval_hdr
     for (k=1;k<=nind;k++)
       mceval<< " model Obj_Fun q_ind_"<< k<< " ";
@@ -3428,15 +3795,38 @@ FUNCTION write_mceval_hdr
     " F35          "<< 
     " F40          "<< 
     " F50          "<< 
-    " fut_SPB_Fmsy_"<< endyr_fut<<" "<< 
-    " fut_SPB_F50%_"<< endyr_fut<<" "<< 
-    " fut_SPB_F40%_"<< endyr_fut<<" "<< 
-    " fut_SPB_F35%_"<< endyr_fut<<" "<< 
-    " fut_SPB_F0_"  << endyr_fut<<" "<< 
-    " fut_catch_Fmsy_"<<styr_fut<<" "<<  
-    " fut_catch_F50%_"<<styr_fut<<" "<<  
-    " fut_catch_F40%_"<<styr_fut<<" "<<  
-    " fut_catch_F35%_"<<styr_fut<<" "<<  endl;
+    " ";
+    // projection scenarios (type_proj, val_proj); catch only where there is fishing
+    for (k=1;k<=nscen_proj;k++)
+      mceval<<" fut_SPB_"<<scen_label(k)<<"_"<< endyr_fut<<" ";
+    for (k=1;k<=nscen_proj;k++)
+      if (val_proj(k)>0)
+        mceval<<" fut_catch_"<<scen_label(k)<<"_"<<styr_fut<<" ";
+    mceval<<endl;
+    mceval_proj<<"draw";
+    for (k=1;k<=nscen_proj;k++)
+    {
+      for (i=styr_fut;i<=endyr_fut;i++) mceval_proj<<" SSB_"<<scen_label(k)<<"_"<<i;
+      for (i=styr_fut;i<=endyr_fut;i++) mceval_proj<<" C_"<<scen_label(k)<<"_"<<i;
+      for (i=styr_fut;i<=endyr_fut;i++) mceval_proj<<" R_"<<scen_label(k)<<"_"<<i;
+    }
+    mceval_proj<<endl;
+
+FUNCTION adstring scen_label(int k)
+  // column label for projection scenario k: 0.75F, 1Fmsy or C20000
+  std::ostringstream os;
+  switch (type_proj(k))
+  {
+    case PROJ_FMSY:
+      os<<val_proj(k)<<"Fmsy";
+      break;
+    case PROJ_CATCH:
+      os<<"C"<<val_proj(k);
+      break;
+    default:
+      os<<val_proj(k)<<"F";
+  }
+  return adstring(os.str().c_str());
 
 //+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+==+ 
 REPORT_SECTION
@@ -3890,6 +4280,7 @@ REPORT_SECTION
 
   report<<"cv_catchbiomass: " <<cv_catchbiomass<<" "<<endl;
   report<<"Projection_years "<< nproj_yrs<<endl;
+  report<<"Newton_iterations_Fmsy_F35_F50_F40: "<< msy_iter<<" "<<spr_iter<<endl;
   for (k=1;k<=nfsh;k++)
     report << "Fsh_sel_opt_fish: "<<k<<" "<<fsh_sel_opt(k)<<" "<<sel_change_in_fsh(k)<<endl;
   for (k=1;k<=nind;k++)
@@ -4059,8 +4450,86 @@ FINAL_SECTION
   // write_msy_out();
   Profile_F();
   Write_R();
-FUNCTION dvariable get_spr_rates(double spr_percent)
-  /**  Get the SPR rates given spr_percent */
+  // only the estimates of a fit make a warm start; after an MCMC run the parameters are a draw
+  if (write_wst)
+  {
+    wst.open(adprogram_name + adstring(".wst"));
+    warm_start_items();
+    wst.close();
+  }
+  if (length(rtabfile_name)>0)
+    write_retro_table();
+
+FUNCTION warm_start_items
+  // parameters written to the warm start file at the end of a fit and restored from it
+  // (-wst) at the start of the next; year and selectivity-block indices are kept, so a
+  // retrospective peel starts from the fit with one more year
+  wst.item("tau",tau);
+  wst.item("rho_ln",rho_ln);
+  wst.item("log_dm_theta_fsh",log_dm_theta_fsh);
+  wst.item("log_dm_theta_ind",log_dm_theta_ind);
+  wst.item("Mest",Mest);
+  wst.item("Mage_offset",Mage_offset);
+  wst.item("M_rw",M_rw);
+  wst.item("log_Linf",log_Linf);
+  wst.item("log_k",log_k);
+  wst.item("log_Lo",log_Lo);
+  wst.item("log_sdage",log_sdage);
+  wst.item("mean_log_rec",mean_log_rec);
+  wst.item("steepness",steepness);
+  wst.item("log_Rzero",log_Rzero);
+  wst.item("rec_dev",rec_dev);
+  wst.item("log_sigmar",log_sigmar);
+  wst.item("fmort",fmort);
+  for (k=1;k<=nfsh;k++)
+  {
+    adstring kk = "." + str(k);
+    wst.item("log_selcoffs_fsh"+kk,log_selcoffs_fsh(k));
+    wst.item("log_sel_spl_fsh"+kk,log_sel_spl_fsh(k));
+    wst.item("logsel_slope_fsh"+kk,logsel_slope_fsh(k));
+    wst.item("sel50_fsh"+kk,sel50_fsh(k));
+    wst.item("logsel_p1_fsh"+kk,logsel_p1_fsh(k));
+    wst.item("sel_p2_fsh"+kk,sel_p2_fsh(k));
+    wst.item("logsel_p3_fsh"+kk,logsel_p3_fsh(k));
+  }
+  wst.item("rec_dev_future",rec_dev_future);
+  for (k=1;k<=nind;k++)
+  {
+    adstring kk = "." + str(k);
+    wst.item("log_q_ind"+kk,log_q_ind(k));
+    wst.item("log_q_power_ind"+kk,log_q_power_ind(k));
+    wst.item("log_rw_q_ind"+kk,log_rw_q_ind(k));
+    wst.item("log_selcoffs_ind"+kk,log_selcoffs_ind(k));
+    wst.item("logsel_slope_ind"+kk,logsel_slope_ind(k));
+    wst.item("sel50_ind"+kk,sel50_ind(k));
+    wst.item("logsel_p1_ind"+kk,logsel_p1_ind(k));
+    wst.item("sel_p2_ind"+kk,sel_p2_ind(k));
+    wst.item("logsel_p3_ind"+kk,logsel_p3_ind(k));
+  }
+  wst.item("repl_F",repl_F);
+
+FUNCTION write_retro_table
+  // appends this fit to the retrospective table (-rtab): one row per year, with the peel;
+  // the header is written when the file is new
+  ifstream old_tab(rtabfile_name);
+  int new_tab = !old_tab.good();
+  old_tab.close();
+  ofstream rtab(rtabfile_name,ios::app);
+  if (new_tab)
+    rtab<<"peel year SSB recruits totbiom Fapical"<<endl;
+  dvector Fa(1,nages);
+  for (i=styr;i<=endyr;i++)
+  {
+    Fa.initialize();
+    for (k=1;k<=nfsh;k++)
+      Fa += value(F(k,i));
+    rtab<<retro<<" "<<i<<" "<<Sp_Biom(i)<<" "<<recruits(i)<<" "<<totbiom(i)<<" "<<max(Fa)<<endl;
+  }
+FUNCTION dvariable get_spr_rates(double spr_percent, int& niter)
+  /**  Get the SPR rates given spr_percent: the root of spr_ratio(F) = spr_percent by
+  safeguarded Newton in doubles with the exact derivative of SPR (per-recruit.cpp), then
+  one step on dvariables at the solution for the derivatives with respect to the parameters.
+  niter is set to the number of Newton iterations */
   RETURN_ARRAYS_INCREMENT();
   dvar_matrix sel_tmp(1,nages,1,nfsh);
   sel_tmp.initialize();
@@ -4074,31 +4543,33 @@ FUNCTION dvariable get_spr_rates(double spr_percent)
     sumF += Fratio(k) ;
   }
   Fratio /= sumF;
-  double df=1.e-3;
-  dvariable F1 ;
-  F1.initialize();
-  F1 = .8*natmortprior;
-  dvariable F2;
-  dvariable F3;
-  dvariable yld1;
-  dvariable yld2;
-  dvariable yld3;
-  dvariable dyld;
-  dvariable dyldp;
-  // Newton Raphson stuff to go here
-  for (int ii=1;ii<=6;ii++)
-  {
-    F2     = F1 + df;
-    F3     = F1 - df;
-    yld1   = -1000*square(log(spr_percent/spr_ratio(F1, sel_tmp,styr)));
-    yld2   = -1000*square(log(spr_percent/spr_ratio(F2, sel_tmp,styr)));
-    yld3   = -1000*square(log(spr_percent/spr_ratio(F3, sel_tmp,styr)));
-    dyld   = (yld2 - yld3)/(2*df);                          // First derivative (to find the root of this)
-    dyldp  = (yld3-(2*yld1)+yld2)/(df*df);  // Newton-Raphson approximation for second derivitive
-    F1    -= dyld/dyldp;
+  per_recruit pr = get_per_recruit(endyr,styr);
+  double phi0 = value(phizero);
+  double dphi;
+  // bracket: SPR decreases with F
+  double lo = 0.;
+  double hi = 1.;
+  while (pr.phi(hi)/phi0>spr_percent && hi<100.)
+    hi *= 2.;
+  double F1 = .8*natmortprior;
+  if (F1<=lo || F1>=hi) F1 = 0.5*(lo+hi);
+  for (niter=1;niter<=50;niter++)
+  {
+    double g  = pr.phi(F1,&dphi)/phi0 - spr_percent;
+    double F2 = per_recruit_newton_step(F1,g,dphi/phi0,lo,hi);
+    if (fabs(F2-F1)<=1.e-12*F1 || g==0.)
+    {
+      F1 = F2;
+      break;
+    }
+    F1 = F2;
   }
+  pr.phi(F1,&dphi);
+  dvariable Ftmp = F1;
+  dvariable sprtmp = spr_ratio(Ftmp,sel_tmp,styr);
+  Ftmp -= (sprtmp - value(sprtmp))/(dphi/phi0);
   RETURN_ARRAYS_DECREMENT();
-  return(F1);
+  return(Ftmp);
 
 FUNCTION dvariable spr_ratio(dvariable trial_F,dvar_matrix sel_tmp,int iyr)
   /**  Get the SPR ratio given F, Selectivity and year */
@@ -4153,9 +4624,9 @@ FUNCTION compute_spr_rates
   }
   Fratio /= sumF;
 
-  F35_est = get_spr_rates(.35);
-  F50_est = get_spr_rates(.50);
-  F40_est = get_spr_rates(.40);
+  F35_est = get_spr_rates(.35,spr_iter(1));
+  F50_est = get_spr_rates(.50,spr_iter(2));
+  F40_est = get_spr_rates(.40,spr_iter(3));
 
   for (k=1;k<=nfsh;k++)
   {
@@ -4265,7 +4736,6 @@ FUNCTION Write_SimDatafile
   int nsims;
   // get the number of simulated datasets to create...
   ifstream sim_in("nsims.dat"); sim_in >> nsims; sim_in.close();
-  char buffer [33];
   ofstream SimDB("simout.dat",ios::app); 
   ofstream TruDB("truout.dat",ios::app); 
   // compute the autocorrelation term for residuals of fit to indices...
@@ -4292,25 +4762,108 @@ FUNCTION Write_SimDatafile
   yrs_fsh_age_sim       = yrs_fsh_age;
   yrs_ind_sim           = yrs_ind;
   yrs_ind_age_sim       = yrs_ind_age;
-  dmatrix new_ind_sim(1,nind,1,nyrs_ind);
-  dvector sim_rec_devs(styr_rec,endyr);
-  dvector sim_Sp_Biom(styr_rec,endyr);
-  dmatrix sim_natage(styr_rec,endyr,1,nages);
-  dmatrix catagetmp(styr,endyr,1,nages);
-  dvector sim_catchbio(styr,endyr);
+  for (k=1;k<=nfsh;k++)
+    n_sample_fsh_age_sim(k) = mean(n_sample_fsh_age(k));
+  for (k=1;k<=nind;k++)
+    n_sample_ind_age_sim(k) = mean(n_sample_ind_age(k));
   double survtmp = value(mfexp(-natmort(styr)));
   for (k=1;k<=nfsh;k++) Ftot += F(k);
 
+  // Everything the replicates need from the fitted model, in doubles, so that the
+  // replicates touch no dvariables
+  oper_proj<double> om;
+  om.set_sr(SrType,value(alpha),value(beta),value(phizero),value(Bzero),value(mean_log_rec));
+  dmatrix S_d(styr,endyr,1,nages);
+  dmatrix S_spawn(styr,endyr,1,nages);
+  dmatrix F_catch(styr,endyr,1,nages);     // F/Z (1-S): catch at age per number at age
+  for (i=styr;i<=endyr;i++)
+  {
+    S_d(i)     = value(S(i));
+    S_spawn(i) = pow(S_d(i),spmo_frac);
+    F_catch(i) = value(elem_prod(elem_div(Ftot(i),Z(i)),1.-S(i)));
+  }
+  d3_array S_ind(1,nind,styr,endyr,1,nages);  // survival to the time of the index
+  d3_array sel_ind_d(1,nind,styr,endyr,1,nages);
+  for (k=1;k<=nind;k++)
+    for (i=styr;i<=endyr;i++)
+    {
+      S_ind(k,i)     = pow(S_d(i),ind_month_frac(k));
+      sel_ind_d(k,i) = value(sel_ind(k,i));
+    }
+  d3_array sel_fsh_d(1,nfsh,styr,endyr,1,nages);
+  for (k=1;k<=nfsh;k++)
+    for (i=styr;i<=endyr;i++)
+      sel_fsh_d(k,i) = value(sel_fsh(k,i));
+
+  // Fmsy population, the same for all replicates
+  dvector ntmp_msy(1,nages);
+  dmatrix seltmp_d(1,nfsh,1,nages);
+  dmatrix Fatmp_d(1,nfsh,1,nages);
+  dvector Ztmp_d(1,nages);
+  seltmp_d.initialize();
+  Fatmp_d.initialize();
+  for (k=1;k<=nfsh;k++)
+   seltmp_d(k) = value(sel_fsh(k,endyr));
+  Ztmp_d = value(natmort(styr));
+  for (k=1;k<=nfsh;k++)
+  { 
+    Fatmp_d(k) = value(Fratio(k) * Fmsy * seltmp_d(k));
+    Ztmp_d    += Fatmp_d(k);
+  } 
+  dvector survmsy = exp(-Ztmp_d);
+  ntmp_msy(1) = value(Rmsy);
+  for (j=2;j<=nages;j++) 
+    ntmp_msy(j) = ntmp_msy(j-1)*survmsy(j-1);
+  ntmp_msy(nages) /= (1-survmsy(nages));
+  double q_ind_sim = value(mean(q_ind(1)));
+  dvector survey_msy = elem_prod(wt_ind(1,endyr),pow(survmsy,ind_month_frac(1))); // per number, before q and sel
+  double SurvBmsy_d = elem_prod(survey_msy,ntmp_msy) * q_ind_sim*sel_ind_d(1,endyr); 
+  double Cmsy_d     = value(yield(Fratio,  Fmsy));
+  double Rzero_d     = value(Rzero);
+  double Fmsy_d      = value(Fmsy);
+  double MSY_d       = value(MSY);
+  double Rmsy_d      = value(Rmsy);
+  double steepness_d = value(steepness);
+  double Bmsy_d      = value(Bmsy);
+  double MSYL_d      = value(MSYL);
+  double sigmar_d    = value(sigmar);
+  dvector natmort_d  = value(natmort);
+
+  // streams of this draw: replicate (mc_count-1)*nsims+isim (see rng-stream.h); the
+  // replicates build ADMB arrays throughout, so they run in order on this thread
+  unsigned long rep0 = (unsigned long)(mc_count-1)*nsims;
+  rng_service sim_rng(iseed);
   for (int isim=1;isim<=nsims;isim++)
   {
+    char buffer [33];
+    // copies in doubles under the names used in the truth() output
+    double Rzero     = Rzero_d;
+    double Fmsy      = Fmsy_d;
+    double MSY       = MSY_d;
+    double Rmsy      = Rmsy_d;
+    double steepness = steepness_d;
+    double Cmsy      = Cmsy_d;
+    double SurvBmsy  = SurvBmsy_d;
+    const dvector& natmort = natmort_d;
+    const dmatrix& seltmp  = seltmp_d;
+    const dmatrix& Fatmp   = Fatmp_d;
+    const dvector& Ztmp    = Ztmp_d;
+
+    dmatrix new_ind_sim(1,nind,1,nyrs_ind);
+    dvector sim_rec_devs(styr_rec,endyr);
+    dvector sim_Sp_Biom(styr_rec,endyr);
+    dmatrix sim_natage(styr_rec,endyr,1,nages);
+    dmatrix catagetmp(styr,endyr,1,nages);
+    dvector sim_catchbio(styr,endyr);
+    dmatrix act_eff(1,nfsh,styr,endyr);
     new_ind_sim.initialize();
     sim_natage.initialize();
     // Start w/ simulated population
     // Simulate using new recruit series (same F's)
     // fill vector with unit normal RVs
-    sim_rec_devs.fill_randn(rng);
-    sim_rec_devs *= value(sigmar);
-    sim_natage(styr_rec,1) = value(Rzero)*exp(sim_rec_devs(styr_rec));
+    sim_rng.stream(rep0+isim,0,RNG_REC_DEV).fill_randn(sim_rec_devs);
+    sim_rec_devs *= sigmar_d;
+    sim_natage(styr_rec,1) = Rzero*exp(sim_rec_devs(styr_rec));
     for (j=2; j<=nages; j++)
       sim_natage(styr_rec,j) = sim_natage(styr_rec,j-1) * survtmp;
     sim_natage(styr_rec,nages) /= (1.-survtmp); 
@@ -4320,21 +4873,18 @@ FUNCTION Write_SimDatafile
     {
       sim_Sp_Biom(i) = sim_natage(i)*pow(survtmp,spmo_frac) * wt_mature; 
       if (i>styr_rec+rec_age)
-        sim_natage(i,1)          = value(SRecruit(sim_Sp_Biom(i-rec_age)))*mfexp(sim_rec_devs(i)); 
+        sim_natage(i,1)          = om.recruit(sim_Sp_Biom(i-rec_age))*mfexp(sim_rec_devs(i)); 
       else
-        sim_natage(i,1)          = value(SRecruit(sim_Sp_Biom(i)))*mfexp(sim_rec_devs(i)); 
+        sim_natage(i,1)          = om.recruit(sim_Sp_Biom(i))*mfexp(sim_rec_devs(i)); 
   
       if (i>=styr)
       {
         // apply estimated survival rates
-        sim_Sp_Biom(i)          = value( elem_prod(sim_natage(i),pow(S(i),spmo_frac)) * wt_mature); 
-        catagetmp(i)            = value( elem_prod(elem_div(Ftot(i),Z(i)),elem_prod(1.-S(i),sim_natage(i))));
+        sim_Sp_Biom(i)          = elem_prod(sim_natage(i),S_spawn(i)) * wt_mature; 
+        catagetmp(i)            = elem_prod(F_catch(i),sim_natage(i));
         sim_catchbio(i)         = catagetmp(i)*wt_fsh(1,i);
         if (i<endyr)
-        {
-          sim_natage(i+1)(2,nages) = value( ++elem_prod(sim_natage(i)(1,nages-1),S(i)(1,nages-1)));
-          sim_natage(i+1,nages)   += value( sim_natage(i,nages)*S(i,nages));
-        }
+          om.graduate(sim_natage(i),S_d(i),sim_natage(i+1));
       }
       else
       {
@@ -4352,57 +4902,33 @@ FUNCTION Write_SimDatafile
     // Create the name of the simulated dataset
     // simname = "sim_"+ adstring(itoa(isim,buffer,10)) + ".dat";
     // truname = "tru_"+ adstring(itoa(isim,buffer,10)) + ".dat";
-		simname = "sim_"+ adstring(sprintf(buffer,"%d",isim)) + ".dat";
-    truname = "tru_"+ adstring(sprintf(buffer,"%d",isim)) + ".dat";
+    sprintf(buffer,"%d",isim);
+    adstring simname = "sim_"+ adstring(buffer) + ".dat";
+    adstring truname = "tru_"+ adstring(buffer) + ".dat";
     ofstream trudat(truname);
     truth(Rzero);
     truth(Fmsy);
     truth(MSY);
     dvector ntmp(1,nages);
-    dmatrix seltmp(1,nfsh,1,nages);
-    dmatrix Fatmp(1,nfsh,1,nages);
-    dvector Ztmp(1,nages);
-    seltmp.initialize();
-    Fatmp.initialize();
-    Ztmp.initialize();
-    ntmp.initialize();
-    for (k=1;k<=nfsh;k++)
-     seltmp(k) = value(sel_fsh(k,endyr));
-    Ztmp = value(natmort(styr));
-    for (k=1;k<=nfsh;k++)
-    { 
-      Fatmp(k) = value(Fratio(k) * Fmsy * seltmp(k));
-      Ztmp    += Fatmp(k);
-    } 
-    dvector survmsy = exp(-Ztmp);
-    ntmp(1) = value(Rmsy);
-    for (j=2;j<=nages;j++) 
-      ntmp(j) = ntmp(j-1)*survmsy(j-1);
-    ntmp(nages) /= (1-survmsy(nages));
+    ntmp = ntmp_msy;
     // dvariable phi    = elem_prod( ntmp , pow(survmsy,spmo_frac ) )* wt_mature;
     truth(Rmsy);
     truth(seltmp);
-    double SurvBmsy;
-    double q_ind_sim=value(mean(q_ind(1)));
-    SurvBmsy = value(elem_prod(wt_ind(1,endyr),elem_prod(pow(survmsy,ind_month_frac(1)), ntmp)) * q_ind_sim*sel_ind(1,endyr)); 
     truth(ntmp);
-    double Cmsy   = value(yield(Fratio,  Fmsy));
     truth(Cmsy);
     // Now do OFL for next year...
-    ntmp(1)       = value(SRecruit(sim_Sp_Biom(endyr+1-rec_age)));
-    ntmp(2,nages) = value( ++elem_prod(sim_natage(endyr)(1,nages-1),S(endyr)(1,nages-1)));
-    ntmp(nages)  += value( sim_natage(endyr,nages)*S(endyr,nages));
+    ntmp(1)       = om.recruit(sim_Sp_Biom(endyr+1-rec_age));
+    om.graduate(sim_natage(endyr),S_d(endyr),ntmp);
     dvector ctmp(1,nages);
     ctmp.initialize();
-    OFL=0.;
+    double OFL=0.;
     for (k=1;k<=nfsh;k++)
     {
       for ( j=1 ; j <= nages; j++ )
         ctmp(j)      = ntmp(j) * Fatmp(k,j) * (1. - survmsy(j)) / Ztmp(j);
       OFL  += wt_fsh(k,endyr) * ctmp;
     }
-    double NextSurv = value(elem_prod(wt_ind(1,endyr),elem_prod(pow(survmsy,ind_month_frac(1)), ntmp)) * 
-                        q_ind_sim*sel_ind(1,endyr)); 
+    double NextSurv = elem_prod(survey_msy, ntmp) * q_ind_sim*sel_ind_d(1,endyr); 
     double NextSSB  = elem_prod(ntmp, pow(survmsy,spmo_frac)) * wt_mature; 
     // Catch at following year for Fmsy
     truth(OFL);
@@ -4451,7 +4977,6 @@ FUNCTION Write_SimDatafile
     simdat << "# sample sizes for fishery age data " <<endl;
     for (k=1;k<=nfsh;k++)
     {
-      n_sample_fsh_age_sim(k) = mean(n_sample_fsh_age(k));
       simdat << "# " <<fshname(k)<< " " << k <<endl;
       simdat << n_sample_fsh_age_sim(k)         <<endl;    
     }
@@ -4467,12 +4992,9 @@ FUNCTION Write_SimDatafile
         int iyr = yrs_fsh_age_sim(k,i);
         // Add noise here
         freq.initialize();
-        ivector bin(1,n_sample_fsh_age_sim(k,i));
         p  = catagetmp(iyr);
         p /= sum(p);
-        bin.fill_multinomial(rng,p); // fill a vector v
-        for (int j=1;j<=n_sample_fsh_age_sim(k,i);j++)
-          freq(bin(j))++;
+        sim_rng.stream(rep0+isim,iyr,RNG_FSH_AGE+k).multinomial(n_sample_fsh_age_sim(k,i),p,freq);
         // Apply ageing error to samples..............
         // p = age_err *freq/sum(freq); 
         p = freq/sum(freq); 
@@ -4523,14 +5045,14 @@ FUNCTION Write_SimDatafile
       simdat << "# " <<indname(k)<< " " << k <<endl;
       // Add noise here
       // fill vector with unit normal RVs
-      ind_devs.fill_randn(rng);
+      sim_rng.stream(rep0+isim,0,RNG_IND_OBS+k).fill_randn(ind_devs(k));
       ind_devs(k) *= ind_sigma ;
       for (i=1;i<=nyrs_ind_sim(k);i++)
       {
         int iyr=yrs_ind_sim(k,i);
         //uncorrelated...corr_dev(k,i) = ac(k) * corr_dev(k,i-1) + sqrt(1.-square(ac(k))) * corr_dev(k,i);
-        new_ind_sim(k,i) = mfexp(ind_devs(k,i) - ind_sigma/2.) * value(elem_prod(wt_ind(k,iyr),elem_prod(pow(S(iyr),ind_month_frac(k)), 
-                        sim_natage(iyr))) * q_ind_sim*sel_ind(k,iyr)); 
+        new_ind_sim(k,i) = mfexp(ind_devs(k,i) - ind_sigma/2.) * (elem_prod(wt_ind(k,iyr),elem_prod(S_ind(k,iyr), 
+                        sim_natage(iyr))) * q_ind_sim*sel_ind_d(k,iyr)); 
       }
       simdat << new_ind_sim(k)     <<endl;
       dvector ExactSurvey = elem_div(new_ind_sim(k),exp(ind_devs(k)-ind_sigma/2.));
@@ -4558,7 +5080,6 @@ FUNCTION Write_SimDatafile
     simdat << "# Sample sizes for age data from indices" <<endl;
     for (k=1;k<=nind;k++)
     {
-      n_sample_ind_age_sim(k) = mean(n_sample_ind_age(k));
       simdat << "# " <<indname(k)<< endl;
       simdat << n_sample_ind_age_sim(k) <<endl;
     }
@@ -4573,14 +5094,11 @@ FUNCTION Write_SimDatafile
         int iyr = yrs_ind_age_sim(k,i);
         // Add noise here
         freq.initialize();
-        ivector bin(1,n_sample_ind_age_sim(k,i));
         // p = age_err * value(elem_prod( elem_prod(pow(S(iyr),ind_month_frac(k)), sim_natage(iyr))*q_ind_sim , sel_ind(k,iyr))); 
-        p = value(elem_prod( elem_prod(pow(S(iyr),ind_month_frac(k)), sim_natage(iyr))*q_ind_sim , sel_ind(k,iyr))); 
+        p = elem_prod( elem_prod(S_ind(k,iyr), sim_natage(iyr))*q_ind_sim , sel_ind_d(k,iyr)); 
         p /= sum(p);
-        // fill vector with multinomial samples
-        bin.fill_multinomial(rng,p); // fill a vector v
-        for (int j=1;j<=n_sample_ind_age_sim(k,i);j++)
-          freq(bin(j))++;
+        // multinomial counts by age
+        sim_rng.stream(rep0+isim,iyr,RNG_IND_AGE+k).multinomial(n_sample_ind_age_sim(k,i),p,freq);
         simdat << "# " <<indname(k)<< " year: "<< iyr<< endl;
         simdat << freq/sum(freq) <<endl;
       }
@@ -4611,13 +5129,13 @@ FUNCTION Write_SimDatafile
     {
       dvector ran_fsh_vect(styr,endyr);
       // fill vector with unit normal RVs
-      ran_fsh_vect.fill_randn(rng);
+      sim_rng.stream(rep0+isim,0,RNG_EFFORT+k).fill_randn(ran_fsh_vect);
       // Sigma on effort is ~15% white noise (add red noise later)
       ran_fsh_vect *= 0.15; 
       dvector avail_biom(styr,endyr);
       for (i=styr;i<=endyr;i++)
       {
-        avail_biom(i) = wt_fsh(k,i)*value(elem_prod(sim_natage(i),sel_fsh(k,i))); 
+        avail_biom(i) = wt_fsh(k,i)*elem_prod(sim_natage(i),sel_fsh_d(k,i)); 
       }
       act_eff(k) = elem_prod(exp(ran_fsh_vect), (elem_div(catch_bio(k), avail_biom)) );
       // Normalize effort
@@ -4634,10 +5152,8 @@ FUNCTION Write_SimDatafile
         simdat<<fshname(k)<<" "<<yrs_fsh_age(k,i)<<" "<<catagetmp(yrs_fsh_age(k,i)) <<endl;
     }
     // Write simple file by simulation
-    dmatrix ExactSurvey(1,nind,1,nyrs_ind) ;
     for (k=1;k<=nind;k++)
     {
-      ExactSurvey(k) = elem_div(new_ind_sim(k),exp(ind_devs(k)-ind_sigma/2.));
       for (i=1;i<=nyrs_ind(k);i++)
       {
         SimDB<<model_name<<" simIndex "<<isim<<" "<< yrs_ind_sim(k,i) <<" "<< 
@@ -4648,7 +5164,6 @@ FUNCTION Write_SimDatafile
       
     for (k=1;k<=nfsh;k++)
     {
-      ExactSurvey(k) = elem_div(new_ind_sim(k),exp(ind_devs(k)-ind_sigma/2.));
       for (i=styr;i<=endyr;i++)
       {
        SimDB<<model_name<<" simCatch "<<isim<<" "<< i<<" "<< sim_catchbio(i)       <<" "<< endl;
@@ -4657,20 +5172,20 @@ FUNCTION Write_SimDatafile
         sim_natage(i,1)      <<" "<< 
         sim_Sp_Biom(i)       <<" "<< 
         steepness            <<" "<< 
-        Bmsy                 <<" "<< 
-        MSYL                 <<" "<< 
+        Bmsy_d               <<" "<< 
+        MSYL_d               <<" "<< 
         MSY                  <<" "<< 
         SurvBmsy             <<" "<<
         endl;
     }
     TruDB<<model_name<<" "<<isim<<" "<< endyr+1<<" "<<
         OFL                  <<" "<< 
-        SRecruit(sim_Sp_Biom(endyr+1-rec_age))<<" "<<
+        om.recruit(sim_Sp_Biom(endyr+1-rec_age))<<" "<<
         sim_Sp_Biom(endyr)   <<" "<< 
         NextSurv             <<" "<< 
         steepness            <<" "<< 
-        Bmsy                 <<" "<< 
-        MSYL                 <<" "<< 
+        Bmsy_d               <<" "<< 
+        MSYL_d               <<" "<< 
         MSY                  <<" "<< 
         SurvBmsy             <<" "<<
         endl;
@@ -4693,6 +5208,10 @@ FUNCTION Write_Datafile
   // compute the autocorrelation term for residuals of fit to indices...
   for (k=1;k<=nind;k++)
     ac(k) = get_AC(k);
+  // Streams with purposes of their own (RNG_BOOT_*), so the deviates differ from those of
+  // Write_SimDatafile; replicates numbered across mceval draws as there (see rng-stream.h)
+  unsigned long rep0 = (unsigned long)(mc_count-1)*nsims;
+  rng_service sim_rng(iseed);
   for (int isim=1;isim<=nsims;isim++)
   {
     // Create the name of the simulated dataset
@@ -4753,12 +5272,9 @@ FUNCTION Write_Datafile
         int iyr = yrs_fsh_age(k,i);
         // Add noise here
         freq.initialize();
-        ivector bin(1,n_sample_fsh_age(k,i));
         p  = value(catage(k,iyr));
         p /= sum(p);
-        bin.fill_multinomial(rng,p); // fill a vector v
-        for (int j=1;j<=n_sample_fsh_age(k,i);j++)
-          freq(bin(j))++;
+        sim_rng.stream(rep0+isim,iyr,RNG_BOOT_FSH_AGE+k).multinomial((int)n_sample_fsh_age(k,i),p,freq);
         // Apply ageing error to samples..............
         p = age_err *freq/sum(freq); 
         // cout << p  <<endl;
@@ -4804,7 +5320,7 @@ FUNCTION Write_Datafile
       // Add noise here
       dvector ran_ind_vect(1,nyrs_ind(k));
       // fill vector with unit normal RVs
-      ran_ind_vect.fill_randn(rng);
+      sim_rng.stream(rep0+isim,0,RNG_BOOT_IND_OBS+k).fill_randn(ran_ind_vect);
       // do first year uncorrelated
       i=1;
       int iyr=yrs_ind(k,i);
@@ -4858,13 +5374,10 @@ FUNCTION Write_Datafile
         int iyr = yrs_ind_age(k,i);
         // Add noise here
         freq.initialize();
-        ivector bin(1,n_sample_ind_age(k,i));
         p = age_err * value(elem_prod( elem_prod(pow(S(iyr),ind_month_frac(k)), natage(iyr))*q_ind(k,i) , sel_ind(k,iyr))); 
         p /= sum(p);
-        // fill vector with multinomial samples
-        bin.fill_multinomial(rng,p); // fill a vector v
-        for (int j=1;j<=n_sample_ind_age(k,i);j++)
-          freq(bin(j))++;
+        // multinomial counts by age
+        sim_rng.stream(rep0+isim,iyr,RNG_BOOT_IND_AGE+k).multinomial((int)n_sample_ind_age(k,i),p,freq);
         simdat << "# " <<indname(k)<< " year: "<< iyr<< endl;
         simdat << freq/sum(freq) <<endl;
       }
@@ -4895,7 +5408,7 @@ FUNCTION Write_Datafile
     {
       dvector ran_fsh_vect(styr,endyr);
       // fill vector with unit normal RVs
-      ran_fsh_vect.fill_randn(rng);
+      sim_rng.stream(rep0+isim,0,RNG_BOOT_EFFORT+k).fill_randn(ran_fsh_vect);
       // Sigma on effort is ~15% white noise (add red noise later)
       ran_fsh_vect *= 0.15; 
       dvector avail_biom(styr,endyr);
@@ -4981,7 +5494,7 @@ FUNCTION Write_R
     R_report<<i<<" "<<totbiom(i)<<" "<<totbiom.sd(i)<<" "<<lb<<" "<<ub<<endl;
   }
 
-  for (k=1;k<=5;k++){
+  for (k=1;k<=nscen_proj;k++){
     R_report<<"$SSB_fut_"<<k<<endl; 
     for (i=styr_fut;i<=endyr_fut;i++) 
     {
@@ -4991,11 +5504,11 @@ FUNCTION Write_R
     }
   }
   double ctmp;
-  for (k=1;k<=5;k++){
+  for (k=1;k<=nscen_proj;k++){
     R_report<<"$Catch_fut_"<<k<<endl; 
     for (i=styr_fut;i<=endyr_fut;i++) 
     {
-      if (k==5) ctmp=0.;else ctmp=value(catch_future(k,i));
+      ctmp=value(catch_future(k,i));
       R_report<<i<<" "<<ctmp<<endl;
     }
   }
@@ -5578,6 +6091,8 @@ FUNCTION Write_R
   M = mtmp;
   R_Report(F40_est);
   R_Report(F35_est);      
+  R_Report(msy_iter);     // Newton iterations of the last Fmsy search
+  R_Report(spr_iter);     // Newton iterations for F35%, F50% and F40%
 
   R_report<<"$sumBiom"<<endl; 
   for (i=styr;i<=endyr+1;i++) 
@@ -5587,6 +6102,8 @@ FUNCTION Write_R
     R_report<<i<<" "<<sumBiom(i)<<" "<<sumBiom.sd(i)<<" "<<lb<<" "<<ub<<endl;
   }
   R_Report(tau);      
+  if (do_logistic_normal) R_Report(rho_ln);
+  if (do_dirichlet_multinomial) { R_Report(log_dm_theta_fsh); R_Report(log_dm_theta_ind); }
 
   R_report.close();
 
@@ -5718,8 +6235,26 @@ FUNCTION double get_AC(const int& indind)
 
  
 GLOBALS_SECTION
-  //#include <logistic-normal.h>
   #include <admodel.h>  
+  #include "logistic-normal.cpp" // logistic-normal composition likelihood (-ln option)
+  logistic_normal_engine ln_engine; // all composition sources, set up in PRELIMINARY_CALCS
+  #include "dirichlet-multinomial.cpp" // Dirichlet-multinomial composition likelihood (-dm option)
+  #include <per-recruit.cpp> // per-recruit quantities over a vector of F, in doubles (em_input/common, shared with ASAP)
+  #include "age-length-key.cpp" // age-length key: shared bin edges, constant or with one adjoint
+  age_length_key alk; // bins set in DATA_SECTION
+  #include "oper-proj.cpp" // one-year projection steps, templated on double (Oper_Model) and dvariable
+  #include "proj-scenarios.cpp" // future projection scenarios, each with its own state
+  #include "hcr.cpp" // harvest control rules for Oper_Model: file protocol or in-process (-hcr)
+  hcr_registry hcr_rules; // in-process rules by cmp_no
+  #include "rng-stream.cpp" // counter-based random streams by (seed, replicate, year, purpose)
+  #include "replicate-pool.cpp" // runs simulation replicates on n_threads threads (-nthreads option)
+  #include "warm-start.cpp" // parameter values of a previous fit, matched by label and year (-wst option)
+  warm_start wst;
+  #include <sstream>
+  std::vector<dirichlet_multinomial> dm_fsh_age;    // one per fishery, set up in PRELIMINARY_CALCS
+  std::vector<dirichlet_multinomial> dm_fsh_length;
+  std::vector<dirichlet_multinomial> dm_ind_age;    // one per index
+  std::vector<dirichlet_multinomial> dm_ind_length;
 	#undef write_SIS_rep 
   /// Writes SIS report objects
 	#define write_SIS_rep(object) SIS_rep << #object "\n" << object << endl;
@@ -5751,6 +6286,9 @@ GLOBALS_SECTION
   adstring projfile_name;
   adstring datafile_name;
   adstring cntrlfile_name;
+  adstring scenfile_name;
+  adstring wstfile_name;
+  adstring rtabfile_name;
   adstring tmpstring;
   adstring repstring;
   adstring version_info;
@@ -0,0 +1,176 @@
+#include <admodel.h>
+#include "dirichlet-multinomial.h"
+
+dirichlet_multinomial::~dirichlet_multinomial()
+{}
+
+dirichlet_multinomial::dirichlet_multinomial()
+{}
+
+dirichlet_multinomial::dirichlet_multinomial(const dmatrix& _O, const dvector& _N)
+{
+	/*
+	O - observed numbers-at-age or proportions-at-age.
+	N - input sample size for each year (row of O).
+
+	Matrix rows correspond to years, cols age or length bins.
+	Everything that depends on the data only is computed here, once.
+	*/
+	m_b1 = _O.colmin();
+	m_b2 = _O.colmax();
+	m_B  = m_b2 - m_b1 + 1;
+
+	m_y1 = _O.rowmin();
+	m_y2 = _O.rowmax();
+
+	m_dN.allocate(m_y1,m_y2);
+	m_dX.allocate(m_y1,m_y2,m_b1,m_b2);
+	m_dConst.allocate(m_y1,m_y2);
+
+	for(int i = m_y1; i <= m_y2; i++ )
+	{
+		m_dN(i)     = _N(i);
+		m_dX(i)     = _N(i) * _O(i) / sum( _O(i) );
+		m_dConst(i) = gammln(m_dN(i) + 1.0);
+		for(int j = m_b1; j <= m_b2; j++ )
+		{
+			m_dConst(i) -= gammln(m_dX(i,j) + 1.0);
+		}
+	}
+}
+
+
+/*
+	Digamma function for x > 0: recurrence up to x >= 6, then the
+	asymptotic series.
+*/
+static double dm_digamma(double x)
+{
+	double r = 0;
+	while( x < 6.0 )
+	{
+		r -= 1.0 / x;
+		x += 1.0;
+	}
+	double f = 1.0 / (x * x);
+	return r + log(x) - 0.5 / x
+	         - f * (1.0/12 - f * (1.0/120 - f * (1.0/252 - f * (1.0/240 - f * (1.0/132)))));
+}
+
+/* Elementwise digamma, for a row of bins at a time. */
+static dvector dm_digamma(const dvector& x)
+{
+	dvector r(x.indexmin(),x.indexmax());
+	for(int j = x.indexmin(); j <= x.indexmax(); j++ )
+	{
+		r(j) = dm_digamma(x(j));
+	}
+	return(r);
+}
+
+
+/*
+	Negative loglikelihood for the whole composition matrix.
+
+	With sample size N, observed counts x_j = N O_j, expected proportions
+	p_j = 0.9999 E_j/sum(E) + 0.0001/B (kept away from zero) and
+	alpha_j = theta N p_j,
+
+		-nll_i = lgamma(N+1) - sum lgamma(x_j+1)
+		       + lgamma(theta N) - lgamma(N + theta N)
+		       + sum [ lgamma(x_j + alpha_j) - lgamma(alpha_j) ]
+
+	The first line is cached by the constructor.  The rest is evaluated in
+	doubles and a single adjoint is pushed onto the gradient stack, with
+	partials from the digamma function psi:
+
+		d nll / d p_j    = -theta N [psi(x_j + alpha_j) - psi(alpha_j)]
+		d nll / d theta  = -N [psi(theta N) - psi(N + theta N)]
+		                   - sum N p_j [psi(x_j + alpha_j) - psi(alpha_j)]
+
+	Cells with x_j = 0 contribute nothing and are skipped.  The effective
+	sample size implied by theta is (1 + theta N)/(1 + theta).
+*/
+static void dfdirichlet_multinomial_nll(void);
+
+dvariable dirichlet_multinomial::negative_loglikelihood(const dvar_matrix& _E,
+                                                        const dvariable& theta)
+{
+	double th     = value(theta);
+	double nll    = 0;
+	double dtheta = 0;
+
+	dmatrix dE(m_y1,m_y2,m_b1,m_b2);		// d nll / d E
+	dvector g(m_b1,m_b2);					// d nll / d p
+
+	int i,j;
+	for( i = m_y1; i <= m_y2; i++ )
+	{
+		double  N  = m_dN(i);
+		double  tN = th * N;
+		dvector e  = value(_E(i));
+		double  S  = sum(e);
+
+		nll    -= m_dConst(i) + gammln(tN) - gammln(N + tN);
+		dtheta -= N * (dm_digamma(tN) - dm_digamma(N + tN));
+
+		dvector p     = 0.9999 / S * e + 0.0001 / m_B;
+		dvector alpha = tN * p;
+		dvector dpsi  = dm_digamma(m_dX(i) + alpha) - dm_digamma(alpha);
+
+		double ge = 0;						// sum g_j e_j
+		for( j = m_b1; j <= m_b2; j++ )
+		{
+			double x = m_dX(i,j);
+			g(j) = 0;
+			if( x > 0 )
+			{
+				nll    -= gammln(x + alpha(j)) - gammln(alpha(j));
+				dtheta -= N * p(j) * dpsi(j);
+				g(j)    = -tN * dpsi(j);
+				ge     += g(j) * e(j);
+			}
+		}
+
+		// chain rule through the normalisation p_j = 0.9999 E_j/S + c
+		for( j = m_b1; j <= m_b2; j++ )
+		{
+			dE(i,j) = 0.9999 / S * (g(j) - ge / S);
+		}
+	}
+
+	dvariable vnll = nograd_assign(nll);
+
+	save_identifier_string("dm_nll1");
+	theta.save_prevariable_position();
+	_E.save_dvar_matrix_position();
+	dE.save_dmatrix_value();
+	dE.save_dmatrix_position();
+	save_double_value(dtheta);
+	vnll.save_prevariable_position();
+	save_identifier_string("dm_nll2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dfdirichlet_multinomial_nll);
+
+	return(vnll);
+}
+
+/*
+	Adjoint of negative_loglikelihood: restores the saved partials (in reverse
+	order of saving) and scales them by the derivative of the result.
+*/
+static void dfdirichlet_multinomial_nll(void)
+{
+	verify_identifier_string("dm_nll2");
+	prevariable_position nllpos   = restore_prevariable_position();
+	double dfnll                  = restore_prevariable_derivative(nllpos);
+	double dtheta                 = restore_double_value();
+	dmatrix_position dEpos        = restore_dmatrix_position();
+	dmatrix dE                    = restore_dmatrix_value(dEpos);
+	dvar_matrix_position Epos     = restore_dvar_matrix_position();
+	prevariable_position thetapos = restore_prevariable_position();
+	verify_identifier_string("dm_nll1");
+
+	dE *= dfnll;
+	dE.save_dmatrix_derivatives(Epos);
+	save_double_derivative(dfnll * dtheta, thetapos);
+}
@@ -0,0 +1,35 @@
+/**
+	This is a class for implementing the Dirichlet-multinomial negative
+	loglikelihood (linear parameterization) for composition data.
+*/
+
+#include <admodel.h>
+
+#ifndef DIRICHLET_MULTINOMIAL_H
+#define DIRICHLET_MULTINOMIAL_H
+
+class dirichlet_multinomial
+{
+private:
+	int         m_b1;
+	int         m_b2;
+	int         m_B;
+
+	int         m_y1;
+	int         m_y2;
+
+	dvector     m_dN;		// Input sample size for each year.
+	dmatrix     m_dX;		// Observed counts, N times the proportions.
+	dvector     m_dConst;	// Data-only terms lgamma(N+1) - sum(lgamma(x+1)).
+
+public:
+	~dirichlet_multinomial();
+	dirichlet_multinomial();
+	dirichlet_multinomial(const dmatrix& _O, const dvector& _N);
+
+	/* data */
+	dvariable negative_loglikelihood(const dvar_matrix& _E, const dvariable& theta);
+};
+
+
+#endif
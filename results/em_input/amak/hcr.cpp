@@ -0,0 +1,162 @@
+#include <admodel.h>
+#include "hcr.h"
+
+hcr::hcr(int _cmp)
+: m_cmp(_cmp)
+{}
+
+hcr::~hcr()
+{}
+
+void hcr::taken(double C)
+{}
+
+int hcr::cmp() const
+{
+	return m_cmp;
+}
+
+int hcr::nobs() const
+{
+	return (int)m_vIndex.size();
+}
+
+double hcr::latest() const
+{
+	return m_vIndex.empty() ? 0. : m_vIndex.back();
+}
+
+
+hcr_file::hcr_file(int _cmp)
+: hcr(_cmp), m_dCatch(0)
+{}
+
+
+void hcr_file::start()
+{
+	// Copy file to get mean for Mgt Strategies
+	system("init_stuff.bat");
+	ifstream tacin("ctac.dat");
+	int nobstmp;
+	tacin >> nobstmp;
+	dvector t_tmp(1,nobstmp);
+	tacin >> t_tmp;
+	tacin.close();
+	m_vIndex.clear();
+	for(int i = 1; i <= nobstmp; i++ )
+		m_vIndex.push_back(t_tmp(i));
+}
+
+
+double hcr_file::tac(double new_index)
+{
+	/*
+	ctac.dat is read back each year, since the external programs may
+	change it.
+	*/
+	ifstream tacin("ctac.dat");
+	int nobstmp;
+	tacin >> nobstmp;
+	dvector t_tmp(1,nobstmp);
+	tacin >> t_tmp;
+	tacin.close();
+	ofstream octac("ctac.dat");
+	octac << nobstmp+1 << endl;
+	octac << t_tmp << endl;
+	octac << new_index << endl;
+	octac.close();
+	m_vIndex.clear();
+	for(int i = 1; i <= nobstmp; i++ )
+		m_vIndex.push_back(t_tmp(i));
+	m_vIndex.push_back(new_index);
+
+	adstring cmd = adstring("ComputeTAC.bat ") + itoa(m_cmp,10);
+	system(cmd);	// commandline function to get TAC (CatchNext.dat)
+	ifstream CatchNext("CatchNext.dat");
+	CatchNext >> m_dCatch;
+	CatchNext.close();
+	return m_dCatch;
+}
+
+
+void hcr_file::taken(double C)
+{
+	if( C != m_dCatch )
+	{
+		ofstream cnext("CatchNext.dat");
+		cnext << C << endl;
+		cnext.close();
+	}
+}
+
+
+hcr_index_mean::hcr_index_mean(int _cmp, const dvector& _index0, double _M, double _mult, int _nyrs)
+: hcr(_cmp), m_dM(_M), m_dMult(_mult), m_nYrs(_nyrs)
+{
+	m_dIndex0.allocate(_index0.indexmin(),_index0.indexmax());
+	m_dIndex0 = _index0;
+}
+
+
+void hcr_index_mean::start()
+{
+	m_vIndex.clear();
+	for(int i = m_dIndex0.indexmin(); i <= m_dIndex0.indexmax(); i++ )
+		m_vIndex.push_back(m_dIndex0(i));
+}
+
+
+double hcr_index_mean::tac(double new_index)
+{
+	m_vIndex.push_back(new_index);
+	int n  = (int)m_vIndex.size();
+	int n1 = n > m_nYrs ? n - m_nYrs : 0;
+	double sum = 0;
+	for(int i = n1; i < n; i++ )
+		sum += m_vIndex[i];
+	return m_dMult * m_dM * sum / (n - n1);
+}
+
+
+/*
+	In-process versions of the index-based procedures 5 and 6 (natural
+	mortality times the mean of the last three index values, and 75% of
+	that).  More rules are added with hcr_registry::add().
+*/
+static hcr* hcr_make_5(int cmp_no, const hcr_setup& setup)
+{
+	return new hcr_index_mean(cmp_no, setup.index, setup.M, 1.0, 3);
+}
+
+static hcr* hcr_make_6(int cmp_no, const hcr_setup& setup)
+{
+	return new hcr_index_mean(cmp_no, setup.index, setup.M, 0.75, 3);
+}
+
+
+hcr_registry::hcr_registry()
+{
+	add(5, hcr_make_5);
+	add(6, hcr_make_6);
+}
+
+
+void hcr_registry::add(int cmp_no, hcr_factory f)
+{
+	m_rules[cmp_no] = f;
+}
+
+
+bool hcr_registry::has(int cmp_no) const
+{
+	return m_rules.find(cmp_no) != m_rules.end();
+}
+
+
+hcr* hcr_registry::create(int cmp_no, const hcr_setup& setup) const
+{
+	std::map<int,hcr_factory>::const_iterator it = m_rules.find(cmp_no);
+	if( it == m_rules.end() )
+		return new hcr_file(cmp_no);
+	return (it->second)(cmp_no, setup);
+}
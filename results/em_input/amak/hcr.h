@@ -0,0 +1,104 @@
+/**
+	Harvest control rules (management procedures) for the operating model.
+
+	Each simulated year Oper_Model passes the rule a new index observation
+	and gets back the catch for the year.  A rule keeps the index series it
+	has seen, from the observed series at the start of each simulation.
+
+	hcr_file is the original protocol with external programs: the series
+	is kept in ctac.dat, init_stuff.bat resets it at the start of each
+	simulation and "ComputeTAC.bat cmp_no" leaves the catch in
+	CatchNext.dat.  With the -hcr option the rules in hcr_registry run
+	in-process instead, keyed by the candidate management procedure number
+	(cmp_no), so the nsims by projection years loop does not start any
+	processes.  Numbers with no in-process rule use the file protocol.
+*/
+
+#include <admodel.h>
+#include <map>
+#include <vector>
+
+#ifndef HCR_H
+#define HCR_H
+
+class hcr
+{
+protected:
+	int                 m_cmp;
+	std::vector<double> m_vIndex;	// Index series seen by the rule, oldest first.
+
+public:
+	hcr(int _cmp);
+	virtual ~hcr();
+
+	/* start of a simulation */
+	virtual void   start() = 0;
+	/* add this year's index observation and return the catch for the year */
+	virtual double tac(double new_index) = 0;
+	/* the catch actually taken, after any cap applied by the caller */
+	virtual void   taken(double C);
+
+	/* getters */
+	int    cmp() const;
+	int    nobs() const;
+	double latest() const;
+};
+
+
+/* the ctac.dat / ComputeTAC.bat / CatchNext.dat protocol */
+class hcr_file : public hcr
+{
+private:
+	double      m_dCatch;	// Catch read from CatchNext.dat.
+
+public:
+	hcr_file(int _cmp);
+
+	void   start();
+	double tac(double new_index);
+	void   taken(double C);
+};
+
+
+/* catch = mult x M x mean of the last nyrs index observations */
+class hcr_index_mean : public hcr
+{
+private:
+	dvector     m_dIndex0;	// Observed index series.
+	double      m_dM;
+	double      m_dMult;
+	int         m_nYrs;
+
+public:
+	hcr_index_mean(int _cmp, const dvector& _index0, double _M, double _mult, int _nyrs);
+
+	void   start();
+	double tac(double new_index);
+};
+
+
+/* what a rule may be built from */
+struct hcr_setup
+{
+	dvector index;		// Observed index series (first index).
+	double  M;			// Natural mortality used by the index-based rules.
+};
+
+typedef hcr* (*hcr_factory)(int cmp_no, const hcr_setup& setup);
+
+class hcr_registry
+{
+private:
+	std::map<int,hcr_factory> m_rules;
+
+public:
+	hcr_registry();
+
+	void add(int cmp_no, hcr_factory f);
+	bool has(int cmp_no) const;
+	/* new rule for cmp_no, the file protocol if none is registered; the caller deletes it */
+	hcr* create(int cmp_no, const hcr_setup& setup) const;
+};
+
+
+#endif
@@ -1,5 +1,5 @@
 #include <admodel.h>
-#include <logistic-normal.h>
+#include "logistic-normal.h"
 
 logistic_normal::~logistic_normal()
 {}
@@ -7,14 +7,29 @@ logistic_normal::~logistic_normal()
 logistic_normal::logistic_normal()
 {}
 
+logistic_normal::logistic_normal(const dmatrix& _O)
+: m_O(_O)
+{
+	set_observed();
+}
+
 logistic_normal::logistic_normal(const dmatrix& _O, const dvar_matrix& _E)
-: m_O(_O), m_E(_E)
+: m_O(_O)
+{
+	set_observed();
+	set_expected(_E);
+}
+
+
+void logistic_normal::set_observed()
 {
 	/*
 	O - observed numbers-at-age or proportions-at-age.
-	E - expected numbers-at-age or porportions-at-age.
 
 	Matrix rows correspond to years, cols age or length bins.
+	Only the data side is set up here; call set_expected() with the
+	expected numbers-at-age or proportions-at-age before each
+	negative_loglikelihood().
 	*/
 	m_b1 = m_O.colmin();
 	m_b2 = m_O.colmax();
@@ -28,20 +43,12 @@ logistic_normal::logistic_normal(const dmatrix& _O, const dvar_matrix& _E)
 	m_dWy.initialize();
 
 	m_Op.allocate(m_y1,m_y2,m_b1,m_b2);
-	m_Ep.allocate(m_y1,m_y2,m_b1,m_b2);
-	m_Ox.allocate(m_y1,m_y2,m_b1,m_b2);
-	m_Ex.allocate(m_y1,m_y2,m_b1,m_b2);
 
 	int i;
 	for( i = m_y1; i <= m_y2; i++ )
 	{
 		// Ensure proportions-at-age/size sume to 1.
 		m_Op(i) = m_O(i) / sum( m_O(i) );
-		m_Ep(i) = m_E(i) / sum( m_E(i) );
-
-		// Logistic transformation
-		m_Ox(i) = exp(m_Op(i)) / sum(exp(m_Op(i)));
-		m_Ex(i) = exp(m_Ep(i)) / sum(exp(m_Ep(i)));
 	}
 	
 	// Calculate mean weighting parameters for each year.
@@ -55,45 +62,210 @@ logistic_normal::logistic_normal(const dmatrix& _O, const dvar_matrix& _E)
 	aggregate_arrays();
 }
 
+void logistic_normal::set_MinimumProporiton(double &p)
+{
+	m_dMinimumProportion = p;
+	aggregate_arrays();
+}
 
-dvariable logistic_normal::negative_loglikelihood(const dvariable& tau2)
+
+void logistic_normal::set_expected(const dvar_matrix& _E)
 {
-	m_nll = 0;
+	/*
+		Per-evaluation update: gather the expected values into m_Ea through
+		the bin map built by aggregate_arrays().  No normalisation is needed,
+		because the likelihood only uses log(Ea_j/Ea_nB) within a year, which
+		does not change when a row of E is rescaled.
+	*/
+	for(int i = m_y1; i <= m_y2; i++ )
+	{
+		int last = 0;
+		for(int j = m_b1; j <= m_b2; j++ )
+		{
+			int k = m_nBinMap(i,j);
+			if( k != last )
+			{
+				m_Ea(i,k) = _E(i,j);
+				last = k;
+			}
+			else
+			{
+				m_Ea(i,k) += _E(i,j);
+			}
+		}
+	}
+}
 
-	int i;
-	dvariable m_sig2=tau2;
 
+/*
+	Negative loglikelihood for the whole (ragged) composition matrix in one pass,
+	in doubles, together with its closed-form partial derivatives.
+
+	For year i with nB aggregated bins, n = nB-1 and the additive log-ratio
+	residuals w_j = log(Oa_j/Oa_nB) - log(Ea_j/Ea_nB), j = 1..n, the residuals
+	have covariance (tau2/Wy) R, where R is the AR(1) correlation rho^|j-k|
+	across bins (rho = 0 gives the i.i.d. case):
+
+		nll_i = 0.5 n log(2 PI) + sum(log Oa) + n log(nB tau2) + n log(Wy)
+		      + 0.5 (n-1) log(1-rho^2) + 0.5 Wy Q / tau2
+
+	(the i.i.d. determinant term 0.5 log((nB tau2)^(2n)) is taken in log form).
+	Q = w' R^-1 w is computed through the inverse Cholesky factor of R, which
+	for AR(1) is bidiagonal and the same for every year:
+
+		e_1 = w_1,   e_j = (w_j - rho w_{j-1}) / sqrt(1-rho^2),   Q = sum e^2
+
+	so no dense matrix is formed and the cost is linear in the number of bins
+	(the code keeps w_j - rho w_{j-1} unscaled and multiplies by 1/(1-rho^2)).
+	The data-only terms and log(Oa_j/Oa_nB) come from aggregate_arrays().
+
+	ARGUMENTS
+		sig2, rho - variance and AR(1) correlation
+		dEa       - (output) d nll / d m_Ea, allocated like m_Ea
+		dsig2     - (output) d nll / d sig2
+		drho      - (output) d nll / d rho
+*/
+double logistic_normal::evaluate(double sig2, double rho, dmatrix& dEa,
+                                 double& dsig2, double& drho)
+{
+	double c     = 1.0 / (1.0 - rho * rho);
+	double ldetc = log(1.0 - rho * rho);
+	double nll   = 0;
+	dsig2        = 0;
+	drho         = 0;
+
+	dEa.allocate(m_y1,m_y2,1,m_nNminp);
+	dvector e(1,m_B);						// rows of the bidiagonal solve
+
+	int i,j;
 	for( i = m_y1; i <= m_y2; i++ )
-	{	
-		int    nB     = m_nNminp(i);
-		double t1     = 0.5 * (nB - 1.0) * log(2.0*PI);
-		double t3     = sum( log(m_Oa(i)) );
-		dvariable det = pow(nB * m_sig2, 2.*(nB-1.));
-		dvariable t5  = 0.5 * log(det);
-		dvar_vector w = log(m_Oa(i)(1,nB-1)/m_Oa(i,nB))
-		               -log(m_Ea(i)(1,nB-1)/m_Ea(i,nB));
-		double t7     = (nB - 1.0) * log(m_dWy(i));
-		dvariable t9  = 0.5 * sum( square(w) / (m_sig2/m_dWy(i)) );
-		
-		m_nll        += t1 + t3 + t5 + t7 + t9;
+	{
+		int    nB  = m_nNminp(i);
+		int    n   = nB - 1;
+		double wy  = m_dWy(i);
+		dvector ea = value(m_Ea(i));
+		double lEB = log(ea(nB));
+		dvector& w = dEa(i);				// residuals, overwritten below
+
+		double q   = 0;						// w' R^-1 w
+		double dq  = 0;						// dq / drho
+		for( j = 1; j <= n; j++ )
+		{
+			w(j) = m_dLogOr(i,j) - log(ea(j)) + lEB;
+			if( j == 1 )
+			{
+				e(j) = w(j);
+				q   += e(j) * e(j);
+			}
+			else
+			{
+				e(j) = w(j) - rho * w(j-1);
+				q   += c * e(j) * e(j);
+				dq  += -2.0 * c * e(j) * w(j-1) + 2.0 * rho * c * c * e(j) * e(j);
+			}
+		}
+
+		// g_j = d nll / d w_j, then chain rule through w_j to Ea_j and Ea_nB
+		double a   = wy / sig2;
+		double sg  = 0;
+		for( j = 1; j <= n; j++ )
+		{
+			double dqdw = (j == 1 ? 2.0 * e(j) : 2.0 * c * e(j));
+			if( j < n ) dqdw -= 2.0 * rho * c * e(j+1);
+			double g    = 0.5 * a * dqdw;
+			sg         += g;
+			w(j)        = -g / ea(j);
+		}
+		dEa(i,nB) = sg / ea(nB);
+
+		double t5  = n * log(nB * sig2);
+		double t9  = 0.5 * a * q;
+		nll       += m_dConst(i) + t5 + t9;
+		dsig2     += n / sig2 - t9 / sig2;
+		if( n > 1 )
+		{
+			nll   += 0.5 * (n - 1) * ldetc;
+			drho  += -(n - 1) * rho * c;
+		}
+		drho      += 0.5 * a * dq;
 	}
+	return(nll);
+}
+
 
+/*
+	Negative loglikelihood with i.i.d. residuals (rho = 0).  The value is
+	computed by evaluate() and a single adjoint is pushed onto the gradient
+	stack, so the stack holds one entry per call instead of several
+	temporaries per year.
+*/
+static void dflogistic_normal_nll(void);
 
-		// cout<<"Here I am in the likelihood"<<endl;
-		// cout<<m_nll<<endl;
-		
-		
-	return(m_nll);
+dvariable logistic_normal::negative_loglikelihood(const dvariable& tau2)
+{
+	dmatrix dEa;							// d nll / d m_Ea
+	double dsig2, drho;
+	double nll = evaluate(value(tau2), 0.0, dEa, dsig2, drho);
+
+	dvariable vnll = nograd_assign(nll);
+
+	save_identifier_string("ln_nll1");
+	tau2.save_prevariable_position();
+	m_Ea.save_dvar_matrix_position();
+	dEa.save_dmatrix_value();
+	dEa.save_dmatrix_position();
+	save_double_value(dsig2);
+	vnll.save_prevariable_position();
+	save_identifier_string("ln_nll2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dflogistic_normal_nll);
+
+	return(vnll);
+}
+
+/*
+	Adjoint of negative_loglikelihood: restores the saved partials (in reverse
+	order of saving) and scales them by the derivative of the result.
+*/
+static void dflogistic_normal_nll(void)
+{
+	verify_identifier_string("ln_nll2");
+	prevariable_position nllpos   = restore_prevariable_position();
+	double dfnll                  = restore_prevariable_derivative(nllpos);
+	double dsig2                  = restore_double_value();
+	dmatrix_position dEapos       = restore_dmatrix_position();
+	dmatrix dEa                   = restore_dmatrix_value(dEapos);
+	dvar_matrix_position Eapos    = restore_dvar_matrix_position();
+	prevariable_position tau2pos  = restore_prevariable_position();
+	verify_identifier_string("ln_nll1");
+
+	dEa *= dfnll;
+	dEa.save_dmatrix_derivatives(Eapos);
+	save_double_derivative(dfnll * dsig2, tau2pos);
 }
 
 
 void logistic_normal::aggregate_arrays()
 {
 	/*
+		Data-only setup, done once per data set:
 		- Aggregate minimum proportions in to adjacent cohorts (tail compression)
-		- This routine populates m_Oa and m_Ea as ragged objects to be used for
-		  likelihood calculations.
+		- Build m_nBinMap, the aggregated bin that each bin j is pooled into,
+		  so set_expected() only has to gather.
+		- Populate the ragged m_Oa, and allocate m_Ea for set_expected().
+		- Cache the parts of the likelihood that depend on the data only:
+		  m_dConst = t1 + t3 + t7 and m_dLogOr = log(Oa_j/Oa_nB).
 	*/
+	if( allocated(m_nNminp) )
+	{
+		// called again from set_MinimumProporiton()
+		m_nNminp.deallocate();
+		m_nAgeIndex.deallocate();
+		m_nBinMap.deallocate();
+		m_Oa.deallocate();
+		m_Ea.deallocate();
+		m_dConst.deallocate();
+		m_dLogOr.deallocate();
+	}
 	m_nNminp.allocate(m_y1,m_y2);
 	
 
@@ -113,6 +285,7 @@ void logistic_normal::aggregate_arrays()
 
 	// Ragged arrays with tail compression and zeros omitted.
 	m_nAgeIndex.allocate(m_y1,m_y2,1,m_nNminp);
+	m_nBinMap.allocate(m_y1,m_y2,m_b1,m_b2);
 	m_Oa.allocate(m_y1,m_y2,1,m_nNminp);
 	m_Ea.allocate(m_y1,m_y2,1,m_nNminp);
 	m_nAgeIndex.initialize();
@@ -122,23 +295,146 @@ void logistic_normal::aggregate_arrays()
 	for(int i = m_y1; i <= m_y2; i++ )
 	{
 		dvector     oo = m_Op(i);
-		dvar_vector pp = m_Ep(i);
 		k = 1;
 		for(int j = m_b1; j <= m_b2; j++ )
 		{
-			if( oo(j) <= m_dMinimumProportion )
-			{
-				m_Oa(i,k) += oo(j);
-				m_Ea(i,k) += pp(j);
-			}
-			else
-			{
-				m_Oa(i,k) += oo(j);
-				m_Ea(i,k) += pp(j);
+			m_Oa(i,k) += oo(j);
+			m_nBinMap(i,j) = k;
 
+			if( oo(j) > m_dMinimumProportion )
+			{
 				if(k <=m_nNminp(i)) m_nAgeIndex(i,k) = j;
 				if(k < m_nNminp(i)) k++;
 			}
 		}
 	}
+
+	// Data-only terms of the likelihood.
+	m_dConst.allocate(m_y1,m_y2);
+	m_dLogOr.allocate(m_y1,m_y2,1,m_nNminp);
+	m_dLogOr.initialize();
+	for(int i = m_y1; i <= m_y2; i++ )
+	{
+		int    nB  = m_nNminp(i);
+		double t1  = 0.5 * (nB - 1.0) * log(2.0*PI);
+		double t3  = sum( log(m_Oa(i)) );
+		double t7  = (nB - 1.0) * log(m_dWy(i));
+		m_dConst(i) = t1 + t3 + t7;
+
+		double lOB = log(m_Oa(i,nB));
+		for(int j = 1; j < nB; j++ )
+		{
+			m_dLogOr(i,j) = log(m_Oa(i,j)) - lOB;
+		}
+	}
+}
+
+
+/*
+	logistic_normal_engine: every composition source of a model in one batched
+	call.  Each source keeps its own data-only setup; a single adjoint covers
+	all sources and the variance/correlation parameters.
+*/
+int logistic_normal_engine::add_source(const dmatrix& _O, int tau_index, int rho_index)
+{
+	m_source.push_back(logistic_normal(_O));
+	m_nTau.push_back(tau_index);
+	m_nRho.push_back(rho_index);
+	return(int(m_source.size()));
+}
+
+
+void logistic_normal_engine::set_expected(int s, const dvar_matrix& _E)
+{
+	m_source[s-1].set_expected(_E);
+}
+
+
+static void dflogistic_normal_engine(void);
+
+dvar_vector logistic_normal_engine::negative_loglikelihood(const dvar_vector& tau2,
+                                                           const dvar_vector& rho)
+{
+	int nS = int(m_source.size());
+	dvector nll(1,nS);
+	dmatrix dtau(1,nS,tau2.indexmin(),tau2.indexmax());	// d nll_s / d tau2
+	dmatrix drho(1,nS,rho.indexmin(),rho.indexmax());	// d nll_s / d rho
+	dtau.initialize();
+	drho.initialize();
+
+	dvector vtau2 = value(tau2);
+	dvector vrho  = value(rho);
+
+	save_identifier_string("ln_eng1");
+	tau2.save_dvar_vector_position();
+	rho.save_dvar_vector_position();
+	for( int s = 1; s <= nS; s++ )
+	{
+		logistic_normal& src = m_source[s-1];
+		int p = m_nTau[s-1];
+		int r = m_nRho[s-1];
+		dmatrix dEa;
+		nll(s) = src.evaluate(vtau2(p), vrho(r), dEa, dtau(s,p), drho(s,r));
+
+		src.m_Ea.save_dvar_matrix_position();
+		dEa.save_dmatrix_value();
+		dEa.save_dmatrix_position();
+	}
+	dtau.save_dmatrix_value();
+	dtau.save_dmatrix_position();
+	drho.save_dmatrix_value();
+	drho.save_dmatrix_position();
+	save_int_value(nS);
+
+	dvar_vector vnll = nograd_assign(nll);
+	vnll.save_dvar_vector_position();
+	save_identifier_string("ln_eng2");
+	gradient_structure::GRAD_STACK1->set_gradient_stack(dflogistic_normal_engine);
+
+	return(vnll);
+}
+
+
+dvar_vector logistic_normal_engine::negative_loglikelihood(const dvariable& tau2,
+                                                           const dvariable& rho)
+{
+	// shared parameters: every source added with the default indices (1)
+	dvar_vector vtau2(1,1);
+	dvar_vector vrho(1,1);
+	vtau2(1) = tau2;
+	vrho(1)  = rho;
+	return(negative_loglikelihood(vtau2,vrho));
+}
+
+
+/*
+	Adjoint of logistic_normal_engine::negative_loglikelihood.
+*/
+static void dflogistic_normal_engine(void)
+{
+	verify_identifier_string("ln_eng2");
+	dvar_vector_position nllpos   = restore_dvar_vector_position();
+	dvector dfnll                 = restore_dvar_vector_derivatives(nllpos);
+	int nS                        = restore_int_value();
+	dmatrix_position drhopos      = restore_dmatrix_position();
+	dmatrix drho                  = restore_dmatrix_value(drhopos);
+	dmatrix_position dtaupos      = restore_dmatrix_position();
+	dmatrix dtau                  = restore_dmatrix_value(dtaupos);
+	for( int s = nS; s >= 1; s-- )
+	{
+		dmatrix_position dEapos    = restore_dmatrix_position();
+		dmatrix dEa                = restore_dmatrix_value(dEapos);
+		dvar_matrix_position Eapos = restore_dvar_matrix_position();
+
+		dEa *= dfnll(s);
+		dEa.save_dmatrix_derivatives(Eapos);
+	}
+	dvar_vector_position rhopos   = restore_dvar_vector_position();
+	dvar_vector_position tau2pos  = restore_dvar_vector_position();
+	verify_identifier_string("ln_eng1");
+
+	dvector dfrho  = dfnll * drho;
+	dvector dftau2 = dfnll * dtau;
+	dfrho.save_dvector_derivatives(rhopos);
+	dftau2.save_dvector_derivatives(tau2pos);
 }
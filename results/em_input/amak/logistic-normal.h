@@ -4,6 +4,7 @@
 */
 
 #include <admodel.h>
+#include <vector>
 
 #ifndef LOGISTIC_NORMAL_H
 #define LOGISTIC_NORMAL_H
@@ -21,25 +22,29 @@ private:
 
 	double m_dMinimumProportion;
 
-	dvariable   m_nll;
-
 	ivector     m_nNminp;
 	dvector     m_dWy;		// relative weight for each year.
 
 	imatrix     m_nAgeIndex;// Index for aggregated residuals
+	imatrix     m_nBinMap;	// Aggregated bin that each bin is pooled into
 	dmatrix     m_O;		// Raw Data
 	dmatrix     m_Op;		// Proportions
-	dmatrix     m_Ox;		// Logistic transform.
 	dmatrix     m_Oa;		// Aggregated matrix for tail compression and zeros
+	dvector     m_dConst;	// Data-only likelihood terms for each year.
+	dmatrix     m_dLogOr;	// log(Oa_j/Oa_nB), ragged like m_Oa
 
-	dvar_matrix m_E;
-	dvar_matrix m_Ep;
-	dvar_matrix m_Ex;
 	dvar_matrix m_Ea;		// Aggregated matrix for tail compression and zeros
 
+	void set_observed();
+	double evaluate(double sig2, double rho, dmatrix& dEa,
+	                double& dsig2, double& drho);
+
+	friend class logistic_normal_engine;
+
 public:
 	~logistic_normal();
 	logistic_normal();
+	logistic_normal(const dmatrix& _O);
 	logistic_normal(const dmatrix& _O, const dvar_matrix& _E);
 
 	/* data */
@@ -48,7 +53,36 @@ public:
 
 
 	/* setters */
-	void set_MinimumProporiton(double &p) {m_dMinimumProportion = p;}
+	void set_MinimumProporiton(double &p);
+	void set_expected(const dvar_matrix& _E);
+};
+
+
+/**
+	Logistic normal likelihood for all composition sources of a model
+	(e.g. fishery and index age and length compositions) evaluated in one
+	batched call, with an AR(1) residual correlation across bins.
+
+	Sources are added once with the observed matrix; each function evaluation
+	calls set_expected() for every source and then negative_loglikelihood(),
+	which returns one negative loglikelihood per source.  Each source uses
+	tau2(tau_index) and rho(rho_index), so parameters can be shared or
+	estimated per source.
+*/
+class logistic_normal_engine
+{
+private:
+	std::vector<logistic_normal> m_source;
+	std::vector<int>             m_nTau;	// tau2 index of each source
+	std::vector<int>             m_nRho;	// rho index of each source
+
+public:
+	int  add_source(const dmatrix& _O, int tau_index = 1, int rho_index = 1);
+	void set_expected(int s, const dvar_matrix& _E);
+	int  sources() const {return int(m_source.size());}
+
+	dvar_vector negative_loglikelihood(const dvar_vector& tau2, const dvar_vector& rho);
+	dvar_vector negative_loglikelihood(const dvariable& tau2, const dvariable& rho);
 };
 
 
@@ -0,0 +1,185 @@
+#include <admodel.h>
+#include "oper-proj.h"
+
+template <class T>
+oper_proj<T>::~oper_proj()
+{}
+
+template <class T>
+oper_proj<T>::oper_proj()
+: m_a1(1), m_a2(0), m_nIter(5), m_dFrac(0), m_SrType(2)
+{}
+
+
+template <class T>
+void oper_proj<T>::set_fishery(const vector_type& _Fratio, const matrix_type& _sel,
+                               const dmatrix& _wt_catch, const dvector& _wt_pop)
+{
+	/*
+	_sel and _wt_catch are by fleet (rows, indexed like _Fratio) and age;
+	_wt_pop is the population weight at age used for the exploitable
+	biomass that scales the catch equation iterations in solve_F.
+	*/
+	int f1 = _Fratio.indexmin();
+	int f2 = _Fratio.indexmax();
+	m_a1 = _wt_pop.indexmin();
+	m_a2 = _wt_pop.indexmax();
+
+	m_vFsel.deallocate();
+	m_vYsel.deallocate();
+	m_vBsel.deallocate();
+	m_vFsel.allocate(m_a1,m_a2);
+	m_vYsel.allocate(m_a1,m_a2);
+	m_vBsel.allocate(m_a1,m_a2);
+	for(int a = m_a1; a <= m_a2; a++ )
+	{
+		m_vFsel(a) = 0.;
+		m_vYsel(a) = 0.;
+		for(int k = f1; k <= f2; k++ )
+		{
+			m_vFsel(a) += _Fratio(k) * _sel(k,a);
+			m_vYsel(a) += _Fratio(k) * _sel(k,a) * _wt_catch(k,a);
+		}
+		m_vBsel(a) = _sel(f1,a) * _wt_pop(a);
+	}
+}
+
+
+template <class T>
+void oper_proj<T>::set_biology(const dvector& _wt_spawn, double _frac)
+{
+	m_dWtSpawn.deallocate();
+	m_dWtSpawn.allocate(_wt_spawn.indexmin(),_wt_spawn.indexmax());
+	m_dWtSpawn = _wt_spawn;
+	m_dFrac    = _frac;
+}
+
+
+template <class T>
+void oper_proj<T>::set_sr(int _SrType, const T& _alpha, const T& _beta, const T& _phizero,
+                          const T& _Bzero, const T& _mean_log_rec)
+{
+	m_SrType  = _SrType;
+	m_alpha   = _alpha;
+	m_beta    = _beta;
+	m_phizero = _phizero;
+	m_Bzero   = _Bzero;
+	m_Rbar    = mfexp(_mean_log_rec);
+}
+
+
+/*
+	F multiplier that takes the catch TAC (in weight) from numbers N with
+	natural mortality M.  Starts from the harvest rate on the exploitable
+	biomass and corrects it by the catch shortfall over the same biomass,
+	a fixed number of times (as SolveF2).
+*/
+template <class T>
+T oper_proj<T>::solve_F(const vector_type& N, const vector_type& M, double TAC) const
+{
+	oper_proj_types<T>::arrays_increment();
+	T btmp = 0.;
+	for(int a = m_a1; a <= m_a2; a++ )
+		btmp += N(a) * m_vBsel(a);
+
+	T ftmp = TAC / btmp;
+	for(int ii = 1; ii <= m_nIter; ii++ )
+	{
+		T cc = 0.;
+		for(int a = m_a1; a <= m_a2; a++ )
+		{
+			T z = M(a) + ftmp * m_vFsel(a);
+			cc += m_vYsel(a) / z * (1. - mfexp(-z)) * N(a);
+		}
+		cc   *= ftmp;
+		ftmp += (TAC - cc) / btmp;
+	}
+	oper_proj_types<T>::arrays_decrement();
+	return ftmp;
+}
+
+
+template <class T>
+void oper_proj<T>::mortality(const T& Fmult, const vector_type& M, vector_type& Z, vector_type& S) const
+{
+	for(int a = m_a1; a <= m_a2; a++ )
+	{
+		Z(a) = M(a) + Fmult * m_vFsel(a);
+		S(a) = mfexp(-Z(a));
+	}
+}
+
+
+template <class T>
+T oper_proj<T>::recruit(const T& ssb) const
+{
+	oper_proj_types<T>::arrays_increment();
+	T RecTmp = 0.;
+	switch (m_SrType)
+	{
+		case 1:
+			RecTmp = (ssb / m_phizero) * mfexp( m_alpha * ( 1. - ssb / m_Bzero )); // Ricker form from Dorn
+			break;
+		case 2:
+			RecTmp = ssb / ( m_alpha + m_beta * ssb);	// Beverton-Holt form
+			break;
+		case 3:
+			RecTmp = m_Rbar;	// Avg recruitment
+			break;
+		case 4:
+			RecTmp = ssb * mfexp( m_alpha - ssb * m_beta);	// old Ricker form
+			break;
+	}
+	oper_proj_types<T>::arrays_decrement();
+	return RecTmp;
+}
+
+
+template <class T>
+T oper_proj<T>::spawners(const vector_type& N, const vector_type& S) const
+{
+	oper_proj_types<T>::arrays_increment();
+	T ssb = 0.;
+	for(int a = m_dWtSpawn.indexmin(); a <= m_dWtSpawn.indexmax(); a++ )
+		ssb += m_dWtSpawn(a) * N(a) * pow(S(a), m_dFrac);
+	oper_proj_types<T>::arrays_decrement();
+	return ssb;
+}
+
+
+/*
+	Numbers at the start of the next year, from ages 2 on; the first age
+	(recruits) is left to the caller.
+*/
+template <class T>
+void oper_proj<T>::graduate(const vector_type& N, const vector_type& S, vector_type& Nnext) const
+{
+	int a1 = N.indexmin();
+	int a2 = N.indexmax();
+	for(int a = a1 + 1; a <= a2; a++ )
+		Nnext(a) = N(a-1) * S(a-1);
+	Nnext(a2) += N(a2) * S(a2);
+}
+
+
+template <class T>
+void oper_proj<T>::baranov(const vector_type& N, const vector_type& F, const vector_type& Z,
+                           const vector_type& S, vector_type& C) const
+{
+	for(int a = N.indexmin(); a <= N.indexmax(); a++ )
+		C(a) = N(a) * F(a) * (1. - S(a)) / Z(a);
+}
+
+
+/* catch at age summed over fleets, for the F multiplier Fmult */
+template <class T>
+void oper_proj<T>::catch_at_age(const vector_type& N, const T& Fmult, const vector_type& Z,
+                                const vector_type& S, vector_type& C) const
+{
+	for(int a = m_a1; a <= m_a2; a++ )
+		C(a) = N(a) * Fmult * m_vFsel(a) * (1. - S(a)) / Z(a);
+}
+
+
+template class oper_proj<double>;
+template class oper_proj<dvariable>;
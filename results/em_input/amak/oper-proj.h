@@ -0,0 +1,92 @@
+/**
+	This is a class for projecting the population forward one year at a
+	time: the F multiplier that takes a given catch (as SolveF2), total
+	mortality, recruitment from the stock-recruit curve, graduation to the
+	next year, spawning biomass and Baranov catch at age.
+
+	The class is templated on the scalar type.  oper_proj<double> is the
+	value-only path for the simulation loop of the operating model
+	(Oper_Model), where nothing is differentiated and so nothing should be
+	recorded on the gradient stack however many simulations are run.
+	oper_proj<dvariable> is the same code on AD types, for the projections
+	that are part of the estimation (Future_projections).
+
+	Fleets are combined with their share of F (Fratio), as in SolveF2 and
+	the MSY calculations.  The last age is a plus group.
+*/
+
+#include <admodel.h>
+
+#ifndef OPER_PROJ_H
+#define OPER_PROJ_H
+
+/* vector and matrix types that go with each scalar type */
+template <class T> struct oper_proj_types;
+
+template <> struct oper_proj_types<double>
+{
+	typedef dvector vector;
+	typedef dmatrix matrix;
+	static void arrays_increment() {}
+	static void arrays_decrement() {}
+};
+
+template <> struct oper_proj_types<dvariable>
+{
+	typedef dvar_vector vector;
+	typedef dvar_matrix matrix;
+	static void arrays_increment() { RETURN_ARRAYS_INCREMENT(); }
+	static void arrays_decrement() { RETURN_ARRAYS_DECREMENT(); }
+};
+
+template <class T>
+class oper_proj
+{
+public:
+	typedef typename oper_proj_types<T>::vector vector_type;
+	typedef typename oper_proj_types<T>::matrix matrix_type;
+
+private:
+	int         m_a1;
+	int         m_a2;
+	int         m_nIter;	// Iterations of the catch equation in solve_F.
+
+	vector_type m_vFsel;	// Sum over fleets of Fratio times selectivity.
+	vector_type m_vYsel;	// Same, times the fleet catch weight.
+	vector_type m_vBsel;	// Selectivity of the first fleet times population weight.
+
+	dvector     m_dWtSpawn;	// Spawning output at age.
+	double      m_dFrac;	// Fraction of the year before spawning.
+
+	int         m_SrType;	// 1 Ricker (Dorn), 2 Beverton-Holt, 3 mean, 4 old Ricker.
+	T           m_alpha;
+	T           m_beta;
+	T           m_phizero;
+	T           m_Bzero;
+	T           m_Rbar;		// exp(mean_log_rec)
+
+public:
+	~oper_proj();
+	oper_proj();
+
+	/* setters */
+	void set_fishery(const vector_type& _Fratio, const matrix_type& _sel,
+	                 const dmatrix& _wt_catch, const dvector& _wt_pop);
+	void set_biology(const dvector& _wt_spawn, double _frac);
+	void set_sr(int _SrType, const T& _alpha, const T& _beta, const T& _phizero,
+	            const T& _Bzero, const T& _mean_log_rec);
+
+	/* one year */
+	T    solve_F(const vector_type& N, const vector_type& M, double TAC) const;
+	void mortality(const T& Fmult, const vector_type& M, vector_type& Z, vector_type& S) const;
+	T    recruit(const T& ssb) const;
+	T    spawners(const vector_type& N, const vector_type& S) const;
+	void graduate(const vector_type& N, const vector_type& S, vector_type& Nnext) const;
+	void baranov(const vector_type& N, const vector_type& F, const vector_type& Z,
+	             const vector_type& S, vector_type& C) const;
+	void catch_at_age(const vector_type& N, const T& Fmult, const vector_type& Z,
+	                  const vector_type& S, vector_type& C) const;
+};
+
+
+#endif
@@ -0,0 +1,258 @@
+#include <admodel.h>
+#include "proj-scenarios.h"
+
+template <class T>
+proj_scenario<T>::~proj_scenario()
+{}
+
+template <class T>
+proj_scenario<T>::proj_scenario()
+: type(PROJ_FMULT), value(0)
+{}
+
+template <class T>
+void proj_scenario<T>::allocate(int _y1, int _y2, int _a1, int _a2, int _rec_age)
+{
+	N.deallocate();
+	Sp.deallocate();
+	C.deallocate();
+	Y.deallocate();
+	N.allocate(_y1,_y2,_a1,_a2);
+	Sp.allocate(_y1-_rec_age,_y2);
+	C.allocate(_y1,_y2,_a1,_a2);
+	Y.allocate(_y1,_y2);
+}
+
+
+template <class T>
+proj_batch<T>::~proj_batch()
+{}
+
+template <class T>
+proj_batch<T>::proj_batch()
+: s1(1), s2(0)
+{}
+
+
+template <class T>
+proj_scenarios<T>::~proj_scenarios()
+{}
+
+template <class T>
+proj_scenarios<T>::proj_scenarios(int _y1, int _y2, int _rec_age, const oper_proj<T>& _proj)
+: m_y1(_y1), m_y2(_y2), m_nRecAge(_rec_age), m_a1(1), m_a2(0), m_f1(1), m_f2(0), m_pProj(&_proj), m_Fmsy(0)
+{}
+
+
+template <class T>
+void proj_scenarios<T>::set_start(const vector_type& _N0, const vector_type& _S0,
+                                  const vector_type& _Sp_lag)
+{
+	/*
+	_N0 and _S0 are numbers and survival at age in the last assessment
+	year; _Sp_lag is the spawning biomass from rec_age years before the
+	first projection year up to the year before it.
+	*/
+	m_a1 = _N0.indexmin();
+	m_a2 = _N0.indexmax();
+	m_vN0.deallocate();
+	m_vS0.deallocate();
+	m_vSpLag.deallocate();
+	m_vN0.allocate(m_a1,m_a2);
+	m_vS0.allocate(m_a1,m_a2);
+	m_vSpLag.allocate(m_y1-m_nRecAge,m_y1-1);
+	m_vN0    = _N0;
+	m_vS0    = _S0;
+	m_vSpLag = _Sp_lag;
+}
+
+
+template <class T>
+void proj_scenarios<T>::set_fishery(const vector_type& _M, const matrix_type& _sel,
+                                    const vector_type& _Fbar, const dmatrix& _wt_catch)
+{
+	/*
+	_sel and _wt_catch are by fleet (rows, indexed like _Fbar) and age.
+	*/
+	m_f1 = _Fbar.indexmin();
+	m_f2 = _Fbar.indexmax();
+	m_vM.deallocate();
+	m_mSel.deallocate();
+	m_vFbar.deallocate();
+	m_dWtCatch.deallocate();
+	m_vM.allocate(m_a1,m_a2);
+	m_mSel.allocate(m_f1,m_f2,m_a1,m_a2);
+	m_vFbar.allocate(m_f1,m_f2);
+	m_dWtCatch.allocate(m_f1,m_f2,m_a1,m_a2);
+	m_vM       = _M;
+	m_mSel     = _sel;
+	m_vFbar    = _Fbar;
+	m_dWtCatch = _wt_catch;
+}
+
+
+template <class T>
+void proj_scenarios<T>::set_reference(const T& _Fmsy, const vector_type& _Fratio)
+{
+	m_vFratio.deallocate();
+	m_vFratio.allocate(_Fratio.indexmin(),_Fratio.indexmax());
+	m_vFratio = _Fratio;
+	m_Fmsy    = _Fmsy;
+}
+
+
+template <class T>
+void proj_scenarios<T>::set_recruitment(const vector_type& _rec_mult)
+{
+	m_vRecMult.deallocate();
+	m_vRecMult.allocate(m_y1,m_y2);
+	m_vRecMult = _rec_mult;
+}
+
+
+/*
+	One year of one scenario, with the recruits already in N: F by fleet
+	for the scenario type, then survival to the next year (unless last),
+	spawning biomass and Baranov catch.  Z, S, Ca and F are work space.
+	Element by element, so that with T = double nothing is allocated.
+*/
+template <class T>
+void proj_scenarios<T>::step(int type, double value, const vector_type& N, vector_type& Nnext,
+                             bool last, T& Sp, vector_type& C, T& Y, vector_type& Z,
+                             vector_type& S, vector_type& Ca, matrix_type& F) const
+{
+	T ftmp = 0.;
+	if( type == PROJ_CATCH )
+		ftmp = m_pProj->solve_F(N,m_vM,value);
+	else if( type == PROJ_FMSY )
+		ftmp = m_Fmsy * value;
+
+	Z = m_vM;
+	T fk = 0.;
+	for(int k = m_f1; k <= m_f2; k++ )
+	{
+		if( type == PROJ_FMULT )
+			fk = m_vFbar(k) * value;
+		else
+			fk = m_vFratio(k) * ftmp;
+		for(int a = m_a1; a <= m_a2; a++ )
+		{
+			F(k,a) = m_mSel(k,a) * fk;
+			Z(a)  += F(k,a);
+		}
+	}
+	for(int a = m_a1; a <= m_a2; a++ )
+		S(a) = mfexp(-Z(a));
+	if( !last )
+		m_pProj->graduate(N,S,Nnext);
+	Sp = m_pProj->spawners(N,S);
+
+	C.initialize();
+	Y = 0.;
+	for(int k = m_f1; k <= m_f2; k++ )
+	{
+		m_pProj->baranov(N,F(k),Z,S,Ca);
+		C += Ca;
+		Y += Ca * m_dWtCatch(k);
+	}
+}
+
+
+template <class T>
+void proj_scenarios<T>::allocate(proj_batch<T>& w, int s1, int s2) const
+{
+	w.s1 = s1;
+	w.s2 = s2;
+	w.N[0].deallocate();
+	w.N[1].deallocate();
+	w.Sp.deallocate();
+	w.Z.deallocate();
+	w.S.deallocate();
+	w.C.deallocate();
+	w.Ca.deallocate();
+	w.F.deallocate();
+	w.N[0].allocate(s1,s2,m_a1,m_a2);
+	w.N[1].allocate(s1,s2,m_a1,m_a2);
+	w.Sp.allocate(s1,s2,m_y1-m_nRecAge,m_y2);
+	w.Z.allocate(m_a1,m_a2);
+	w.S.allocate(m_a1,m_a2);
+	w.C.allocate(m_a1,m_a2);
+	w.Ca.allocate(m_a1,m_a2);
+	w.F.allocate(m_f1,m_f2,m_a1,m_a2);
+}
+
+
+template <class T>
+void proj_scenarios<T>::allocate(proj_scenario<T>& sc) const
+{
+	sc.allocate(m_y1,m_y2,m_a1,m_a2,m_nRecAge);
+}
+
+
+/*
+	The rows of a block advance together a year at a time.  Numbers at age
+	for the block are kept for the current and the next year only (two
+	matrices, used in turn), and spawning biomass for the recruitment lag.
+	Only the inputs (read), w and last, and rows s1..s2 of SSB, Y and R
+	(written) are used, and nothing is allocated, so blocks can be
+	projected concurrently with T = double.  The numbers at age of row s2
+	are copied into last->N as each year is reached, and its catch at age
+	goes straight into last->C.
+*/
+template <class T>
+void proj_scenarios<T>::project_batch(const ivector& types, const dvector& values, proj_batch<T>& w,
+                                      matrix_type& SSB, matrix_type& Y, matrix_type& R,
+                                      proj_scenario<T>* last) const
+{
+	oper_proj_types<T>::arrays_increment();
+	int s1 = w.s1;
+	int s2 = w.s2;
+	for(int s = s1; s <= s2; s++ )
+	{
+		for(int i = m_y1 - m_nRecAge; i < m_y1; i++ )
+			w.Sp(s,i) = m_vSpLag(i);
+		m_pProj->graduate(m_vN0,m_vS0,w.N[0](s));
+	}
+	if( last )
+	{
+		last->type  = types(s2);
+		last->value = values(s2);
+		for(int i = m_y1 - m_nRecAge; i < m_y1; i++ )
+			last->Sp(i) = m_vSpLag(i);
+	}
+
+	T sp, y;
+	for(int i = m_y1; i <= m_y2; i++ )
+	{
+		matrix_type& N     = w.N[(i - m_y1) % 2];
+		matrix_type& Nnext = w.N[(i - m_y1 + 1) % 2];
+		bool lastyr = (i == m_y2);
+		for(int s = s1; s <= s2; s++ )
+		{
+			N(s,m_a1) = m_pProj->recruit(w.Sp(s,i-m_nRecAge)) * m_vRecMult(i);
+			R(s,i)    = N(s,m_a1);
+			if( last && s == s2 )
+			{
+				for(int a = m_a1; a <= m_a2; a++ )
+					last->N(i,a) = N(s,a);
+				step(types(s),values(s),N(s),Nnext(s),lastyr,sp,last->C(i),y,w.Z,w.S,w.Ca,w.F);
+				last->Sp(i) = sp;
+				last->Y(i)  = y;
+			}
+			else
+				step(types(s),values(s),N(s),Nnext(s),lastyr,sp,w.C,y,w.Z,w.S,w.Ca,w.F);
+			w.Sp(s,i) = sp;
+			SSB(s,i)  = sp;
+			Y(s,i)    = y;
+		}
+	}
+	oper_proj_types<T>::arrays_decrement();
+}
+
+
+template class proj_scenario<double>;
+template class proj_scenario<dvariable>;
+template class proj_batch<double>;
+template class proj_batch<dvariable>;
+template class proj_scenarios<double>;
+template class proj_scenarios<dvariable>;
@@ -0,0 +1,142 @@
+/**
+	This is a class for the future projection scenarios (Future_projections):
+	the population from the end of the assessment is projected under each
+	row of a scenario table, with recruitment from the stock-recruit curve
+	and the future recruitment deviations.  A row is a type and a value:
+
+		PROJ_FMULT  value times the terminal-year mean F of each fleet
+		PROJ_FMSY   value times Fmsy, shared among fleets by Fratio
+		PROJ_CATCH  a fixed catch (biomass) each year, with the F multiplier
+		            from the catch equation (oper_proj::solve_F, as SolveF2)
+
+	The inputs are set once and only read by the projections.
+	project_batch() takes a block of rows together, year by year, with the
+	numbers at age of the block as a matrix (rows by age), and writes the
+	spawning biomass, catch and recruits of each row, and optionally the
+	full state of the last row of the block (proj_scenario).  Its arrays
+	(proj_batch, proj_scenario) are allocated beforehand by the caller and
+	it allocates none itself, so with T = double blocks can run on a pool
+	of threads (replicate-pool.h), as for the mceval draws.
+	proj_scenarios<dvariable> is the same code on AD types, for when
+	derivatives are needed (sdreport of SSB_fut).  The year steps are
+	those of oper_proj.
+*/
+
+#include <admodel.h>
+#include "oper-proj.h"
+
+#ifndef PROJ_SCENARIOS_H
+#define PROJ_SCENARIOS_H
+
+/* types of scenario */
+enum proj_type
+{
+	PROJ_FMULT = 1,	// multiple of the terminal-year F
+	PROJ_FMSY  = 2,	// fraction of Fmsy
+	PROJ_CATCH = 3	// fixed catch
+};
+
+/* the state of one scenario */
+template <class T>
+class proj_scenario
+{
+public:
+	typedef typename oper_proj_types<T>::vector vector_type;
+	typedef typename oper_proj_types<T>::matrix matrix_type;
+
+	int         type;		// proj_type
+	double      value;
+	matrix_type N;			// Numbers at age by projection year.
+	vector_type Sp;			// Spawning biomass, from rec_age years before the first year.
+	matrix_type C;			// Catch at age, all fleets.
+	vector_type Y;			// Catch biomass, all fleets.
+
+	~proj_scenario();
+	proj_scenario();
+
+	void allocate(int _y1, int _y2, int _a1, int _a2, int _rec_age);
+};
+
+
+/* work space of project_batch for rows s1..s2 */
+template <class T>
+class proj_batch
+{
+public:
+	typedef typename oper_proj_types<T>::vector vector_type;
+	typedef typename oper_proj_types<T>::matrix matrix_type;
+
+	int         s1;
+	int         s2;
+	matrix_type N[2];		// Numbers at age by row, this year and the next, in turn.
+	matrix_type Sp;			// Spawning biomass by row and year.
+	vector_type Z;			// One row and year.
+	vector_type S;
+	vector_type C;
+	vector_type Ca;
+	matrix_type F;
+
+	~proj_batch();
+	proj_batch();
+};
+
+
+template <class T>
+class proj_scenarios
+{
+public:
+	typedef typename oper_proj_types<T>::vector vector_type;
+	typedef typename oper_proj_types<T>::matrix matrix_type;
+
+private:
+	int         m_y1;		// First and last projection year.
+	int         m_y2;
+	int         m_nRecAge;
+	int         m_a1;
+	int         m_a2;
+	int         m_f1;		// Fleets.
+	int         m_f2;
+
+	const oper_proj<T>* m_pProj;	// Recruitment, catch equation, graduation and spawning biomass.
+
+	vector_type m_vN0;		// Numbers and survival in the last assessment year.
+	vector_type m_vS0;
+	vector_type m_vSpLag;	// Spawning biomass of the rec_age years before the first.
+	vector_type m_vM;		// Natural mortality in the projection.
+	matrix_type m_mSel;		// Selectivity by fleet, terminal year.
+	vector_type m_vFbar;	// Mean F by fleet, terminal year.
+	dmatrix     m_dWtCatch;	// Catch weight by fleet, terminal year.
+	vector_type m_vRecMult;	// exp(recruitment deviation) by projection year.
+	T           m_Fmsy;
+	vector_type m_vFratio;	// Share of F by fleet for PROJ_FMSY and PROJ_CATCH.
+
+	void step(int type, double value, const vector_type& N, vector_type& Nnext, bool last,
+	          T& Sp, vector_type& C, T& Y, vector_type& Z, vector_type& S, vector_type& Ca,
+	          matrix_type& F) const;
+
+public:
+	~proj_scenarios();
+	proj_scenarios(int _y1, int _y2, int _rec_age, const oper_proj<T>& _proj);
+
+	/* setters */
+	void set_start(const vector_type& _N0, const vector_type& _S0, const vector_type& _Sp_lag);
+	void set_fishery(const vector_type& _M, const matrix_type& _sel, const vector_type& _Fbar,
+	                 const dmatrix& _wt_catch);
+	void set_reference(const T& _Fmsy, const vector_type& _Fratio);
+	void set_recruitment(const vector_type& _rec_mult);
+
+	/* arrays for project_batch, allocated on the calling thread */
+	void allocate(proj_batch<T>& w, int s1, int s2) const;
+	void allocate(proj_scenario<T>& sc) const;
+
+	/*
+	rows w.s1..w.s2 of the table together; SSB, Y and R are by row and
+	projection year, and last, if given, gets the state of row w.s2
+	*/
+	void project_batch(const ivector& types, const dvector& values, proj_batch<T>& w,
+	                   matrix_type& SSB, matrix_type& Y, matrix_type& R,
+	                   proj_scenario<T>* last = 0) const;
+};
+
+
+#endif
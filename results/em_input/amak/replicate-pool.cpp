@@ -0,0 +1,44 @@
+#include <admodel.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "replicate-pool.h"
+
+replicate_pool::~replicate_pool()
+{}
+
+replicate_pool::replicate_pool(int _nthreads)
+: m_nThreads(_nthreads < 1 ? 1 : _nthreads)
+{}
+
+
+int replicate_pool::threads() const
+{
+	return m_nThreads;
+}
+
+
+void replicate_pool::run(int n, const std::function<void(int)>& f) const
+{
+	int nt = m_nThreads < n ? m_nThreads : n;
+	if( nt <= 1 )
+	{
+		for(int isim = 1; isim <= n; isim++ )
+			f(isim);
+		return;
+	}
+
+	std::atomic<int> next(1);
+	std::vector<std::thread> pool;
+	for(int t = 0; t < nt; t++ )
+	{
+		pool.push_back(std::thread([&next, n, &f]()
+		{
+			int isim;
+			while( (isim = next++) <= n )
+				f(isim);
+		}));
+	}
+	for(int t = 0; t < nt; t++ )
+		pool[t].join();
+}
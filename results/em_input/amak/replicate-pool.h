@@ -0,0 +1,41 @@
+/**
+	This is a class for running simulation replicates on a pool of threads.
+
+	run(n, f) calls f(isim) for isim = 1..n.  The threads take the next
+	replicate number from a shared counter, so the replicates are spread
+	evenly whatever their run times.  f must only use its own data (its
+	own random number stream and output buffer, see rng-stream.h); the
+	caller merges the buffers in replicate order afterwards, so the output
+	does not depend on the number of threads.
+
+	ADMB arrays share memory pools and copy counts that are not locked, so
+	f must not create or destroy any (dvector, dmatrix, or the temporaries
+	of vector expressions such as elem_prod or exp), nor write to cout.
+	The caller allocates the arrays of every replicate beforehand, and f
+	only uses their elements; code that cannot do that runs on one thread.
+
+	With one thread (the default) the replicates run in order on the
+	calling thread.
+*/
+
+#include <admodel.h>
+#include <functional>
+
+#ifndef REPLICATE_POOL_H
+#define REPLICATE_POOL_H
+
+class replicate_pool
+{
+private:
+	int         m_nThreads;
+
+public:
+	~replicate_pool();
+	replicate_pool(int _nthreads);
+
+	int  threads() const;
+	void run(int n, const std::function<void(int)>& f) const;
+};
+
+
+#endif
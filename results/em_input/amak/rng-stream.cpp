@@ -0,0 +1,412 @@
+#include <admodel.h>
+#include <vector>
+#include "rng-stream.h"
+
+/* Philox4x32 multipliers and Weyl key increments */
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+
+rng_stream::~rng_stream()
+{}
+
+rng_stream::rng_stream(unsigned long _seed, unsigned long _replicate, int _year, int _purpose)
+: m_used(4), m_bSpare(false), m_dSpare(0)
+{
+	unsigned long long rep = _replicate;
+	m_key[0] = (unsigned int)_seed;
+	m_key[1] = (unsigned int)_purpose;
+	m_ctr[0] = 0;
+	m_ctr[1] = (unsigned int)_year;
+	m_ctr[2] = (unsigned int)(rep & 0xFFFFFFFFu);
+	m_ctr[3] = (unsigned int)(rep >> 32);
+}
+
+
+/*
+	nb blocks of output, for the block numbers m_ctr[0], m_ctr[0]+1, ...;
+	block b is out[4b..4b+3].  The ten Philox rounds are the outer loop
+	and the blocks the inner loop over contiguous arrays.
+*/
+void rng_stream::blocks(int nb, unsigned int* out)
+{
+	std::vector<unsigned int> v(4 * nb);
+	unsigned int* x0 = &v[0];
+	unsigned int* x1 = x0 + nb;
+	unsigned int* x2 = x1 + nb;
+	unsigned int* x3 = x2 + nb;
+	int b;
+	for( b = 0; b < nb; b++ )
+	{
+		x0[b] = m_ctr[0] + (unsigned int)b;
+		x1[b] = m_ctr[1];
+		x2[b] = m_ctr[2];
+		x3[b] = m_ctr[3];
+	}
+	unsigned int k0 = m_key[0], k1 = m_key[1];
+	for( int r = 0; r < 10; r++ )
+	{
+		for( b = 0; b < nb; b++ )
+		{
+			unsigned long long p0 = (unsigned long long)PHILOX_M0 * x0[b];
+			unsigned long long p1 = (unsigned long long)PHILOX_M1 * x2[b];
+			unsigned int c1 = x1[b], c3 = x3[b];
+			x0[b] = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+			x1[b] = (unsigned int)p1;
+			x2[b] = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+			x3[b] = (unsigned int)p0;
+		}
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	for( b = 0; b < nb; b++ )
+	{
+		out[4*b]   = x0[b];
+		out[4*b+1] = x1[b];
+		out[4*b+2] = x2[b];
+		out[4*b+3] = x3[b];
+	}
+	m_ctr[0] += (unsigned int)nb;
+}
+
+
+void rng_stream::next_block()
+{
+	blocks(1, m_out);
+	m_used = 0;
+}
+
+
+void rng_stream::philox_block(const unsigned int ctr[4], const unsigned int key[2], unsigned int out[4])
+{
+	rng_stream s(key[0], 0);
+	s.m_key[1] = key[1];
+	for( int i = 0; i < 4; i++ )
+		s.m_ctr[i] = ctr[i];
+	s.blocks(1, out);
+}
+
+
+unsigned int rng_stream::next_word()
+{
+	if( m_used == 4 ) next_block();
+	return m_out[m_used++];
+}
+
+
+/* 53-bit uniform on (0,1) from two words */
+static inline double rng_uniform53(unsigned int a, unsigned int b)
+{
+	return ((a >> 5) * 67108864.0 + (b >> 6) + 0.5) / 9007199254740992.0;
+}
+
+
+double rng_stream::uniform()
+{
+	unsigned int a = next_word();
+	unsigned int b = next_word();
+	return rng_uniform53(a, b);
+}
+
+
+/* Box-Muller, keeping the second deviate for the next call */
+double rng_stream::normal()
+{
+	if( m_bSpare )
+	{
+		m_bSpare = false;
+		return m_dSpare;
+	}
+	double r = sqrt(-2.0 * log(uniform()));
+	double t = 6.283185307179586 * uniform();
+	m_dSpare = r * sin(t);
+	m_bSpare = true;
+	return r * cos(t);
+}
+
+
+void rng_stream::fill_randn(dvector& v)
+{
+	int i1 = v.indexmin();
+	int n  = v.indexmax() - i1 + 1;
+	if( n <= 0 ) return;
+	int nb = (n + 1) / 2;
+	std::vector<unsigned int> w(4 * nb);
+	blocks(nb, &w[0]);
+	m_used   = 4;
+	m_bSpare = false;
+	for( int b = 0; b < nb; b++ )
+	{
+		double r = sqrt(-2.0 * log(rng_uniform53(w[4*b], w[4*b+1])));
+		double t = 6.283185307179586 * rng_uniform53(w[4*b+2], w[4*b+3]);
+		v(i1 + 2*b) = r * cos(t);
+		if( 2*b + 1 < n ) v(i1 + 2*b + 1) = r * sin(t);
+	}
+}
+
+
+void rng_stream::fill_randu(dvector& v)
+{
+	int i1 = v.indexmin();
+	int n  = v.indexmax() - i1 + 1;
+	if( n <= 0 ) return;
+	int nb = (n + 1) / 2;
+	std::vector<unsigned int> w(4 * nb);
+	blocks(nb, &w[0]);
+	m_used   = 4;
+	m_bSpare = false;
+	for( int i = 0; i < n; i++ )
+		v(i1 + i) = rng_uniform53(w[2*i], w[2*i+1]);
+}
+
+
+/*
+	Each element of bin gets the index of a category drawn with the
+	probabilities p (which need not sum to one).
+*/
+void rng_stream::fill_multinomial(ivector& bin, const dvector& p)
+{
+	int p1 = p.indexmin();
+	int p2 = p.indexmax();
+	dvector cum(p1,p2);
+	double s = 0;
+	for(int j = p1; j <= p2; j++ )
+	{
+		s += p(j);
+		cum(j) = s;
+	}
+	int b1 = bin.indexmin();
+	if( bin.indexmax() < b1 ) return;
+	dvector u(b1,bin.indexmax());
+	fill_randu(u);
+	for(int i = b1; i <= bin.indexmax(); i++ )
+	{
+		double x = u(i) * s;
+		int lo = p1, hi = p2;
+		while( lo < hi )
+		{
+			int mid = (lo + hi) / 2;
+			if( cum(mid) < x ) lo = mid + 1;
+			else               hi = mid;
+		}
+		bin(i) = lo;
+	}
+}
+
+
+rng_service::rng_service(unsigned long _seed)
+: m_seed(_seed)
+{}
+
+unsigned long rng_service::seed() const
+{
+	return m_seed;
+}
+
+rng_stream rng_service::stream(unsigned long _replicate, int _year, int _purpose) const
+{
+	return rng_stream(m_seed, _replicate, _year, _purpose);
+}
+
+
+/*
+	Binomial deviate.  BTPE (triangle, parallelogram and exponential
+	regions with squeezes) when n min(p,1-p) >= 30, otherwise inversion
+	from 0 upwards; both on min(p,1-p), reflected at the end.
+*/
+int rng_stream::binomial(int n, double p)
+{
+	if( n <= 0 || p <= 0 ) return 0;
+	if( p >= 1 ) return n;
+	double r = p < 0.5 ? p : 1.0 - p;
+	double q = 1.0 - r;
+	long y;
+
+	if( n * r < 30.0 )
+	{
+		double qn    = exp(n * log(q));
+		double np    = n * r;
+		double bound = np + 10.0 * sqrt(np * q + 1.0);
+		if( bound > n ) bound = n;
+		double px = qn;
+		double U  = uniform();
+		y = 0;
+		while( U > px )
+		{
+			y++;
+			if( y > bound )
+			{
+				y  = 0;
+				px = qn;
+				U  = uniform();
+			}
+			else
+			{
+				U -= px;
+				px = ((n - y + 1) * r * px) / (y * q);
+			}
+		}
+		return (int)(p > 0.5 ? n - y : y);
+	}
+
+	double fm   = n * r + r;
+	long   m    = (long)floor(fm);
+	double p1   = floor(2.195 * sqrt(n * r * q) - 4.6 * q) + 0.5;
+	double xm   = m + 0.5;
+	double xl   = xm - p1;
+	double xr   = xm + p1;
+	double c    = 0.134 + 20.5 / (15.3 + m);
+	double a    = (fm - xl) / (fm - xl * r);
+	double laml = a * (1.0 + a / 2.0);
+	a           = (xr - fm) / (xr * q);
+	double lamr = a * (1.0 + a / 2.0);
+	double p2   = p1 * (1.0 + 2.0 * c);
+	double p3   = p2 + c / laml;
+	double p4   = p3 + c / lamr;
+	double nrq  = n * r * q;
+
+	for(;;)
+	{
+		double u = uniform() * p4;
+		double v = uniform();
+		if( u <= p1 )
+		{
+			y = (long)floor(xm - p1 * v + u);
+			break;
+		}
+		if( u <= p2 )
+		{
+			double x = xl + (u - p1) / c;
+			v = v * c + 1.0 - fabs(m - x + 0.5) / p1;
+			if( v > 1.0 ) continue;
+			y = (long)floor(x);
+		}
+		else if( u <= p3 )
+		{
+			y = (long)floor(xl + log(v) / laml);
+			if( y < 0 ) continue;
+			v = v * (u - p2) * laml;
+		}
+		else
+		{
+			y = (long)floor(xr - log(v) / lamr);
+			if( y > n ) continue;
+			v = v * (u - p3) * lamr;
+		}
+
+		long k = labs(y - m);
+		if( k <= 20 || k >= nrq / 2.0 - 1 )
+		{
+			/* explicit ratio of probabilities f(y)/f(m) */
+			double s  = r / q;
+			double aa = s * (n + 1);
+			double F  = 1.0;
+			if( m < y )
+				for(long i = m + 1; i <= y; i++ ) F *= (aa / i - s);
+			else if( m > y )
+				for(long i = y + 1; i <= m; i++ ) F /= (aa / i - s);
+			if( v > F ) continue;
+			break;
+		}
+
+		/* squeeze on log(f(y)/f(m)), then the Stirling bound */
+		double rho = (k / nrq) * ((k * (k / 3.0 + 0.625) + 0.1666666666666667) / nrq + 0.5);
+		double t   = -(double)k * k / (2.0 * nrq);
+		double A   = log(v);
+		if( A < t - rho ) break;
+		if( A > t + rho ) continue;
+		double x1 = y + 1.0, f1 = m + 1.0, z = n + 1.0 - m, w = n - y + 1.0;
+		double x2 = x1 * x1, f2 = f1 * f1, z2 = z * z, w2 = w * w;
+		double bound = xm * log(f1 / x1) + (n - m + 0.5) * log(z / w) + (y - m) * log(w * r / (x1 * q))
+		             + (13680. - (462. - (132. - (99. - 140. / f2) / f2) / f2) / f2) / f1 / 166320.
+		             + (13680. - (462. - (132. - (99. - 140. / z2) / z2) / z2) / z2) / z / 166320.
+		             + (13680. - (462. - (132. - (99. - 140. / x2) / x2) / x2) / x2) / x1 / 166320.
+		             + (13680. - (462. - (132. - (99. - 140. / w2) / w2) / w2) / w2) / w / 166320.;
+		if( A > bound ) continue;
+		break;
+	}
+	return (int)(p > 0.5 ? n - y : y);
+}
+
+
+/* Gamma(a,1) deviate, Marsaglia and Tsang; a < 1 through Gamma(a+1) u^(1/a) */
+double rng_stream::gamma(double a)
+{
+	if( a < 1.0 )
+		return gamma(a + 1.0) * pow(uniform(), 1.0 / a);
+	double d = a - 1.0 / 3.0;
+	double c = 1.0 / sqrt(9.0 * d);
+	for(;;)
+	{
+		double x = normal();
+		double v = 1.0 + c * x;
+		if( v <= 0 ) continue;
+		v = v * v * v;
+		double u  = uniform();
+		double x2 = x * x;
+		if( u < 1.0 - 0.0331 * x2 * x2 ) return d * v;
+		if( log(u) < 0.5 * x2 + d * (1.0 - v + log(v)) ) return d * v;
+	}
+}
+
+
+/*
+	Counts of a sample of size n with probabilities p (which need not sum
+	to one), into x (same index range as p).  Each bin is a binomial of
+	what is left of the sample, with its share of what is left of the
+	probability.
+*/
+void rng_stream::multinomial(int n, const dvector& p, dvector& x)
+{
+	int p1 = p.indexmin();
+	int p2 = p.indexmax();
+	double s = 0;
+	for(int j = p1; j <= p2; j++ )
+		s += p(j);
+	int left = n;
+	for(int j = p1; j <= p2; j++ )
+	{
+		if( left == 0 || s <= 0 )
+		{
+			x(j) = 0;
+			continue;
+		}
+		double pj = p(j);	// p and x may be the same vector
+		int c = (j == p2) ? left : binomial(left, pj / s);
+		x(j)  = c;
+		left -= c;
+		s    -= pj;
+	}
+}
+
+
+/* Dirichlet deviate with parameters alpha, into x */
+void rng_stream::dirichlet(const dvector& alpha, dvector& x)
+{
+	double s = 0;
+	for(int j = alpha.indexmin(); j <= alpha.indexmax(); j++ )
+	{
+		x(j) = alpha(j) > 0 ? gamma(alpha(j)) : 0.;
+		s   += x(j);
+	}
+	for(int j = alpha.indexmin(); j <= alpha.indexmax(); j++ )
+		x(j) /= s;
+}
+
+
+/*
+	Dirichlet-multinomial counts for a sample of size n with expected
+	proportions p, linear parameterization: the Dirichlet parameters are
+	theta n p, so the effective sample size is (1 + theta n)/(1 + theta).
+*/
+void rng_stream::dirichlet_multinomial(int n, const dvector& p, double theta, dvector& x)
+{
+	double s = 0;
+	for(int j = p.indexmin(); j <= p.indexmax(); j++ )
+		s += p(j);
+	for(int j = p.indexmin(); j <= p.indexmax(); j++ )
+		x(j) = theta * n * p(j) / s;
+	dirichlet(x, x);
+	multinomial(n, x, x);
+}
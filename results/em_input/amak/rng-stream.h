@@ -0,0 +1,103 @@
+/**
+	This is a class for counter-based random number streams (Philox4x32-10,
+	Salmon et al. 2011, "Parallel random numbers: as easy as 1, 2, 3").
+
+	A stream is addressed by (seed, replicate, year, purpose): the seed and
+	purpose are the key, and the replicate and year are part of the
+	counter.  The numbers of a stream do not depend on what else has been
+	drawn, or in what order, so simulation replicates (and the years and
+	data sources within them) can be generated in any order, on any number
+	of threads, with the same results.  rng_service holds the seed and
+	hands out streams.
+
+	The operating model runs once per mceval draw, so its replicates are
+	numbered across draws: replicate isim of draw mc_count (counted from
+	1) is (mc_count-1)*nsims + isim, and no two draws share deviates.
+
+	multinomial draws the counts directly, bin by bin, as binomials
+	conditional on the counts so far (BTPE, Kachitvichyanukul and Schmeiser
+	1988, for large n p and inversion otherwise), so the cost is in the
+	number of bins rather than the sample size.  dirichlet uses gamma
+	deviates (Marsaglia and Tsang 2000), and dirichlet_multinomial is a
+	multinomial with Dirichlet probabilities, in the linear
+	parameterization of dirichlet-multinomial.h.
+
+	fill_randn, fill_randu and fill_multinomial follow the ADMB functions of
+	the same name with a random_number_generator.  They generate whole
+	Philox blocks at a time (two uniforms, or one pair of normal deviates,
+	per block), looping over the blocks innermost so that the compiler can
+	vectorise the rounds; each fill starts a fresh block.
+*/
+
+#include <admodel.h>
+
+#ifndef RNG_STREAM_H
+#define RNG_STREAM_H
+
+/* purposes; for data by fishery or index, the fishery or index number is added */
+enum rng_purpose
+{
+	RNG_REC_DEV  = 1,	// recruitment deviations
+	RNG_OM_INDEX = 2,	// index observations in the operating model
+	RNG_IND_OBS  = 100,	// index observation errors
+	RNG_FSH_AGE  = 200,	// fishery age compositions
+	RNG_IND_AGE  = 300,	// index age compositions
+	RNG_EFFORT   = 400,	// fishery effort
+	/* the same data again for the bootstrap files (Write_Datafile) */
+	RNG_BOOT_IND_OBS = 500,
+	RNG_BOOT_FSH_AGE = 600,
+	RNG_BOOT_IND_AGE = 700,
+	RNG_BOOT_EFFORT  = 800
+};
+
+class rng_stream
+{
+private:
+	unsigned int m_key[2];	// seed and purpose.
+	unsigned int m_ctr[4];	// block number, year and replicate (two words).
+	unsigned int m_out[4];	// Current block of output.
+	int          m_used;	// Words of m_out already used.
+	bool         m_bSpare;	// A second normal deviate is waiting in m_dSpare.
+	double       m_dSpare;
+
+	void   next_block();
+	unsigned int next_word();
+	void   blocks(int nb, unsigned int* out);
+
+public:
+	~rng_stream();
+	rng_stream(unsigned long _seed, unsigned long _replicate, int _year = 0, int _purpose = 0);
+
+	double uniform();	// on (0,1), 53 bits
+	double normal();
+
+	void fill_randn(dvector& v);
+	void fill_randu(dvector& v);
+	void fill_multinomial(ivector& bin, const dvector& p);
+
+	/* samplers for composition data; results are written into x */
+	int    binomial(int n, double p);
+	double gamma(double a);
+	void   multinomial(int n, const dvector& p, dvector& x);
+	void   dirichlet(const dvector& alpha, dvector& x);
+	void   dirichlet_multinomial(int n, const dvector& p, double theta, dvector& x);
+
+	/* one Philox4x32-10 block for counter ctr and key key, for checking against the reference */
+	static void philox_block(const unsigned int ctr[4], const unsigned int key[2], unsigned int out[4]);
+};
+
+
+class rng_service
+{
+private:
+	unsigned long m_seed;
+
+public:
+	rng_service(unsigned long _seed);
+
+	unsigned long seed() const;
+	rng_stream stream(unsigned long _replicate, int _year, int _purpose) const;
+};
+
+
+#endif
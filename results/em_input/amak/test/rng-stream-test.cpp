@@ -0,0 +1,297 @@
+/**
+	Checks that the random number streams of the simulated data sets
+	(Write_SimDatafile) and of the bootstrap data sets (Write_Datafile)
+	are distinct: for the same seed, replicate, year and fishery or
+	index, the two purposes must give different deviates, and so must
+	the same replicate in two mceval draws.  The purposes of the data
+	sources must not overlap for up to 99 fisheries or indices.
+
+	The Philox blocks are checked against the known-answer vectors of
+	Random123 (kat_vectors, philox4x32 10), normal() and fill_randn against
+	values recorded at one address, and the replicates drawn on a pool of
+	four threads against those drawn on one.
+
+	The samplers are checked by the mean and variance of many draws:
+	binomial on the inversion (n p < 30) and BTPE branches, for p on both
+	sides of 1/2, and gamma for shapes below and above 1.  Multinomial
+	and Dirichlet-multinomial counts must sum to the sample size and
+	Dirichlet proportions to one, with the expected means by bin.
+
+	Build and run with "make check" in this directory (ADMB_HOME set).
+	It prints the failed checks and returns 1 if there are any.
+*/
+
+#include <admodel.h>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <vector>
+#include "rng-stream.h"
+#include "replicate-pool.h"
+
+static int nfail = 0;
+
+static void check(bool ok, const char* what, unsigned long rep, int year, int k)
+{
+	if( !ok )
+	{
+		printf("FAILED: %s (replicate %lu, year %d, source %d)\n", what, rep, year, k);
+		nfail++;
+	}
+}
+
+
+static bool same(const dvector& x, const dvector& y)
+{
+	for(int i = x.indexmin(); i <= x.indexmax(); i++ )
+		if( x(i) != y(i) )
+			return false;
+	return true;
+}
+
+
+/* normal deviates of two purposes at the same address */
+static bool same_randn(const rng_service& rng, unsigned long rep, int year, int p1, int p2)
+{
+	dvector x(1,30);
+	dvector y(1,30);
+	rng.stream(rep,year,p1).fill_randn(x);
+	rng.stream(rep,year,p2).fill_randn(y);
+	return same(x,y);
+}
+
+
+/* multinomial age compositions of two purposes at the same address */
+static bool same_multinomial(const rng_service& rng, unsigned long rep, int year, int p1, int p2)
+{
+	dvector p(1,15);
+	dvector x(1,15);
+	dvector y(1,15);
+	for(int a = 1; a <= 15; a++ )
+		p(a) = 1. / 15.;
+	rng.stream(rep,year,p1).multinomial(200,p,x);
+	rng.stream(rep,year,p2).multinomial(200,p,y);
+	return same(x,y);
+}
+
+
+/*
+	Sample mean and variance of x against mean and var, within four
+	standard errors (that of the variance from the fourth central moment).
+*/
+static void moments(const char* what, const std::vector<double>& x, double mean, double var)
+{
+	double n = x.size();
+	double m = 0;
+	for(size_t i = 0; i < x.size(); i++ )
+		m += x[i];
+	m /= n;
+	double v = 0, m4 = 0;
+	for(size_t i = 0; i < x.size(); i++ )
+	{
+		double d2 = (x[i] - m) * (x[i] - m);
+		v  += d2;
+		m4 += d2 * d2;
+	}
+	v  /= n - 1;
+	m4 /= n;
+	if( fabs(m - mean) > 4 * sqrt(var / n) || fabs(v - var) > 4 * sqrt((m4 - v * v) / n) )
+	{
+		printf("FAILED: %s (mean %g, expected %g; variance %g, expected %g)\n", what, m, mean, v, var);
+		nfail++;
+	}
+}
+
+
+/* deviates of replicates 1..nrep drawn on nthreads threads, one row per replicate */
+static void draw_replicates(const rng_service& rng, int nthreads, int nrep, dmatrix& z, dmatrix& ages)
+{
+	dvector p(1,15);
+	for(int a = 1; a <= 15; a++ )
+		p(a) = a <= 8 ? a : 16 - a;
+	replicate_pool pool(nthreads);
+	pool.run(nrep, [&](int isim)
+	{
+		rng.stream(isim,0,RNG_REC_DEV).fill_randn(z(isim));
+		rng.stream(isim,1990,RNG_FSH_AGE+1).multinomial(500,p,ages(isim));
+	});
+}
+
+
+int main()
+{
+	/* Random123 known-answer vectors: counter, key, result */
+	const unsigned int kat[3][10] = {
+		{0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u, 0x00000000u,
+		 0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u},
+		{0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu, 0xffffffffu,
+		 0x408f276du, 0x41c83b0eu, 0xa20bc7c6u, 0x6d5451fdu},
+		{0x243f6a88u, 0x85a308d3u, 0x13198a2eu, 0x03707344u, 0xa4093822u, 0x299f31d0u,
+		 0xd16cfe09u, 0x94fdccebu, 0x5001e420u, 0x24126ea1u}};
+	for(int v = 0; v < 3; v++ )
+	{
+		unsigned int out[4];
+		rng_stream::philox_block(kat[v], kat[v] + 4, out);
+		for(int i = 0; i < 4; i++ )
+			check(out[i] == kat[v][6+i], "Philox4x32-10 known answer", 0, 0, v + 1);
+	}
+
+	/* recorded at seed 1234567, replicate 1, year 1990, recruitment deviations */
+	const double recorded[5] = {-0.001248588859515383, -0.52125516937085592, 1.6798993540130363,
+		1.7987167497022643, 0.34457673712977388};
+	{
+		rng_service rng(1234567);
+		rng_stream s = rng.stream(1,1990,RNG_REC_DEV);
+		for(int i = 0; i < 5; i++ )
+			check(fabs(s.normal() - recorded[i]) < 1e-13, "normal() at a fixed address", 1, 1990, i + 1);
+		dvector x(1,5);
+		rng.stream(1,1990,RNG_REC_DEV).fill_randn(x);
+		for(int i = 1; i <= 5; i++ )
+			check(fabs(x(i) - recorded[i-1]) < 1e-13, "fill_randn at a fixed address", 1, 1990, i);
+	}
+
+	/* the same deviates on one thread and on four */
+	{
+		rng_service rng(123);
+		const int nrep = 64;
+		dmatrix z1(1,nrep,1,25), z4(1,nrep,1,25);
+		dmatrix a1(1,nrep,1,15), a4(1,nrep,1,15);
+		draw_replicates(rng, 1, nrep, z1, a1);
+		draw_replicates(rng, 4, nrep, z4, a4);
+		for(int isim = 1; isim <= nrep; isim++ )
+		{
+			check(same(z1(isim),z4(isim)), "normal deviates with 1 and 4 threads", isim, 0, 0);
+			check(same(a1(isim),a4(isim)), "age compositions with 1 and 4 threads", isim, 1990, 1);
+		}
+	}
+
+	const int base[] = {RNG_REC_DEV, RNG_OM_INDEX,
+		RNG_IND_OBS, RNG_FSH_AGE, RNG_IND_AGE, RNG_EFFORT,
+		RNG_BOOT_IND_OBS, RNG_BOOT_FSH_AGE, RNG_BOOT_IND_AGE, RNG_BOOT_EFFORT};
+	std::set<int> used;
+	for(int b = 0; b < 10; b++ )
+	{
+		int nk = base[b] < 100 ? 0 : 99;
+		for(int k = (nk > 0 ? 1 : 0); k <= nk; k++ )
+			check(used.insert(base[b] + k).second, "purpose used twice", 0, 0, base[b] + k);
+	}
+
+	/* samplers */
+	{
+		rng_service rng(20240601);
+		const int ndraw = 100000;
+		const int    bn[4] = {20, 40, 1000, 5000};
+		const double bp[4] = {0.3, 0.9, 0.4, 0.97};	// n min(p,1-p) 6, 4, 400, 150
+		const char*  bwhat[4] = {"binomial, inversion", "binomial, inversion, p > 1/2",
+			"binomial, BTPE", "binomial, BTPE, p > 1/2"};
+		for(int t = 0; t < 4; t++ )
+		{
+			rng_stream st = rng.stream(1,0,t + 1);
+			std::vector<double> x(ndraw);
+			for(int i = 0; i < ndraw; i++ )
+				x[i] = st.binomial(bn[t], bp[t]);
+			moments(bwhat[t], x, bn[t] * bp[t], bn[t] * bp[t] * (1 - bp[t]));
+		}
+
+		const double shape[2] = {0.4, 3.5};
+		const char*  gwhat[2] = {"gamma, shape < 1", "gamma, shape > 1"};
+		for(int t = 0; t < 2; t++ )
+		{
+			rng_stream st = rng.stream(2,0,t + 1);
+			std::vector<double> x(ndraw);
+			for(int i = 0; i < ndraw; i++ )
+				x[i] = st.gamma(shape[t]);
+			moments(gwhat[t], x, shape[t], shape[t]);
+		}
+
+		/* compositions: sums, and the means by bin */
+		const int nbin = 10, nsamp = 150, ncomp = 20000;
+		const double theta = 0.05;
+		dvector p(1,nbin), alpha(1,nbin), x(1,nbin);
+		for(int a = 1; a <= nbin; a++ )
+		{
+			p(a)     = a / 55.;
+			alpha(a) = 0.5 * a;
+		}
+		dmatrix sum(1,3,1,nbin);
+		sum.initialize();
+		rng_stream st = rng.stream(3,0,1);
+		for(int i = 0; i < ncomp; i++ )
+		{
+			double tot;
+			st.multinomial(nsamp,p,x);
+			tot = 0;
+			for(int a = 1; a <= nbin; a++ )
+			{
+				tot      += x(a);
+				sum(1,a) += x(a);
+			}
+			check(tot == nsamp, "multinomial counts sum to n", i, 0, 0);
+
+			st.dirichlet(alpha,x);
+			tot = 0;
+			for(int a = 1; a <= nbin; a++ )
+			{
+				tot      += x(a);
+				sum(2,a) += x(a);
+			}
+			check(fabs(tot - 1) < 1e-12, "Dirichlet proportions sum to one", i, 0, 0);
+
+			st.dirichlet_multinomial(nsamp,p,theta,x);
+			tot = 0;
+			for(int a = 1; a <= nbin; a++ )
+			{
+				tot      += x(a);
+				sum(3,a) += x(a);
+			}
+			check(tot == nsamp, "Dirichlet-multinomial counts sum to n", i, 0, 0);
+		}
+		for(int a = 1; a <= nbin; a++ )
+		{
+			double pa = alpha(a) / 27.5;
+			check(fabs(sum(1,a) / ncomp - nsamp * p(a)) < 4 * sqrt(nsamp * p(a) * (1 - p(a)) / ncomp),
+				"multinomial mean", 0, 0, a);
+			check(fabs(sum(2,a) / ncomp - pa) < 4 * sqrt(pa * (1 - pa) / 28.5 / ncomp),
+				"Dirichlet mean", 0, 0, a);
+			// variance n p (1-p) n / N, N = (1 + theta n)/(1 + theta) the effective sample size
+			double vdm = nsamp * p(a) * (1 - p(a)) * nsamp * (1 + theta) / (1 + theta * nsamp);
+			check(fabs(sum(3,a) / ncomp - nsamp * p(a)) < 4 * sqrt(vdm / ncomp),
+				"Dirichlet-multinomial mean", 0, 0, a);
+		}
+	}
+
+	const int nsims = 20;
+	unsigned long seeds[] = {123, 1234567};
+	for(int s = 0; s < 2; s++ )
+	{
+		rng_service rng(seeds[s]);
+		for(unsigned long rep = 1; rep <= nsims; rep++ )
+		{
+			for(int k = 1; k <= 3; k++ )
+			{
+				check(!same_randn(rng,rep,0,RNG_IND_OBS+k,RNG_BOOT_IND_OBS+k), "index errors", rep, 0, k);
+				check(!same_randn(rng,rep,0,RNG_EFFORT+k,RNG_BOOT_EFFORT+k), "effort", rep, 0, k);
+				for(int year = 1977; year <= 2020; year++ )
+				{
+					check(!same_multinomial(rng,rep,year,RNG_FSH_AGE+k,RNG_BOOT_FSH_AGE+k), "fishery ages", rep, year, k);
+					check(!same_multinomial(rng,rep,year,RNG_IND_AGE+k,RNG_BOOT_IND_AGE+k), "index ages", rep, year, k);
+				}
+			}
+			check(same_randn(rng,rep,0,RNG_REC_DEV,RNG_REC_DEV), "same address, same deviates", rep, 0, 0);
+			// replicate rep of the second mceval draw is nsims + rep
+			dvector x(1,30);
+			dvector y(1,30);
+			rng.stream(rep,0,RNG_REC_DEV).fill_randn(x);
+			rng.stream(nsims + rep,0,RNG_REC_DEV).fill_randn(y);
+			check(!same(x,y), "recruitment deviates of two mceval draws", rep, 0, 0);
+		}
+	}
+
+	if( nfail > 0 )
+	{
+		printf("%d checks failed\n", nfail);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include <admodel.h>
+#include <iomanip>
+#include <sstream>
+#include "warm-start.h"
+
+warm_start::~warm_start()
+{
+	close();
+}
+
+warm_start::warm_start()
+: m_nRestored(0)
+{}
+
+
+int warm_start::read(const adstring& file)
+{
+	m_mRec.clear();
+	m_nRestored = 0;
+	std::ifstream in((const char*)file);
+	std::string line;
+	while( std::getline(in,line) )
+	{
+		std::istringstream is(line);
+		std::string label;
+		int lo, hi;
+		if( !(is >> label >> lo >> hi) || hi < lo )
+			continue;
+		dvector x(lo,hi);
+		int i = lo;
+		while( i <= hi && (is >> x(i)) )
+			i++;
+		if( i > hi )
+			m_mRec.insert(std::make_pair(label,x));
+	}
+	return(nrecords());
+}
+
+
+void warm_start::open(const adstring& file)
+{
+	close();
+	m_mRec.clear();
+	m_out.open((const char*)file);
+	m_out << std::setprecision(17);
+}
+
+
+void warm_start::close()
+{
+	if( m_out.is_open() )
+		m_out.close();
+}
+
+
+void warm_start::put(const adstring& label, const dvector& x)
+{
+	m_out << label << " " << x.indexmin() << " " << x.indexmax();
+	for(int i = x.indexmin(); i <= x.indexmax(); i++ )
+		m_out << " " << x(i);
+	m_out << "\n";
+}
+
+
+const dvector* warm_start::find(const adstring& label) const
+{
+	std::map<std::string,dvector>::const_iterator it = m_mRec.find(std::string((const char*)label));
+	return(it == m_mRec.end() ? 0 : &it->second);
+}
+
+
+void warm_start::item(const adstring& label, prevariable& x)
+{
+	if( m_out.is_open() )
+	{
+		dvector v(1,1);
+		v(1) = value(x);
+		put(label,v);
+	}
+	else if( const dvector* v = find(label) )
+	{
+		if( v->indexmin() == 1 && v->indexmax() == 1 )
+		{
+			x = (*v)(1);
+			m_nRestored++;
+		}
+	}
+}
+
+
+/*
+	Copies the indices that the record and x have in common.
+*/
+void warm_start::item(const adstring& label, dvar_vector& x)
+{
+	if( !allocated(x) )
+		return;
+	if( m_out.is_open() )
+		put(label,value(x));
+	else if( const dvector* v = find(label) )
+	{
+		int i1 = x.indexmin() > v->indexmin() ? x.indexmin() : v->indexmin();
+		int i2 = x.indexmax() < v->indexmax() ? x.indexmax() : v->indexmax();
+		for(int i = i1; i <= i2; i++ )
+			x(i) = (*v)(i);
+		if( i2 >= i1 )
+			m_nRestored += i2 - i1 + 1;
+	}
+}
+
+
+void warm_start::item(const adstring& label, dvar_matrix& x)
+{
+	if( !allocated(x) )
+		return;
+	for(int i = x.rowmin(); i <= x.rowmax(); i++ )
+		item(label + "[" + str(i) + "]", x(i));
+}
+
+
+int warm_start::nrecords() const
+{
+	return(int(m_mRec.size()));
+}
+
+
+int warm_start::nrestored() const
+{
+	return(m_nRestored);
+}
@@ -0,0 +1,59 @@
+/**
+	This is a class for warm starts: the parameter values of a converged
+	fit are written at the end of the run, with the index range of each
+	vector, and read back at the start of another run of the same model
+	(-wst option) to replace the initial values.
+
+	Values are matched by label and index, not by position as in a .pin
+	file, so the fits need not have the same dimensions.  The fit of a
+	retrospective peel has one year less of recruitment deviations and
+	fishing mortality than the fit before it, and may have fewer
+	selectivity blocks: the years and blocks the two have in common are
+	copied and the others keep their initial values.
+
+	The same list of item() calls writes and restores the parameters:
+	after open() each call writes a record, after read() each call copies
+	the record with that label, if there is one, into the parameter.  A
+	record is one line, "label indexmin indexmax values"; matrix rows are
+	records of their own, labelled "label[i]".
+*/
+
+#include <admodel.h>
+#include <fstream>
+#include <map>
+#include <string>
+
+#ifndef WARM_START_H
+#define WARM_START_H
+
+class warm_start
+{
+private:
+	std::map<std::string,dvector> m_mRec;	// Records read, by label.
+	std::ofstream m_out;
+	int         m_nRestored;	// Values copied into parameters.
+
+	void put(const adstring& label, const dvector& x);
+	const dvector* find(const adstring& label) const;
+
+public:
+	~warm_start();
+	warm_start();
+
+	/* read the records of a previous fit; returns the number of records */
+	int  read(const adstring& file);
+	/* write the items that follow to file */
+	void open(const adstring& file);
+	void close();
+
+	void item(const adstring& label, prevariable& x);
+	void item(const adstring& label, dvar_vector& x);
+	void item(const adstring& label, dvar_matrix& x);
+
+	/* getters */
+	int  nrecords() const;
+	int  nrestored() const;
+};
+
+
+#endif
@@ -70,8 +70,28 @@
                                        no remainders method in wrt_r_complete_vector,
                                        wrt_r_matrix, and wrt_r_df_col to a method that
                                        increments a counter for better consistency.
+* Version 1.15          17 Oct 2026     Output now goes through rdat_buffer, a single
+                                       growable byte buffer written to disk in large
+                                       blocks.  Numbers are formatted directly into the
+                                       buffer and row/column names are built without
+                                       stringstream conversions.  Files are byte-identical
+                                       to the previous output for the same digits
+                                       setting, so the version string is unchanged.
+* Version 1.15          17 Oct 2026     Added a binary columnar backend, selected with
+                                       open_r_file(fname, numdigits, ismissing,
+                                       ADMB2R_BINARY).  Same calling sequence as the
+                                       text file; see BINARY BACKEND below for the
+                                       layout and R/read_rbin.R for the reader.
+* Version 1.15          17 Oct 2026     Moved all file state into class RWriter so that
+                                       several R files can be written at once (one
+                                       writer per model or thread).  The free functions
+                                       keep their signatures and write through
+                                       default_rwriter.  Removed the global loop
+                                       counter i; the error log is opened per write.
 *********************************************************************************/
 #include <ctime>         // needed for timestamp
+#include <cstdio>        // snprintf, used to format doubles into the output buffer
+#include <climits>       // INT_MIN, the NA integer in binary output
 #include <string>        // string manipulation routines
 #include <vector>        // vectors -- no need to manage array allocation by hand
 #include <iomanip>       // needed to set precision
@@ -88,52 +108,407 @@
 
 using namespace std;
 
-// GLOBAL VARIABLES
+//=====================================================================================
+// rdat_buffer
+//
+// Output sink for the R file.  Replaces the ofstream formerly used for rfile and keeps
+// the same interface (open, is_open, bad, close and operator<<), so the writing
+// routines below are unchanged.  Text is appended to one growable buffer that is
+// handed to the file in blocks of blocksize bytes.
+//
+// Integers are converted by hand.  Doubles are converted with snprintf using the same
+// conversion an ostream applies: "%.6g" by default, or "%.<digits>e" once set_digits
+// has been called with digits > 0.  As with the ofstream, the format persists across
+// close and re-open.
+//=====================================================================================
+class rdat_buffer {
+public:
+    rdat_buffer() : len(0), flushed(0), scientific(false), prec(6) {}
+    ~rdat_buffer() { close(); }
+
+    void open(const char* fname, bool binary = false) {
+        len = 0;
+        flushed = 0;
+        if ( binary ) file.open(fname, ios::out | ios::binary);
+        else file.open(fname);
+        if ( buf.size() < blocksize ) buf.resize(blocksize);
+    }
+    bool is_open() const { return file.is_open(); }
+    bool bad() const { return file.bad(); }
+    void close() {
+        if ( ! file.is_open() ) return;
+        flush();
+        file.close();
+    }
+    void flush() {
+        if ( len > 0 ) file.write(&buf[0], len);
+        flushed += len;
+        len = 0;
+    }
+    size_t pos() const { return flushed + len; }   // bytes written since open
 
-const char* version = "1.15";               // Version number
-int i;                                      // For indices
+    // digits > 0 switches to scientific notation with that many decimals
+    void set_digits(int numdigits) {
+        if ( numdigits > 0 ) {
+            scientific = true;
+            prec = numdigits;
+        }
+    }
+
+    void write(const char* s, size_t n) {
+        reserve(n);
+        memcpy(&buf[len], s, n);
+        len += n;
+    }
+    rdat_buffer& operator<<(const char* s) { write(s, strlen(s)); return *this; }
+    rdat_buffer& operator<<(const string& s) { write(s.data(), s.size()); return *this; }
+    rdat_buffer& operator<<(char c) { reserve(1); buf[len++] = c; return *this; }
+    rdat_buffer& operator<<(int n) {
+        reserve(12);
+        len += format_int(&buf[len], n);
+        return *this;
+    }
+    rdat_buffer& operator<<(double x) {
+        size_t room = prec + 32;             // sign, digits, point, exponent and slack
+        reserve(room);
+        len += snprintf(&buf[len], room, scientific ? "%.*e" : "%.*g", prec, x);
+        return *this;
+    }
+    rdat_buffer& operator<<(const prevariable& x) { return *this << value(x); }
+    // endl is the only manipulator used on rfile; no need to flush the buffer for it
+    rdat_buffer& operator<<(ostream& (*)(ostream&)) { return *this << '\n'; }
+
+    // write the decimal digits of n to s (no terminator); returns the number of chars
+    static size_t format_int(char* s, int n) {
+        char tmp[12];
+        size_t k = 0, j = 0;
+        unsigned int u = ( n < 0 ) ? 0u - (unsigned int)n : (unsigned int)n;
+        do {
+            tmp[k++] = char('0' + u % 10);
+            u /= 10;
+        } while ( u > 0 );
+        if ( n < 0 ) s[j++] = '-';
+        while ( k > 0 ) s[j++] = tmp[--k];
+        return j;
+    }
 
+private:
+    static const size_t blocksize = 1 << 18;  // 256 KB per write to disk
 
-// ** File I/O Variables
+    // make sure n more bytes fit, flushing first and growing only if n is very large
+    void reserve(size_t n) {
+        if ( len + n <= buf.size() ) return;
+        flush();
+        if ( n > buf.size() ) buf.resize(n);
+    }
 
-string outfile;                             // output file name
-ofstream rfile;                             // ofstream for output file
-ofstream errfile;                           // output stream for error message
-string err_msg = "ADMB2R error messages:  ";   // error message
+    ofstream file;
+    vector<char> buf;
+    size_t len;                              // bytes in use in buf
+    size_t flushed;                          // bytes already handed to file
+    bool scientific;
+    int prec;
+};
 
+//=====================================================================================
+// append_quoted
+//
+// Append an integer, enclosed in double quotes, to a list of row or column names.
+// Same text as quote + convert<string>(n) + quote, without the stringstream.
+//=====================================================================================
+void append_quoted(string& s, int n) {
+    char tmp[14];
+    size_t k = 0;
+    tmp[k++] = '"';
+    k += rdat_buffer::format_int(tmp + k, n);
+    tmp[k++] = '"';
+    s.append(tmp, k);
+}
+
+// GLOBAL VARIABLES
+
+const char* version = "1.15";               // Version number
+const char* quote = "\"";                   // Double-quote character (")
+const char* cquote = ",\"";                 // comma plus double quote (,")
+imatrix dum_matrix;                         // ( Placeholders for the optional NA matrix
+ivector dum_vector;                         // ( and vector arguments; never read unless
+                                            // ( isna is true
 
-// ** General Housekeeping Variables
+//=====================================================================================
+// BINARY BACKEND
+//
+// open_r_file(fname, numdigits, ismissing, ADMB2R_BINARY) writes the same tree of R
+// objects to a binary columnar file instead of dget text.  The public routines check
+// rbinary and hand off to the rbin_ routine of the same purpose, so calling
+// code (e.g. make-Rfile_asap3.cxx) is the same for both backends.  Values are written
+// at full double precision; "digits" applies only to text output.
+//
+// File layout.  All numbers are little-endian; offsets are bytes from start of file.
+//
+//   magic      8 bytes "ADMB2RB1"
+//   data       one array per object, each starting on an 8-byte boundary:
+//                logical, integer  int32, NA = INT_MIN (R's NA_integer_)
+//                double            float64, NA = R's NA_real_ bit pattern
+//                string            uint32 count, then per string uint32 length and
+//                                  bytes; NA has length 0xFFFFFFFF
+//              matrices are stored column-major; names are string arrays
+//   directory  one record per object, in the order objects were opened:
+//                int32   parent    record number of enclosing list or data frame,
+//                                  -1 at top level
+//                int32   kind      1 list, 2 data frame, 3 vector, 4 matrix
+//                int32   type      0 none, 1 logical, 2 integer, 3 double, 4 string
+//                int32   nrow      vector length, matrix or data frame rows
+//                int32   ncol      matrix columns; 1 for vectors
+//                uint64  data      offset of the values, 0 = none
+//                uint64  names1    offset of names / row names, 0 = NULL
+//                uint64  names2    offset of column names, 0 = NULL
+//                uint32 length and bytes of the object name
+//   trailer    uint64 directory offset, uint32 record count, uint32 0, "ADMB2RB1"
+//
+// R/read_rbin.R reads the file back into the list dget() returns for the text file;
+// the only difference is that integer data come back as integer, not double.
+//=====================================================================================
+const int ADMB2R_TEXT = 0;                  // open_r_file format: dget text (.rdat)
+const int ADMB2R_BINARY = 1;                // open_r_file format: binary columnar (.rbin)
+
+const int RBIN_LIST = 1;                    // directory record kinds
+const int RBIN_DF = 2;
+const int RBIN_VECTOR = 3;
+const int RBIN_MATRIX = 4;
+
+const int RBIN_NONE = 0;                    // directory record types
+const int RBIN_LOGICAL = 1;
+const int RBIN_INT = 2;
+const int RBIN_DOUBLE = 3;
+const int RBIN_STRING = 4;
+
+const char* rbin_magic = "ADMB2RB1";
+const string rbin_na_string("\0NA", 3);     // stands for NA in string arrays
+
+struct rbin_entry {
+    int parent;
+    int kind;
+    int type;
+    int nrow;
+    int ncol;
+    unsigned long long data;
+    unsigned long long names1;
+    unsigned long long names2;
+    string name;
+    int nchild;                             // children so far (not written to file)
+};
 
-int level;                                  // Current nesting level for object names
-bool OKflag = true;                         // error flag
-string mflag;                               // is open object a matrix or data frame
-string vecflag;                             // is open vector a list or simple vector
-vector<bool> ObjDoneFlag;                   // flag to track object completion
-vector<string> prevObj;                     // ( names of previous object, used in keeping
+//=====================================================================================
+// RWriter
+//
+// One R output file and all of the state needed to write it: the output stream, the
+// nesting stack of open lists, object-completion flags, pending row/column names and
+// the error log.  Earlier versions kept all of this in globals, so only one file
+// could be written per process.  Each RWriter is independent, so several models or
+// replicates can write their own files at the same time, e.g. one writer per thread.
+//
+// The member functions are the ADMB2R routines documented below.  The free functions
+// of the same names (open_r_file, wrt_r_matrix, ...) are thin wrappers that write
+// through default_rwriter, so existing code such as make-Rfile_asap3.cxx is unchanged.
+//
+// ARGUMENTS (constructor)
+//     logname - (optional) file that receives the error log; default "admb2r.log"
+//=====================================================================================
+class RWriter {
+public:
+    RWriter(const char* logname = "admb2r.log");
+
+    void open_r_file(const char* fname, int numdigits = -1);
+    void open_r_file(const char* fname, int numdigits, double ismissing,
+                     int format = ADMB2R_TEXT);
+    void close_r_file();
+    void wrt_r_comment(const char* text);
+
+    void open_r_matrix(const char* name);
+    void close_r_matrix();
+    void wrt_r_matrix(const dvar_matrix& xx, int rowoption = 0, int coloption = 0,
+                      bool isna = false, imatrix& na_matrix = dum_matrix);
+    void wrt_r_matrix(const dmatrix& xx, int rowoption = 0, int coloption = 0,
+                      bool isna = false, imatrix& na_matrix = dum_matrix);
+    void wrt_r_matrix(const imatrix& xx, int rowoption = 0, int coloption = 0,
+                      bool isna = false, imatrix& na_matrix = dum_matrix);
+    void wrt_r_namevector(const int& start, const int& stop, int inc = 1);
+    void wrt_r_namevector(const ivector& rowvec, int start = 0, int stop = 0);
+
+    void open_r_list(const char* name);
+    void close_r_list();
+    void open_r_info_list(const char* name, bool writestamp = true);
+    void close_r_info_list();
+    void open_r_vector(const char* name);
+    void close_r_vector();
+    void wrt_r_item(const char* name, const char* value);
+    void wrt_r_item(const char* name, bool value);
+    void wrt_r_item(int name, bool value);
+    void wrt_r_item(const char* name, int value);
+    void wrt_r_item(int name, int value);
+    void wrt_r_item(const char* name, double value);
+    void wrt_r_item(int name, double value);
+    void wrt_r_item(const char* name, dvariable value);
+    void wrt_r_item(int name, dvariable value);
+    void wrt_r_item(const char* name);
+    void wrt_r_item(int name);
+
+    void open_r_df(const char* name, int start = -1, int stop = -1, int writerow = 0);
+    void close_r_df();
+    void wrt_r_df_col(const char* name, const dvector& xx, int shift = -999999,
+                      bool isna = false, bool* na_vector = NULL);
+    void wrt_r_df_col(const char* name, const ivector& xx, int shift = -999999,
+                      bool isna = false, bool* na_vector = NULL);
+    void wrt_r_df_col(const char* name, const dvar_vector& xx, int shift = -999999,
+                      bool isna = false, bool* na_vector = NULL);
+    void wrt_r_df_col(const char* name, const int& start, const int& stop, int inc = 1,
+                      bool isna = false, bool* na_vector = NULL);
+
+    void open_r_complete_vector(const char* name);
+    void close_r_complete_vector();
+    void wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+    void wrt_r_complete_vector(const char* name, const dvector& xvec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+    void wrt_r_complete_vector(const char* name, const ivector& xvec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+    void wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
+                               const ivector& namevec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+    void wrt_r_complete_vector(const char* name, const dvector& xvec,
+                               const ivector& namevec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+    void wrt_r_complete_vector(const char* name, const ivector& xvec,
+                               const ivector& namevec,
+                               bool isna = false, ivector& na_vector = dum_vector);
+
+private:
+    RWriter(const RWriter&);                // not copyable: owns an open file
+    RWriter& operator=(const RWriter&);
+
+    // text output
+    bool test_missing(double num);
+    bool test_missing_value(double num);
+    bool test_missing_value(int num);
+    bool test_missing_value(const prevariable& num);
+    void write_errmsg();
+    void print_wrap(string s, const char* a = "");
+    void do_open_r_file(const char* fname, int numdigits, int format);
+    int reg_Rnames(const char* name, string description);
+    void add_colname(const char* name);
+    void add_rowname(const char* name);
+    template <class T> string check_rownames(T start, T stop, T inc);
+    template <class T> void do_wrt_r_matrix(const T& xx, imatrix& na_matrix);
+    template <class T> void do_wrt_r_namevector(const T& rowvec, int start, int stop);
+    template <class T> void do_wrt_r_numvector(const T& start, const T& stop, T inc);
+    template <class T> void do_df_col_wrt_vec(const char* name, const T& xx, int shift,
+                                              bool* na_vector = NULL);
+    template <class T> void do_df_col_wrt_num(const char* name, const T& start,
+                                              const T& stop, T inc,
+                                              bool* na_vector = NULL);
+    template <class T> void do_wrt_r_complete_vector(const T& xvec, int name_flag,
+                                                     const ivector& name_vector,
+                                                     ivector& na_vector);
+
+    // binary output
+    void rbin_error(const string& msg);
+    unsigned long long rbin_align();
+    void rbin_put(int x);
+    void rbin_put(unsigned int x);
+    void rbin_put(unsigned long long x);
+    void rbin_put(double x);
+    void rbin_put(const string& s);
+    unsigned long long rbin_put_names(const vector<string>& names);
+    void rbin_cell(int x, bool isna);
+    void rbin_cell(double x, bool isna);
+    void rbin_cell(const prevariable& x, bool isna);
+    int rbin_add(const string& name, int kind, int parent);
+    int rbin_reg(const char* name, int kind);
+    bool rbin_check_open(int kind, const char* caller);
+    void rbin_open_file(const char* fname);
+    void rbin_close_file();
+    void rbin_open_list(const char* name);
+    void rbin_close_list(const char* caller);
+    void rbin_item(const string& name, int type, double num, const string& str);
+    void rbin_item(const string& name, const char* value);
+    void rbin_item(const string& name, bool value);
+    void rbin_item(const string& name, int value);
+    void rbin_item(const string& name, double value);
+    void rbin_item(const string& name, const prevariable& x);
+    void rbin_item(const string& name);
+    void rbin_open_vector(const char* name);
+    void rbin_close_vector();
+    template <class T> void rbin_wrt_matrix(const T& xx, imatrix& na_matrix);
+    void rbin_close_matrix();
+    void rbin_namevector(const vector<string>& names);
+    void rbin_open_df(const char* name, int start, int stop, int writerow);
+    void rbin_close_df();
+    template <class T> void rbin_df_col_vec(const char* name, const T& xx, int shift,
+                                            bool* na_vector);
+    void rbin_df_col_num(const char* name, int start, int stop, int inc, bool* na_vector);
+    template <class T> void rbin_complete_vector(const T& xvec, int name_flag,
+                                                 const ivector& name_vector,
+                                                 ivector& na_vector);
+
+    // ** File I/O Variables
+
+    string outfile;                         // output file name
+    rdat_buffer rfile;                      // buffered output for the R file
+    string logfile;                         // file for error messages
+    string err_msg;                         // error message
+
+    // ** General Housekeeping Variables
+
+    int level;                              // Current nesting level for object names
+    bool OKflag;                            // error flag
+    string mflag;                           // is open object a matrix or data frame
+    string vecflag;                         // is open vector a list or simple vector
+    vector<bool> ObjDoneFlag;               // flag to track object completion
+    vector<string> prevObj;                 // ( names of previous object, used in keeping
                                             // ( track of whether the object is complete
 
-// ** Data Writing Variables
-
-double missing = -99999.;                   // No data/missing data indicator
-double epsilon = 1e-6;                      // A small number
-bool writeNA = false;                       // Flag to turn on/off writing NA for missing data
-bool naflag = false;                        // Flag to signal use of NA matrix or vector
-imatrix dum_matrix;                         // Dummy variable in use of NA matrix
-ivector dum_vector;                         // Dummy variable in use of NA vector
-int dim1 = -1;                              // matrix dimensions or data frame min/max
-int dim2 = -1;                              // matrix dimensions or data frame min/max
-int digits = -1;                            // ( Digits of data precision; -1 will write data
+    // ** Data Writing Variables
+
+    double missing;                         // No data/missing data indicator
+    double epsilon;                         // A small number
+    bool writeNA;                           // Flag to turn on/off writing NA for missing data
+    bool naflag;                            // Flag to signal use of NA matrix or vector
+    int dim1;                               // matrix dimensions or data frame min/max
+    int dim2;                               // matrix dimensions or data frame min/max
+    int digits;                             // ( Digits of data precision; -1 will write data
                                             // ( as it appears in ADMB; 0 writes integers
 
-// ** R Names Variables
+    // ** R Names Variables
+
+    vector<string> Rnames;                  // vector of names to write when closing the R object
+    string colnames;                        // list of names to be used for R columns
+    string rownames;                        // list of names to be used for R rows
+    int rowflag;                            // Flag to write matrix or data frame row names
+    int colflag;                            // Flag to write matrix or data frame column names
+
+    // ** Binary Backend Variables
+
+    bool rbinary;                           // open file uses the binary backend
+    vector<rbin_entry> rbin_dir;            // directory, written at close_r_file
+    vector<int> rbin_parent;                // open lists; back() is the current parent
+    int rbin_cur;                           // open matrix, data frame or vector
+    vector<string> rbin_rnames;             // row names (or names) for rbin_cur
+    vector<string> rbin_cnames;             // column names for rbin_cur
+    vector<int> rbin_itypes;                // ( items of an open_r_vector object,
+    vector<double> rbin_inum;               // ( kept until close_r_vector decides the
+    vector<string> rbin_istr;               // ( common type
+};
 
-vector<string> Rnames;                      // vector of names to write when closing the R object
-string colnames;                            // list of names to be used for R columns
-string rownames;                            // list of names to be used for R rows
-int rowflag = 0;                            // Flag to write matrix or data frame row names
-int colflag = 0;                            // Flag to write matrix or data frame column names
-const char* quote = "\"";                   // Double-quote character (")
-const char* cquote = ",\"";                 // comma plus double quote (,")
+//=====================================================================================
+// RWriter constructor
+//
+// Sets the defaults that were previously the initial values of the globals.
+//=====================================================================================
+RWriter::RWriter(const char* logname)
+    : logfile(logname), err_msg("ADMB2R error messages:  "), level(0), OKflag(true),
+      missing(-99999.), epsilon(1e-6), writeNA(false), naflag(false), dim1(-1), dim2(-1),
+      digits(-1), rowflag(0), colflag(0), rbinary(false), rbin_cur(-1) {
+} // end RWriter
 
 //=====================================================================================
 // convert
@@ -161,10 +536,30 @@ out_type convert(const in_value & t) {
 //
 //=====================================================================================
 
-bool test_missing(double num) {
+bool RWriter::test_missing(double num) {
     return (fabs(num - missing) < epsilon);
 }
 
+//=====================================================================================
+// test_missing_value
+//
+// Missing-value test for data being written.  Earlier versions tested
+// convert<double>(x), i.e. x rounded through a default (6 significant digit) stream;
+// that rounding is kept so the same values become NA.  It moves a value by at most
+// 5e-6 of itself, so values further than that from the missing value are rejected
+// without the stringstream round trip.
+//=====================================================================================
+bool RWriter::test_missing_value(double num) {
+    if ( fabs(num - missing) > 1e-5 * fabs(num) + epsilon ) return false;
+    return test_missing(convert<double>(num));
+}
+bool RWriter::test_missing_value(int num) {
+    return test_missing(num);
+}
+bool RWriter::test_missing_value(const prevariable& num) {
+    return test_missing_value(value(num));
+}
+
 //=====================================================================================
 // write_errmsg
 //
@@ -172,12 +567,13 @@ bool test_missing(double num) {
 //
 // No arguments.
 //=====================================================================================
-void write_errmsg() {
+void RWriter::write_errmsg() {
     // write error message to screen and file
     if ( err_msg != "ADMB2R error messages:  " ) {
-        cout << "**** ADMB2R Error: Please check file admb2r.log for error messages." << endl;
+        cout << "**** ADMB2R Error: Please check file " << logfile
+             << " for error messages." << endl;
     }
-    errfile.open ("admb2r.log");
+    ofstream errfile(logfile.c_str());
     errfile << err_msg << endl;
     errfile.close();
 } // end write_errmsg
@@ -193,34 +589,32 @@ void write_errmsg() {
 //     a - (optional) any text to append to the string before writing a new line, for
 //         example, any closing punctuation
 //=====================================================================================
-void print_wrap(string s, string a = "") {
-string::size_type pos = s.find_first_of(",");
+void RWriter::print_wrap(string s, const char* a) {
+string::size_type pos = s.find(',');
 string::size_type istart = 0;
-string  temp;
 int counter = 0;
 
 // first, append any additional text (such as closing punctuation)
-s = s + a;
+s += a;
 
 if (pos < s.length() ) { // check to see if there are some comma-delimited tokens
     while (pos != string::npos) {
         counter = counter + 1;
 		if (counter == 25 ) {                            // when the 25th token is
-	        temp = s.substr(istart, pos - istart + 1);   // found, extract the substring
-		    rfile << temp << endl;                       // and print
+		    rfile.write(s.data() + istart, pos - istart + 1);  // found, print it
+		    rfile << endl;
 		    istart = pos + 1;
 		    counter = 0;
 	    }
-        pos = s.find_first_of(",", pos + 1); // find the next comma delimeter
+        pos = s.find(',', pos + 1); // find the next comma delimeter
     }
 
     // print the last batch of token, if there are any
     if (istart < s.length() ) {
-        temp = s.substr(istart, s.length() - istart);
 		// only print if there are more than spaces
-		pos = temp.find_first_not_of(" ");
-		if (pos < s.length()) {
-            rfile << temp << endl;
+		if (s.find_first_not_of(' ', istart) != string::npos) {
+            rfile.write(s.data() + istart, s.length() - istart);
+            rfile << endl;
 		}
     }
 } else {
@@ -229,6 +623,567 @@ if (pos < s.length() ) { // check to see if there are some comma-delimited token
 	}
 } // end print_wrap
 
+//=====================================================================================
+// BINARY BACKEND routines.  The file layout is described ahead of the RWriter class.
+//=====================================================================================
+
+//=====================================================================================
+// rbin_error
+//
+// Record an error for the binary backend and close the file.
+//=====================================================================================
+void RWriter::rbin_error(const string& msg) {
+    if ( rfile.is_open() ) rfile.close();
+    err_msg = err_msg + "\n**** ADMB2R Error: " + msg;
+    OKflag = false;
+    write_errmsg();
+} // end rbin_error
+
+//=====================================================================================
+// Low-level writers: align to 8 bytes, single values, strings and name arrays.
+//=====================================================================================
+unsigned long long RWriter::rbin_align() {
+    static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    rfile.write(zeros, (8 - rfile.pos() % 8) % 8);
+    return rfile.pos();
+}
+void RWriter::rbin_put(int x) {
+    rfile.write((const char*) &x, 4);
+}
+void RWriter::rbin_put(unsigned int x) {
+    rfile.write((const char*) &x, 4);
+}
+void RWriter::rbin_put(unsigned long long x) {
+    rfile.write((const char*) &x, 8);
+}
+void RWriter::rbin_put(double x) {
+    rfile.write((const char*) &x, 8);
+}
+void RWriter::rbin_put(const string& s) {
+    if ( s == rbin_na_string ) {
+        rbin_put(0xFFFFFFFFu);
+        return;
+    }
+    rbin_put((unsigned int) s.size());
+    rfile.write(s.data(), s.size());
+}
+double rbin_na_real() {                     // R's NA_real_: a NaN with payload 1954
+    unsigned long long bits = 0x7FF00000000007A2ULL;
+    double x;
+    memcpy(&x, &bits, 8);
+    return x;
+}
+// write a names array; an empty list of names is R's NULL (offset 0)
+unsigned long long RWriter::rbin_put_names(const vector<string>& names) {
+    if ( names.empty() ) return 0;
+    unsigned long long offset = rbin_align();
+    rbin_put((unsigned int) names.size());
+    for ( size_t k = 0; k < names.size(); k++ ) rbin_put(names[k]);
+    return offset;
+}
+string rbin_name(int n) {
+    char tmp[12];
+    return string(tmp, rdat_buffer::format_int(tmp, n));
+}
+
+//=====================================================================================
+// rbin_type, rbin_cell
+//
+// Storage type and writer for one datum of each ADMB element type.  A datum is NA
+// when it is flagged in an NA matrix/vector, or matches the missing value.
+//=====================================================================================
+int rbin_type(int) { return RBIN_INT; }
+int rbin_type(double) { return RBIN_DOUBLE; }
+int rbin_type(const prevariable&) { return RBIN_DOUBLE; }
+
+void RWriter::rbin_cell(int x, bool isna) {
+    if ( isna || ( writeNA && test_missing_value(x) ) ) rbin_put(INT_MIN);
+    else rbin_put(x);
+}
+void RWriter::rbin_cell(double x, bool isna) {
+    if ( isna || ( writeNA && test_missing_value(x) ) ) rbin_put(rbin_na_real());
+    else rbin_put(x);
+}
+void RWriter::rbin_cell(const prevariable& x, bool isna) {
+    rbin_cell(value(x), isna);
+}
+
+//=====================================================================================
+// rbin_add, rbin_reg
+//
+// Append a directory record under the current parent.  rbin_reg is the binary
+// counterpart of reg_Rnames: it also checks that the previous object is complete.
+// Both return the record number, or -1 after an error.
+//=====================================================================================
+int RWriter::rbin_add(const string& name, int kind, int parent) {
+    rbin_entry e;
+    e.parent = parent;
+    e.kind = kind;
+    e.type = RBIN_NONE;
+    e.nrow = 0;
+    e.ncol = 1;
+    e.data = 0;
+    e.names1 = 0;
+    e.names2 = 0;
+    e.name = name;
+    e.nchild = 0;
+    if ( parent >= 0 ) rbin_dir[parent].nchild++;
+    rbin_dir.push_back(e);
+    return int(rbin_dir.size()) - 1;
+}
+int RWriter::rbin_reg(const char* name, int kind) {
+    if ( OKflag == false ) return -1;
+    if ( rbin_cur >= 0 ) {
+        rbin_error(rbin_dir[rbin_cur].name + " is still open");
+        return -1;
+    }
+    return rbin_add(name, kind, rbin_parent.back());
+}
+
+// check that the open object is of the expected kind before writing to it
+bool RWriter::rbin_check_open(int kind, const char* caller) {
+    if ( OKflag == false ) return false;
+    if ( rbin_cur < 0 || rbin_dir[rbin_cur].kind != kind ) {
+        rbin_error(string("Invalid use of ") + caller);
+        return false;
+    }
+    return true;
+}
+
+//=====================================================================================
+// rbin_open_file, rbin_close_file
+//=====================================================================================
+void RWriter::rbin_open_file(const char* fname) {
+    int one = 1;
+    if ( *(char*) &one != 1 ) {
+        rbin_error("Binary output requires a little-endian machine");
+        return;
+    }
+    rbin_dir.clear();
+    rbin_parent.clear();
+    rbin_parent.push_back(-1);
+    rbin_cur = -1;
+    rbin_rnames.clear();
+    rbin_cnames.clear();
+
+    rfile.open(fname, true);
+    if ( ! rfile.is_open() ) {
+        rbin_error(string("Unable to open ") + fname);
+        return;
+    }
+    rfile.write(rbin_magic, 8);
+} // end rbin_open_file
+
+void RWriter::rbin_close_file() {
+    if ( OKflag == false ) {
+        write_errmsg();
+        if ( rfile.is_open() ) rfile.close();
+        return;
+    }
+    if ( rbin_dir.empty() ) {
+        rbin_error("No data written to " + outfile);
+        return;
+    }
+    if ( rbin_parent.size() != 1 ) {
+        rbin_error("Close list object with close_r_list().");
+        return;
+    }
+    if ( rbin_cur >= 0 ) {
+        rbin_error(rbin_dir[rbin_cur].name + " is not complete!");
+        return;
+    }
+
+    // directory and trailer
+    unsigned long long dir_offset = rbin_align();
+    for ( size_t k = 0; k < rbin_dir.size(); k++ ) {
+        const rbin_entry& e = rbin_dir[k];
+        rbin_put(e.parent);
+        rbin_put(e.kind);
+        rbin_put(e.type);
+        rbin_put(e.nrow);
+        rbin_put(e.ncol);
+        rbin_put(e.data);
+        rbin_put(e.names1);
+        rbin_put(e.names2);
+        rbin_put(e.name);
+    }
+    rbin_put(dir_offset);
+    rbin_put((unsigned int) rbin_dir.size());
+    rbin_put(0u);
+    rfile.write(rbin_magic, 8);
+
+    bool failed = rfile.bad();
+    rfile.close();
+    if ( failed || rfile.bad() ) {
+        rbin_error("Unable to write to " + outfile);
+        return;
+    }
+    rbin_dir.clear();
+    rbin_parent.clear();
+    write_errmsg();
+} // end rbin_close_file
+
+//=====================================================================================
+// Lists and info lists.  An info list is a list whose items are length-one vectors.
+//=====================================================================================
+void RWriter::rbin_open_list(const char* name) {
+    int k = rbin_reg(name, RBIN_LIST);
+    if ( k < 0 ) return;
+    rbin_parent.push_back(k);
+} // end rbin_open_list
+
+void RWriter::rbin_close_list(const char* caller) {
+    if ( OKflag == false ) return;
+    if ( rbin_cur >= 0 ) {
+        rbin_error(rbin_dir[rbin_cur].name + " is still open");
+        return;
+    }
+    if ( rbin_parent.size() < 2 ) {
+        rbin_error(string("Invalid use of ") + caller);
+        return;
+    }
+    if ( rbin_dir[rbin_parent.back()].nchild == 0 ) {
+        rbin_error("No data written to " + rbin_dir[rbin_parent.back()].name);
+        return;
+    }
+    rbin_parent.pop_back();
+} // end rbin_close_list
+
+//=====================================================================================
+// rbin_item
+//
+// One name - value pair.  In an info list it becomes a length-one vector; in a
+// simple vector (open_r_vector) it is held until close_r_vector, which stores all
+// items with the most general type among them, as R's c() would.
+//=====================================================================================
+void RWriter::rbin_item(const string& name, int type, double num, const string& str) {
+    if ( OKflag == false ) return;
+    if ( vecflag == "vector" ) {
+        rbin_rnames.push_back(name);
+        rbin_itypes.push_back(type);
+        rbin_inum.push_back(num);
+        rbin_istr.push_back(str);
+        return;
+    }
+    if ( vecflag != "info" ) {
+        rbin_error("Invalid use of wrt_r_item for " + name);
+        return;
+    }
+    int k = rbin_add(name, RBIN_VECTOR, rbin_parent.back());
+    rbin_dir[k].type = type;
+    rbin_dir[k].nrow = 1;
+    if ( type == RBIN_STRING ) {
+        vector<string> one(1, str);
+        rbin_dir[k].data = rbin_put_names(one);
+    } else if ( type == RBIN_DOUBLE ) {
+        rbin_dir[k].data = rbin_align();
+        rbin_put(num);
+    } else if ( type == RBIN_NONE ) {      // NA is a logical NA, as in R
+        rbin_dir[k].type = RBIN_LOGICAL;
+        rbin_dir[k].data = rbin_align();
+        rbin_put(INT_MIN);
+    } else {
+        rbin_dir[k].data = rbin_align();
+        rbin_put(int(num));
+    }
+} // end rbin_item
+void RWriter::rbin_item(const string& name, const char* value) {
+    rbin_item(name, RBIN_STRING, 0., value);
+}
+void RWriter::rbin_item(const string& name, bool value) {
+    rbin_item(name, RBIN_LOGICAL, value ? 1. : 0., "");
+}
+void RWriter::rbin_item(const string& name, int value) {
+    rbin_item(name, RBIN_INT, value, "");
+}
+void RWriter::rbin_item(const string& name, double value) {
+    rbin_item(name, RBIN_DOUBLE, value, "");
+}
+void RWriter::rbin_item(const string& name, const prevariable& x) {
+    rbin_item(name, RBIN_DOUBLE, value(x), "");
+}
+void RWriter::rbin_item(const string& name) {        // NA
+    rbin_item(name, RBIN_NONE, 0., "");
+}
+
+//=====================================================================================
+// rbin_open_vector, rbin_close_vector
+//=====================================================================================
+void RWriter::rbin_open_vector(const char* name) {
+    rbin_cur = rbin_reg(name, RBIN_VECTOR);
+    rbin_rnames.clear();
+    rbin_itypes.clear();
+    rbin_inum.clear();
+    rbin_istr.clear();
+} // end rbin_open_vector
+
+void RWriter::rbin_close_vector() {
+    if ( ! rbin_check_open(RBIN_VECTOR, "close_r_vector") ) return;
+    rbin_entry& e = rbin_dir[rbin_cur];
+    if ( rbin_itypes.empty() ) {
+        rbin_error("No items written to " + e.name + " using wrt_r_item.");
+        return;
+    }
+
+    int type = RBIN_LOGICAL;
+    size_t k;
+    for ( k = 0; k < rbin_itypes.size(); k++ ) {
+        if ( rbin_itypes[k] > type ) type = rbin_itypes[k];
+    }
+    e.type = type;
+    e.nrow = int(rbin_itypes.size());
+    if ( type == RBIN_STRING ) {            // numbers become text, as in c("a", 1)
+        vector<string> s(rbin_istr);
+        char tmp[32];
+        for ( k = 0; k < s.size(); k++ ) {
+            if ( rbin_itypes[k] == RBIN_STRING ) continue;
+            if ( rbin_itypes[k] == RBIN_NONE ) s[k] = rbin_na_string;
+            else if ( rbin_itypes[k] == RBIN_LOGICAL ) s[k] = rbin_inum[k] ? "TRUE" : "FALSE";
+            else {
+                snprintf(tmp, sizeof(tmp), "%.15g", rbin_inum[k]);
+                s[k] = tmp;
+            }
+        }
+        e.data = rbin_put_names(s);
+    } else {
+        e.data = rbin_align();
+        for ( k = 0; k < rbin_inum.size(); k++ ) {
+            bool isna = ( rbin_itypes[k] == RBIN_NONE );
+            if ( type == RBIN_DOUBLE ) rbin_put(isna ? rbin_na_real() : rbin_inum[k]);
+            else rbin_put(isna ? INT_MIN : int(rbin_inum[k]));
+        }
+    }
+    e.names1 = rbin_put_names(rbin_rnames);
+    rbin_rnames.clear();
+    rbin_cur = -1;
+} // end rbin_close_vector
+
+//=====================================================================================
+// rbin_wrt_matrix, rbin_close_matrix
+//=====================================================================================
+template <class T>
+void RWriter::rbin_wrt_matrix(const T& xx, imatrix& na_matrix) {
+    if ( ! rbin_check_open(RBIN_MATRIX, "wrt_r_matrix") ) return;
+
+    int ir, ic;
+    int ra = xx.rowmin();
+    int rz = xx.rowmax();
+    int ca = xx.colmin();
+    int cz = xx.colmax();
+
+    rbin_entry& e = rbin_dir[rbin_cur];
+    e.type = rbin_type(xx(ra,ca));
+    e.nrow = rz - ra + 1;
+    e.ncol = cz - ca + 1;
+    e.data = rbin_align();
+    for ( ic=ca; ic<=cz; ic++ ) {
+        for ( ir=ra; ir<=rz; ir++ ) {
+            rbin_cell(xx(ir,ic), naflag && na_matrix[ir][ic]);
+        }
+    }
+
+    // names from the matrix indices; option 2 waits for wrt_r_namevector
+    rbin_rnames.clear();
+    rbin_cnames.clear();
+    if ( rowflag == 1 ) {
+        for ( ir=ra; ir<=rz; ir++ ) rbin_rnames.push_back(rbin_name(ir));
+    }
+    if ( colflag == 1 ) {
+        for ( ic=ca; ic<=cz; ic++ ) rbin_cnames.push_back(rbin_name(ic));
+    }
+} // end rbin_wrt_matrix
+
+void RWriter::rbin_close_matrix() {
+    if ( ! rbin_check_open(RBIN_MATRIX, "close_r_matrix") ) return;
+    rbin_entry& e = rbin_dir[rbin_cur];
+    if ( rowflag == 2 && rbin_rnames.empty() ) {
+        rbin_error("Please add row names to " + e.name + " using wrt_r_namevector");
+        return;
+    }
+    if ( colflag == 2 && rbin_cnames.empty() ) {
+        rbin_error("Please add column names to " + e.name + " using wrt_r_namevector");
+        return;
+    }
+    e.names1 = rbin_put_names(rbin_rnames);
+    e.names2 = rbin_put_names(rbin_cnames);
+    rbin_rnames.clear();
+    rbin_cnames.clear();
+    rowflag = 0;
+    colflag = 0;
+    rbin_cur = -1;
+} // end rbin_close_matrix
+
+//=====================================================================================
+// rbin_namevector
+//
+// Row or column names from wrt_r_namevector: the matrix rows, then its columns, or
+// the data frame row.names, with the same count checks as check_rownames.
+//=====================================================================================
+void RWriter::rbin_namevector(const vector<string>& names) {
+    if ( OKflag == false ) return;
+    if ( rbin_cur < 0 || rbin_dir[rbin_cur].kind == RBIN_VECTOR ) {
+        rbin_error("Invalid use of wrt_r_namevector");
+        return;
+    }
+    rbin_entry& e = rbin_dir[rbin_cur];
+    int nitems = int(names.size());
+    if ( e.kind == RBIN_MATRIX ) {
+        if ( rowflag == 2 && rbin_rnames.empty() ) {
+            if ( nitems != e.nrow ) {
+                rbin_error("Number of matrix indices in wrt_r_namevector for " + e.name +
+                           " shoud be " + rbin_name(e.nrow));
+                return;
+            }
+            rbin_rnames = names;
+        } else if ( colflag == 2 && rbin_cnames.empty() ) {
+            if ( nitems != e.ncol ) {
+                rbin_error("Number of matrix indices in wrt_r_namevector for " + e.name +
+                           " shoud be " + rbin_name(e.ncol));
+                return;
+            }
+            rbin_cnames = names;
+        } else {
+            rbin_error("Invalid use of wrt_r_namevector for " + e.name);
+        }
+    } else {                                // data frame row.names
+        if ( nitems != dim2 - dim1 + 1 ) {
+            rbin_error("Number of items to write in wrt_r_namevector for " + e.name +
+                       " shoud be " + rbin_name(dim2 - dim1 + 1));
+            return;
+        }
+        rbin_rnames = names;
+    }
+} // end rbin_namevector
+
+//=====================================================================================
+// Data frames.  Columns are vector records whose parent is the data frame.
+//=====================================================================================
+void RWriter::rbin_open_df(const char* name, int start, int stop, int writerow) {
+    rbin_cur = rbin_reg(name, RBIN_DF);
+    if ( rbin_cur < 0 ) return;
+    if ( start == stop && start != -1 ) {
+        rbin_error(string("Invalid index min and max values in open_r_df for the data frame ")
+                   + name);
+        return;
+    }
+    dim1 = start;
+    dim2 = stop;
+    rowflag = writerow;
+    rbin_rnames.clear();
+    if ( rowflag == 1 && dim1 != -1 ) {
+        for ( int y=dim1; y<=dim2; y++ ) rbin_rnames.push_back(rbin_name(y));
+    }
+} // end rbin_open_df
+
+void RWriter::rbin_close_df() {
+    if ( ! rbin_check_open(RBIN_DF, "close_r_df") ) return;
+    rbin_entry& e = rbin_dir[rbin_cur];
+    if ( e.nchild == 0 ) {
+        rbin_error("No column names supplied for " + e.name);
+        return;
+    }
+    if ( rowflag == 2 && rbin_rnames.empty() ) {
+        rbin_error("No row names supplied for " + e.name);
+        return;
+    }
+    e.nrow = dim2 - dim1 + 1;
+    e.ncol = e.nchild;
+    e.names1 = rbin_put_names(rbin_rnames);
+    rbin_rnames.clear();
+    rowflag = 0;
+    dim1 = -1;
+    dim2 = -1;
+    rbin_cur = -1;
+} // end rbin_close_df
+
+template <class T>
+void RWriter::rbin_df_col_vec(const char* name, const T& xx, int shift, bool* na_vector) {
+    if ( ! rbin_check_open(RBIN_DF, "wrt_r_df_col") ) return;
+
+    int ja = (xx).indexmin();
+    int jz = (xx).indexmax();
+    int yshift = 0;
+    if ( dim1 == -1 && dim2 == -1 ) {
+        dim1 = ja;
+        dim2 = jz;
+    }
+    if ( shift != -999999 ) {
+        yshift = ja - shift;
+        jz = jz - ja + shift;
+        ja = shift;
+    }
+
+    int k = rbin_add(name, RBIN_VECTOR, rbin_cur);
+    rbin_dir[k].type = rbin_type(xx[xx.indexmin()]);
+    rbin_dir[k].nrow = dim2 - dim1 + 1;
+    rbin_dir[k].data = rbin_align();
+    for ( int y=dim1; y<=dim2; y++ ) {
+        if ( y<ja || y>jz ) {               // out of range: NA of the column's type
+            rbin_cell(xx[xx.indexmin()], true);
+        } else {
+            rbin_cell(xx[y + yshift], naflag && na_vector[y]);
+        }
+    }
+} // end rbin_df_col_vec
+
+void RWriter::rbin_df_col_num(const char* name, int start, int stop, int inc, bool* na_vector) {
+    if ( ! rbin_check_open(RBIN_DF, "wrt_r_df_col") ) return;
+    if ( dim1 == -1 && dim2 == -1 ) {
+        rbin_error("Index min and max values unspecified in open_r_df for " +
+                   rbin_dir[rbin_cur].name);
+        return;
+    }
+    int k = rbin_add(name, RBIN_VECTOR, rbin_cur);
+    rbin_dir[k].type = RBIN_INT;
+    rbin_dir[k].nrow = dim2 - dim1 + 1;
+    rbin_dir[k].data = rbin_align();
+    int iter = start;
+    for ( int y=dim1; y<=dim2; y++ ) {
+        rbin_cell(iter, iter > stop || ( naflag && na_vector[y] ));
+        iter = iter + inc;
+    }
+} // end rbin_df_col_num
+
+//=====================================================================================
+// rbin_complete_vector
+//=====================================================================================
+template <class T>
+void RWriter::rbin_complete_vector(const T& xvec, int name_flag, const ivector& name_vector,
+                                    ivector& na_vector) {
+    if ( ! rbin_check_open(RBIN_VECTOR, "wrt_r_complete_vector") ) return;
+
+    int ra = (xvec).indexmin();
+    int rz = (xvec).indexmax();
+    int na = (na_vector).indexmin();
+    rbin_entry& e = rbin_dir[rbin_cur];
+
+    if ( naflag && (na_vector).indexmax() - na != rz - ra ) {
+        rbin_error("Number of vector elements in " + e.name +
+                   " is different than the NA vector used.");
+        return;
+    }
+    if ( name_flag && (name_vector).indexmax() - (name_vector).indexmin() != rz - ra ) {
+        rbin_error("Number of vector elements in " + e.name +
+                   " is different than the names vector used.");
+        return;
+    }
+
+    e.type = rbin_type(xvec(ra));
+    e.nrow = rz - ra + 1;
+    e.data = rbin_align();
+    for ( int ir=ra; ir<=rz; ir++ ) {
+        rbin_cell(xvec(ir), naflag && na_vector(na + ir - ra));
+    }
+    if ( name_flag ) {
+        rbin_rnames.clear();
+        for ( int ir=name_vector.indexmin(); ir<=name_vector.indexmax(); ir++ ) {
+            rbin_rnames.push_back(rbin_name(name_vector(ir)));
+        }
+        e.names1 = rbin_put_names(rbin_rnames);
+        rbin_rnames.clear();
+    }
+} // end rbin_complete_vector
+
 //=====================================================================================
 // do_open_r_file
 //
@@ -242,15 +1197,20 @@ if (pos < s.length() ) { // check to see if there are some comma-delimited token
 //          digits = -1 (default) or digits = 0 writes data out with default precision
 //          of 6; digits > 0 will write ALL data out in scientific notation with the
 //          specified number of digits after the decimal place.
+//   format - ADMB2R_TEXT for a dget text file, ADMB2R_BINARY for a binary file
 //=====================================================================================
-void do_open_r_file(const char* fname, int numdigits) {
+void RWriter::do_open_r_file(const char* fname, int numdigits, int format) {
     // initialize nesting level
     level = 0;
 
-    // initialize dummy matrix
-    dum_matrix.allocate(1,1,1,1);
-   // initialize dummy vector
-   dum_vector.allocate(1,1);
+    // the binary backend keeps its own object bookkeeping
+    rbinary = ( format == ADMB2R_BINARY );
+    if ( rbinary ) {
+        outfile = fname;
+        digits = numdigits;
+        rbin_open_file(fname);
+        return;
+    }
 
     // intialize object completion tracking variables
     ObjDoneFlag.clear();
@@ -291,10 +1251,7 @@ void do_open_r_file(const char* fname, int numdigits) {
 
     // set precision based on the digits value specified.
     digits = numdigits;
-    if ( digits > 0 ) {
-        rfile << setiosflags (ios::scientific);
-        rfile.precision(digits);
-    }
+    rfile.set_digits(digits);
 
 } // End do_open_r_file
 
@@ -308,6 +1265,7 @@ void do_open_r_file(const char* fname, int numdigits) {
 // open_r_file(fname)
 // open_r_file(fname, numdigits)
 // open_r_file(fname, numdigits, ismissing)
+// open_r_file(fname, numdigits, ismissing, format)
 //
 // ARGUMENTS:
 //   fname - name of output file.
@@ -320,19 +1278,22 @@ void do_open_r_file(const char* fname, int numdigits) {
 //   ismissing - (optional) indicates the value that is used to represent a missing datum.
 //          If ismissing is specified, data matching this value will be replaced by NA in
 //          the R file.
+//   format - (optional) ADMB2R_TEXT (default) writes a text file read by R with dget;
+//          ADMB2R_BINARY writes the binary file described under BINARY BACKEND.
 //======================================================================================
-void open_r_file(const char* fname, int numdigits = -1) {
+void RWriter::open_r_file(const char* fname, int numdigits) {
 
    // no missing value supplied, so turn off flag to write NAs to file
    writeNA = false;
 
    // pass info to do_open_r_file for processing
-   do_open_r_file(fname, numdigits);
+   do_open_r_file(fname, numdigits, ADMB2R_TEXT);
 
 } // End open_r_file (numdigits)
 
 //=====================================================================================
-void open_r_file(const char* fname, int numdigits, double ismissing) {
+void RWriter::open_r_file(const char* fname, int numdigits, double ismissing,
+                          int format) {
 
    // missing is value supplied, so turn on flag to write NAs to file
    writeNA = true;
@@ -340,9 +1301,9 @@ void open_r_file(const char* fname, int numdigits, double ismissing) {
    missing = ismissing;
 
    // pass info to do_open_r_file for processing
-   do_open_r_file(fname, numdigits);
+   do_open_r_file(fname, numdigits, format);
 
-} // End open_r_file (numdigits, ismissing)
+} // End open_r_file (numdigits, ismissing, format)
 
 
 //======================================================================================
@@ -352,7 +1313,12 @@ void open_r_file(const char* fname, int numdigits, double ismissing) {
 //
 // No arguments.
 //======================================================================================
-void close_r_file() {
+void RWriter::close_r_file() {
+
+    if ( rbinary ) {
+        rbin_close_file();
+        return;
+    }
 
     if ( OKflag == false ) {
         write_errmsg();
@@ -379,7 +1345,7 @@ void close_r_file() {
     }
 
     // check that final object is complete
-    if ( ObjDoneFlag[0] = false ) {
+    if ( ObjDoneFlag[0] == false ) {
         if ( rfile.is_open() ) rfile.close();
         err_msg = err_msg + "\n**** ADMB2R Error: " + prevObj[level] + " is not complete!";
         OKflag = false;
@@ -422,7 +1388,9 @@ void close_r_file() {
 // ARGUMENTS:
 //     text - text to write as comment
 //=====================================================================================
-void wrt_r_comment(const char* text) {
+void RWriter::wrt_r_comment(const char* text) {
+    if ( rbinary ) return;  // comments are not kept in binary files
+
     if ( ! rfile.is_open() ) { // exit if file hasn't been opened yet
         OKflag = false;
         err_msg = err_msg + "**** ADMB2R Error:  No open file\n";
@@ -455,7 +1423,7 @@ void wrt_r_comment(const char* text) {
 //    name - name of object to write
 //    description - type of R object (used in error reporting if object is incomplete).
 //======================================================================================
-int reg_Rnames(const char* name, string description) {
+int RWriter::reg_Rnames(const char* name, string description) {
 
     // check for previous object completion
     if ( OKflag == false ) return 0; // exit if there was an earlier error
@@ -496,7 +1464,7 @@ int reg_Rnames(const char* name, string description) {
 // ARGUMENTS:
 //      name - string to output.
 //======================================================================================
-void add_colname(const char* name) {
+void RWriter::add_colname(const char* name) {
     if ( colnames != "c(" ) {
         colnames = colnames + ", ";  // Object is not first item; preceed with a comma
     }
@@ -514,7 +1482,7 @@ void add_colname(const char* name) {
 // ARGUMENTS:
 //      name - string to output.
 //======================================================================================
-void add_rowname(const char* name) {
+void RWriter::add_rowname(const char* name) {
     if ( rownames != "c(" ) {
         rownames = rownames + ", ";  // Object is not first item; preceed with a comma
     }
@@ -537,7 +1505,7 @@ void add_rowname(const char* name) {
 //     inc - how much to increment the values in the series
 //======================================================================================
 template <class T>
-string check_rownames (T start, T stop, T inc) {
+string RWriter::check_rownames(T start, T stop, T inc) {
 
     string return_val = "error";            // return string indicating error, row or col
 
@@ -618,7 +1586,12 @@ string check_rownames (T start, T stop, T inc) {
 //      name - name of matrix to write to file.
 //======================================================================================
 
-void open_r_matrix (const char* name) {
+void RWriter::open_r_matrix(const char* name) {
+
+    if ( rbinary ) {
+        rbin_cur = rbin_reg(name, RBIN_MATRIX);
+        return;
+    }
 
     // add info object name to list and check for object completion
     int flag = reg_Rnames(name, "Matrix Object ");
@@ -637,9 +1610,14 @@ void open_r_matrix (const char* name) {
 //
 // No arguments.
 //======================================================================================
-void close_r_matrix() {
+void RWriter::close_r_matrix() {
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_close_matrix();
+        return;
+    }
+
     // check that row and column names are not empty
     if (rownames.empty() ) {
         if ( rfile.is_open() ) rfile.close();
@@ -712,7 +1690,12 @@ void close_r_matrix() {
 //      indicates the spot to replace with NA.
 //====================================================================================
 template <class T>
-void do_wrt_r_matrix (const T& xx, imatrix& na_matrix) {
+void RWriter::do_wrt_r_matrix(const T& xx, imatrix& na_matrix) {
+
+    if ( rbinary ) {
+        rbin_wrt_matrix(xx, na_matrix);
+        return;
+    }
 
     int ir, ic;                      // row/column iterators in for statement
     int ra, rz, ca, cz;              // for matrix bounds
@@ -731,7 +1714,7 @@ void do_wrt_r_matrix (const T& xx, imatrix& na_matrix) {
 
 			// if value is the missing value indicator, and we're
             // using a missing value "value",  write "NA" instead
-            if ( test_missing(convert<double>(xx(ir,ic))) && writeNA == true ) {
+            if ( writeNA == true && test_missing_value(xx(ir,ic)) ) {
                 rfile << "NA";
             }
             // if instead we're using a matrix of booleans to
@@ -759,25 +1742,22 @@ void do_wrt_r_matrix (const T& xx, imatrix& na_matrix) {
     }
 
     // Write dimensions of the matrix and save to dim1 and dim2
-    i = rz-ra+1;     // # of row elements
-    dim1 = i;
-    rfile << ".Dim = c(" << i;
-    i = cz-ca+1;    // # of column elements
-    dim2 = i;
-    rfile << "," << i << ")," << endl;
+    dim1 = rz-ra+1;     // # of row elements
+    rfile << ".Dim = c(" << dim1;
+    dim2 = cz-ca+1;     // # of column elements
+    rfile << "," << dim2 << ")," << endl;
 
     //set matrix row and column names
-    string temp;
     if ( rowflag == 0 ) rownames = "NULL";
     if ( rowflag == 1 ) {                   // write matrix row indices
         rownames = "c(";
+        rownames.reserve(8 * (rz - ra + 1) + 3);
         for ( ir=ra; ir<=rz; ir++ ) {
-            temp = convert <string> (ir);   //convert index (integer) to string
-            rownames = rownames + quote + temp + quote; //add index to list
+            append_quoted(rownames, ir);    //add index to list
             if ( ir==rz )
-                rownames = rownames + ")";  // add appropriate punctuation
+                rownames += ")";            // add appropriate punctuation
             else
-                rownames = rownames + ", ";
+                rownames += ", ";
         }
     }
     if ( rowflag == 2 ) rownames.erase();    // write row names with wrt_r_namevector
@@ -785,13 +1765,13 @@ void do_wrt_r_matrix (const T& xx, imatrix& na_matrix) {
     if ( colflag == 0 ) colnames = "NULL";
     if ( colflag == 1 ) {                   // write matrix col indices
         colnames = "c(";
+        colnames.reserve(8 * (cz - ca + 1) + 3);
         for ( ic=ca; ic<=cz; ic++ ) {
-            temp = convert <string> (ic);   //convert index (integer) to string
-            colnames = colnames + quote + temp + quote; //add index to list
+            append_quoted(colnames, ic);    //add index to list
             if ( ic==cz )
-                colnames = colnames + ")";  // add appropriate punctuation
+                colnames += ")";            // add appropriate punctuation
             else
-                colnames = colnames + ", ";
+                colnames += ", ";
         }
     }
     if ( colflag == 2 ) colnames.erase();    // write column names with wrt_r_namevector
@@ -818,8 +1798,8 @@ void do_wrt_r_matrix (const T& xx, imatrix& na_matrix) {
 //      indicates the spot to replace with NA. This argument is passed to do_wrt_r_matrix
 //      for further handling.
 //======================================================================================
-void wrt_r_matrix(const dvar_matrix& xx, int rowoption = 0, int coloption = 0,
-                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+void RWriter::wrt_r_matrix(const dvar_matrix& xx, int rowoption, int coloption,
+                           bool isna, imatrix& na_matrix) {
 
     // Set global flags
     rowflag = rowoption;
@@ -830,8 +1810,8 @@ void wrt_r_matrix(const dvar_matrix& xx, int rowoption = 0, int coloption = 0,
 
 } // wrt_r_matrix_wrt (dvar_matrix)
 //======================================================================================
-void wrt_r_matrix(const dmatrix& xx, int rowoption = 0, int coloption = 0,
-                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+void RWriter::wrt_r_matrix(const dmatrix& xx, int rowoption, int coloption,
+                           bool isna, imatrix& na_matrix) {
 
     // Set global flags
     rowflag = rowoption;
@@ -842,8 +1822,8 @@ void wrt_r_matrix(const dmatrix& xx, int rowoption = 0, int coloption = 0,
 
 } // wrt_r_matrix_wrt (dmatrix)
 //======================================================================================
-void wrt_r_matrix(const imatrix& xx, int rowoption = 0, int coloption = 0,
-                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+void RWriter::wrt_r_matrix(const imatrix& xx, int rowoption, int coloption,
+                           bool isna, imatrix& na_matrix) {
 
     // Set global flags
     rowflag = rowoption;
@@ -867,10 +1847,10 @@ void wrt_r_matrix(const imatrix& xx, int rowoption = 0, int coloption = 0,
 //     stop = position in vector at which to end writing
 //======================================================================================
 template <class T>
-void do_wrt_r_namevector (const T& rowvec, int start, int stop) {
+void RWriter::do_wrt_r_namevector(const T& rowvec, int start, int stop) {
 
-    string temp;
     string cr_names;                            // temp name for row or column names list
+    int i;                                      // counter in for loop
 
     // if using defaults (start=0, stop=0) then get vector bounds
     if ( start == 0 && stop == 0 ) {
@@ -880,6 +1860,13 @@ void do_wrt_r_namevector (const T& rowvec, int start, int stop) {
         stop = (rowvec).indexmax();
     }
 
+    if ( rbinary ) {
+        vector<string> names;
+        for ( i=start; i<=stop; i++ ) names.push_back(rbin_name(rowvec[i]));
+        rbin_namevector(names);
+        return;
+    }
+
     // do error checking and get which item (row or column names) to write
     string test = check_rownames<int> (start, stop, 1);
     if ( test == "error" ) return;
@@ -889,13 +1876,13 @@ void do_wrt_r_namevector (const T& rowvec, int start, int stop) {
 
     // now assign values to row or column names
     cr_names = "c(";
+    cr_names.reserve(8 * (stop - start + 1) + 3);
     for ( i=start; i<=stop; i++ ) {
-        temp = convert <string> (rowvec[i]);        //convert vector to string
-        cr_names = cr_names + quote + temp + quote; //add index to list
+        append_quoted(cr_names, rowvec[i]);         //add index to list
         if ( i==stop ) {
-            cr_names = cr_names + ")";
+            cr_names += ")";
         } else {
-            cr_names = cr_names + ", ";
+            cr_names += ", ";
         }
     }
 
@@ -915,12 +1902,18 @@ void do_wrt_r_namevector (const T& rowvec, int start, int stop) {
 //     inc = the increment between series values
 //======================================================================================
 template <class T>
-void do_wrt_r_numvector (const T& start, const T& stop, T inc) {
+void RWriter::do_wrt_r_numvector(const T& start, const T& stop, T inc) {
 
-    string temp;
     string cr_names; // temp name for row or column names list
     T iter;          // iterator
 
+    if ( rbinary ) {
+        vector<string> names;
+        for ( iter=start; iter<=stop; iter=iter+inc ) names.push_back(rbin_name(iter));
+        rbin_namevector(names);
+        return;
+    }
+
     // do error checking and get which item (row or column names) to write
     string test = check_rownames<T> (start, stop, inc);
     if ( test == "error" ) return;
@@ -930,17 +1923,16 @@ void do_wrt_r_numvector (const T& start, const T& stop, T inc) {
 
     // now assign values to row or column names
     cr_names = "c(";
-    temp = convert <string> (start);
-    cr_names = cr_names + quote + temp + quote;
+    append_quoted(cr_names, start);
     iter = start + inc;
 
     while ( iter<=stop ) {
-        temp = convert <string> (iter);
-        cr_names = cr_names + ", " + quote + temp + quote;
+        cr_names += ", ";
+        append_quoted(cr_names, iter);
         iter = iter + inc;
     }
 
-    cr_names = cr_names + ")";
+    cr_names += ")";
     if ( test == "col" )  colnames = cr_names;  // re-assign back to rownames or colnames
     else rownames = cr_names;
 
@@ -959,7 +1951,7 @@ void do_wrt_r_numvector (const T& start, const T& stop, T inc) {
 //    stop - value to end row/column names with
 //    inc - value to increment row/column names. Optional.
 //====================================================================================
-void wrt_r_namevector(const int& start, const int& stop, int inc = 1) {
+void RWriter::wrt_r_namevector(const int& start, const int& stop, int inc) {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
     do_wrt_r_numvector<int> (start, stop, inc);
@@ -967,7 +1959,7 @@ void wrt_r_namevector(const int& start, const int& stop, int inc = 1) {
 } // end wrt_r_namevector (int)
 
 ////====================================================================================
-void wrt_r_namevector(const ivector& rowvec, int start = 0, int stop = 0) {
+void RWriter::wrt_r_namevector(const ivector& rowvec, int start, int stop) {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
     do_wrt_r_namevector<ivector> (rowvec, start, stop);
@@ -1000,7 +1992,12 @@ void wrt_r_namevector(const ivector& rowvec, int start = 0, int stop = 0) {
 // ARGUMENTS:
 //      name - name of object
 //=======================================================================================
-void open_r_list(const char* name) {
+void RWriter::open_r_list(const char* name) {
+    if ( rbinary ) {
+        rbin_open_list(name);
+        return;
+    }
+
     // add info object name to list and check for object completion
     int flag = reg_Rnames(name, "List Object ");
     if ( flag == 0 ) return;
@@ -1027,9 +2024,14 @@ void open_r_list(const char* name) {
 //
 // No arguments.
 //======================================================================================
-void close_r_list() {
+void RWriter::close_r_list() {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_close_list("close_r_list");
+        return;
+    }
+
     // check that at least one item is included in list
     if ( Rnames[level] == "c(" ) {
         if ( rfile.is_open() ) rfile.close();
@@ -1076,7 +2078,30 @@ void close_r_list() {
 //       name - name of INFO object (e.g., "metadata")
 //       writestamp - whether or not to write the date subobject. Optional.
 //======================================================================================
-void open_r_info_list(const char* name, bool writestamp=true) {
+void RWriter::open_r_info_list(const char* name, bool writestamp) {
+    // get date and time
+    time_t ltime;
+    struct tm today;
+    char tmpbuf[50];
+
+    if ( writestamp ) {
+        time( &ltime );  // get time as a long integer.
+#ifdef _WIN32
+        localtime_s( &today, &ltime );  // convert to local time (re-entrant).
+#else
+        localtime_r( &ltime, &today );
+#endif
+        strftime( tmpbuf, 50,
+                  "%A, %d %b %Y at %H:%M:%S", &today );  // apply formatting.
+    }
+
+    if ( rbinary ) {
+        rbin_open_list(name);
+        vecflag = "info";
+        if ( writestamp ) rbin_item("date", tmpbuf);
+        return;
+    }
+
     // add info object name to list and check for object completion
     int flag = reg_Rnames(name, "Info Object ");
     if ( flag == 0 ) return;
@@ -1090,16 +2115,6 @@ void open_r_info_list(const char* name, bool writestamp=true) {
     colnames = "c(";
     if ( writestamp ) {
 
-        // get date and time
-        time_t ltime;
-        struct tm *today;
-        char tmpbuf[50];
-
-        time( &ltime );  // get time as a long integer.
-        today = localtime( &ltime );  // convert to local time.
-        strftime( tmpbuf, 50,
-                  "%A, %d %b %Y at %H:%M:%S", today );  // apply formatting.
-
         // write date and time stamp
         rfile << "date = " << quote << tmpbuf << quote;
 
@@ -1116,9 +2131,15 @@ void open_r_info_list(const char* name, bool writestamp=true) {
 //
 // No arguments.
 //=====================================================================================
-void close_r_info_list() {
+void RWriter::close_r_info_list() {
     if ( OKflag == false ) return;           // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_close_list("close_r_info_list");
+        vecflag.erase();
+        return;
+    }
+
     if ( colnames == "c(" ) {                // check that there is at least one item
         if ( rfile.is_open() ) rfile.close();
         err_msg = err_msg + "\n**** ADMB2R Error: No items written to ";
@@ -1151,7 +2172,13 @@ void close_r_info_list() {
 //   ARGUMENTS:
 //       name - name of vector object (e.g., "agevector")
 //======================================================================================
-void open_r_vector(const char* name) {
+void RWriter::open_r_vector(const char* name) {
+    if ( rbinary ) {
+        rbin_open_vector(name);
+        vecflag = "vector";
+        return;
+    }
+
     // add vector name to list and check for object completion
     int flag = reg_Rnames(name, "Info Object ");
     if ( flag == 0 ) return;
@@ -1173,9 +2200,15 @@ void open_r_vector(const char* name) {
 //
 // No arguments.
 //=====================================================================================
-void close_r_vector() {
+void RWriter::close_r_vector() {
     if ( OKflag == false ) return;           // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_close_vector();
+        vecflag.erase();
+        return;
+    }
+
     if ( colnames == "c(" ) {                // check that there is at least one item
         if ( rfile.is_open() ) rfile.close();
         err_msg = err_msg + "\n**** ADMB2R Error: No items written to ";
@@ -1209,8 +2242,12 @@ void close_r_vector() {
 //   name - name of data subobject (int or char*)
 //   value - corresponding datum
 //=====================================================================================
-void wrt_r_item(const char* name, const char* value) {
+void RWriter::wrt_r_item(const char* name, const char* value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name, value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1222,8 +2259,12 @@ void wrt_r_item(const char* name, const char* value) {
 
 } //end wrt_r_item(char*)
 //======================================================================================
-void wrt_r_item(const char* name, bool value) {
+void RWriter::wrt_r_item(const char* name, bool value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name, value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1244,8 +2285,12 @@ void wrt_r_item(const char* name, bool value) {
 
 } // end wrt_r_item(boolean)
 //======================================================================================
-void wrt_r_item(int name, bool value) {
+void RWriter::wrt_r_item(int name, bool value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(rbin_name(name), value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(convert<char*>(name));
@@ -1266,8 +2311,12 @@ void wrt_r_item(int name, bool value) {
 
 } // end wrt_r_item(boolean)
 //======================================================================================
-void wrt_r_item(const char* name, int value) {
+void RWriter::wrt_r_item(const char* name, int value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name, value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1279,8 +2328,12 @@ void wrt_r_item(const char* name, int value) {
 
 } //end wrt_r_item(integer)
 //======================================================================================
-void wrt_r_item(int name, int value) {
+void RWriter::wrt_r_item(int name, int value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(rbin_name(name), value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(convert<char*>(name));
@@ -1292,8 +2345,12 @@ void wrt_r_item(int name, int value) {
 
 } //end wrt_r_item(integer)
 //======================================================================================
-void wrt_r_item(const char* name, double value) {
+void RWriter::wrt_r_item(const char* name, double value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name, value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1305,8 +2362,12 @@ void wrt_r_item(const char* name, double value) {
 
 } //end wrt_r_item(double)
 //======================================================================================
-void wrt_r_item(int name, double value) {
+void RWriter::wrt_r_item(int name, double value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(rbin_name(name), value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(convert<char *>(name));
@@ -1318,8 +2379,12 @@ void wrt_r_item(int name, double value) {
 
 } //end wrt_r_item(double)
 //======================================================================================
-void wrt_r_item(const char* name, dvariable value) {
+void RWriter::wrt_r_item(const char* name, dvariable value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name, value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1331,8 +2396,12 @@ void wrt_r_item(const char* name, dvariable value) {
 
 } //end wrt_r_item(dvariable)
 //======================================================================================
-void wrt_r_item(int name, dvariable value) {
+void RWriter::wrt_r_item(int name, dvariable value) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(rbin_name(name), value);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(convert<char*>(name));
@@ -1346,8 +2415,12 @@ void wrt_r_item(int name, dvariable value) {
 
 // overloaded functions to write NA's when no value argument is given
 //=====================================================================================
-void wrt_r_item(const char* name) {
+void RWriter::wrt_r_item(const char* name) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(name);
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(name);
@@ -1359,8 +2432,12 @@ void wrt_r_item(const char* name) {
 
 } //end wrt_r_item
 //=====================================================================================
-void wrt_r_item(int name) {
+void RWriter::wrt_r_item(int name) {
     if ( OKflag == false ) return;                   // exit if there is an error
+    if ( rbinary ) {
+        rbin_item(rbin_name(name));
+        return;
+    }
     if ( colnames != "c(" ) rfile << "," << endl;    // comma needed if not first item.
 
     add_colname(convert<char*>(name));
@@ -1390,8 +2467,11 @@ void wrt_r_item(int name) {
 //        1 = write row.names using the index values supplied
 //        2 = write row.names with vector or other values
 //======================================================================================
-void open_r_df(const char* name, int start = -1, int stop = -1, int writerow = 0) {
-    string temp;
+void RWriter::open_r_df(const char* name, int start, int stop, int writerow) {
+    if ( rbinary ) {
+        rbin_open_df(name, start, stop, writerow);
+        return;
+    }
 
     // add info object name to list and check for object completion
     int flag = reg_Rnames(name, "Data Frame Object ");
@@ -1434,9 +2514,14 @@ void open_r_df(const char* name, int start = -1, int stop = -1, int writerow = 0
 //
 // No arguments.
 //======================================================================================
-void close_r_df() {
+void RWriter::close_r_df() {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_close_df();
+        return;
+    }
+
     // check that column names not empty
     if ( colnames == "" || colnames == "c(" ) {
         if ( rfile.is_open() ) rfile.close();
@@ -1519,10 +2604,15 @@ void close_r_df() {
 //      indicates the spot to replace with NA.
 //======================================================================================
 template <class T>
-void do_df_col_wrt_vec (const char* name, const T& xx, int shift, bool* na_vector = NULL) {
+void RWriter::do_df_col_wrt_vec(const char* name, const T& xx, int shift, bool* na_vector) {
 
     int counter;                                // counter to limit line lengths
 
+    if ( rbinary ) {
+        rbin_df_col_vec(name, xx, shift, na_vector);
+        return;
+    }
+
 	// if this is not the first item, print the comma separating the previous item
     if ( colnames != "c(" ) rfile << "," << endl;
 
@@ -1560,7 +2650,7 @@ void do_df_col_wrt_vec (const char* name, const T& xx, int shift, bool* na_vecto
             rfile << "NA";
         }     // ( write NA
         else { // if value is the missing value indicator, write "NA" instead
-            if ( test_missing(convert<double>(xx[y + yshift])) && writeNA == true ) {
+            if ( writeNA == true && test_missing_value(xx[y + yshift]) ) {
                 rfile << "NA";
             } // if the value in the boolean vector is true, write "NA"
             else if (naflag && na_vector[y] == true) {
@@ -1605,8 +2695,8 @@ void do_df_col_wrt_vec (const char* name, const T& xx, int shift, bool* na_vecto
 //      indicates the spot to replace with NA. This argument is passed to do_df_col_wrt_vec
 //      for further handling.
 //======================================================================================
-void wrt_r_df_col(const char* name, const dvector& xx, int shift = -999999,
-                  bool isna = false, bool* na_vector = NULL) {
+void RWriter::wrt_r_df_col(const char* name, const dvector& xx, int shift,
+                           bool isna, bool* na_vector) {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
     naflag = isna;
@@ -1615,8 +2705,8 @@ void wrt_r_df_col(const char* name, const dvector& xx, int shift = -999999,
 
 } // end wrt_r_df_col (dvector)
 //======================================================================================
-void wrt_r_df_col(const char* name, const ivector& xx, int shift = -999999,
-                  bool isna = false, bool* na_vector = NULL) {
+void RWriter::wrt_r_df_col(const char* name, const ivector& xx, int shift,
+                           bool isna, bool* na_vector) {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
     naflag = isna;
@@ -1625,8 +2715,8 @@ void wrt_r_df_col(const char* name, const ivector& xx, int shift = -999999,
 
 } // end wrt_r_df_col (ivector)
 //======================================================================================
-void wrt_r_df_col(const char* name, const dvar_vector& xx, int shift = -999999,
-                  bool isna = false, bool* na_vector = NULL) {
+void RWriter::wrt_r_df_col(const char* name, const dvar_vector& xx, int shift,
+                           bool isna, bool* na_vector) {
     if ( OKflag == false ) return; // exit if there was an earlier error
 
     naflag = isna;
@@ -1652,11 +2742,16 @@ void wrt_r_df_col(const char* name, const dvar_vector& xx, int shift = -999999,
 //      indicates the spot to replace with NA.
 //======================================================================================
 template <class T>
-void do_df_col_wrt_num (const char* name, const T& start, const T& stop, T inc,
-                        bool* na_vector = NULL) {
+void RWriter::do_df_col_wrt_num(const char* name, const T& start, const T& stop, T inc,
+                                 bool* na_vector) {
 
     int counter;                                // counter to limit line lengths
 
+    if ( rbinary ) {
+        rbin_df_col_num(name, start, stop, inc, na_vector);
+        return;
+    }
+
 	// index values not initialized
     if ( dim1 == -1 && dim2 == -1 ) {
         if ( rfile.is_open() ) rfile.close();
@@ -1726,8 +2821,8 @@ void do_df_col_wrt_num (const char* name, const T& start, const T& stop, T inc,
 //      indicates the spot to replace with NA. This argument is passed to do_df_col_wrt_vec
 //      for further handling.
 //======================================================================================
-void wrt_r_df_col(const char* name, const int& start, const int& stop, int inc = 1,
-                  bool isna = false, bool* na_vector = NULL) {
+void RWriter::wrt_r_df_col(const char* name, const int& start, const int& stop, int inc,
+                           bool isna, bool* na_vector) {
 
     if ( OKflag == false ) return; // exit if there was an earlier error
 
@@ -1773,9 +2868,14 @@ void wrt_r_df_col(const char* name, const int& start, const int& stop, int inc =
 //      name - name of vector to write to file.
 //======================================================================================
 
-void open_r_complete_vector (const char* name) {
+void RWriter::open_r_complete_vector(const char* name) {
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_cur = rbin_reg(name, RBIN_VECTOR);
+        return;
+    }
+
     // add vector object name to list and check for object completion
     int flag = reg_Rnames(name, "Vector Object ");
     if ( flag == 0 ) return;
@@ -1790,9 +2890,14 @@ void open_r_complete_vector (const char* name) {
 //
 // No arguments.
 //======================================================================================
-void close_r_complete_vector() {
+void RWriter::close_r_complete_vector() {
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_cur = -1;
+        return;
+    }
+
     colnames.erase();                       // clear row and column names
     rownames.erase();
 
@@ -1825,8 +2930,8 @@ void close_r_complete_vector() {
 //      indicates the spot to replace with NA.
 //====================================================================================
 template <class T>
-void do_wrt_r_complete_vector (const T& xvec, int name_flag, const ivector& name_vector,
-                        ivector& na_vector) {
+void RWriter::do_wrt_r_complete_vector(const T& xvec, int name_flag, const ivector& name_vector,
+                                 ivector& na_vector) {
 
     int ir;                       // row iterator in for statement
     int ra, rz, na, nz;           // for vector bounds
@@ -1836,6 +2941,11 @@ void do_wrt_r_complete_vector (const T& xvec, int name_flag, const ivector& name
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
+    if ( rbinary ) {
+        rbin_complete_vector(xvec, name_flag, name_vector, na_vector);
+        return;
+    }
+
    ra = (xvec).indexmin();               // Get starting index value
     rz = (xvec).indexmax();               // Get ending index value
    nelem1 = rz - ra + 1;                 // number of elements in xvec
@@ -1857,7 +2967,7 @@ void do_wrt_r_complete_vector (const T& xvec, int name_flag, const ivector& name
    }
 
     // Write the vector data
-   i==0;
+   i = 0;
    counter = 0;
     for ( ir=ra; ir<=rz; ir++ ) {
 
@@ -1866,7 +2976,7 @@ void do_wrt_r_complete_vector (const T& xvec, int name_flag, const ivector& name
 
       // if value is the missing value indicator, and we're
         // using a missing value "value",  write "NA" instead
-        if ( test_missing(convert<double>(xvec(ir))) && writeNA == true ) {
+        if ( writeNA == true && test_missing_value(xvec(ir)) ) {
             rfile << "NA";
         }
         // if instead we're using a vector of booleans to
@@ -1950,8 +3060,8 @@ void do_wrt_r_complete_vector (const T& xvec, int name_flag, const ivector& name
 //      indicates the spot to replace with NA. This argument is passed to do_wrt_r_complete_vector
 //      for further handling.
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -1966,8 +3076,8 @@ void wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
 
 } // wrt_r_complete_vector (dvar_vector)
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const dvector& xvec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const dvector& xvec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -1982,8 +3092,8 @@ void wrt_r_complete_vector(const char* name, const dvector& xvec,
 
 } // wrt_r_complete_vector (dvector)
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const ivector& xvec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const ivector& xvec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -1998,8 +3108,8 @@ void wrt_r_complete_vector(const char* name, const ivector& xvec,
 
 } // end wrt_r_complete_vector (ivector)
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const dvar_vector& xvec, const ivector& namevec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const dvar_vector& xvec, const ivector& namevec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -2014,8 +3124,8 @@ void wrt_r_complete_vector(const char* name, const dvar_vector& xvec, const ivec
 
 } // wrt_r_complete_vector (dvar_vector, ivector)
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const dvector& xvec, const ivector& namevec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const dvector& xvec, const ivector& namevec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -2030,8 +3140,8 @@ void wrt_r_complete_vector(const char* name, const dvector& xvec, const ivector&
 
 } // wrt_r_complete_vector (dvector, ivector)
 //======================================================================================
-void wrt_r_complete_vector(const char* name, const ivector& xvec, const ivector& namevec,
-                  bool isna = false, ivector& na_vector = dum_vector) {
+void RWriter::wrt_r_complete_vector(const char* name, const ivector& xvec, const ivector& namevec,
+                           bool isna, ivector& na_vector) {
 
     if ( OKflag == false ) return;    // exit if there was an earlier error
 
@@ -2046,6 +3156,113 @@ void wrt_r_complete_vector(const char* name, const ivector& xvec, const ivector&
 
 } // end wrt_r_complete_vector (ivector, ivector)
 //======================================================================================
+// FREE FUNCTIONS
+//
+// The original ADMB2R interface.  Each routine writes through default_rwriter, so a
+// model that writes one R file at a time (e.g. make-Rfile_asap3.cxx) keeps working
+// unchanged.  Code that writes several files at once should use its own RWriter.
+//======================================================================================
+RWriter default_rwriter;
+
+void open_r_file(const char* fname, int numdigits = -1) {
+    default_rwriter.open_r_file(fname, numdigits);
+}
+void open_r_file(const char* fname, int numdigits, double ismissing,
+                 int format = ADMB2R_TEXT) {
+    default_rwriter.open_r_file(fname, numdigits, ismissing, format);
+}
+void close_r_file() { default_rwriter.close_r_file(); }
+void wrt_r_comment(const char* text) { default_rwriter.wrt_r_comment(text); }
+
+void open_r_matrix(const char* name) { default_rwriter.open_r_matrix(name); }
+void close_r_matrix() { default_rwriter.close_r_matrix(); }
+void wrt_r_matrix(const dvar_matrix& xx, int rowoption = 0, int coloption = 0,
+                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+    default_rwriter.wrt_r_matrix(xx, rowoption, coloption, isna, na_matrix);
+}
+void wrt_r_matrix(const dmatrix& xx, int rowoption = 0, int coloption = 0,
+                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+    default_rwriter.wrt_r_matrix(xx, rowoption, coloption, isna, na_matrix);
+}
+void wrt_r_matrix(const imatrix& xx, int rowoption = 0, int coloption = 0,
+                  bool isna = false, imatrix& na_matrix = dum_matrix) {
+    default_rwriter.wrt_r_matrix(xx, rowoption, coloption, isna, na_matrix);
+}
+void wrt_r_namevector(const int& start, const int& stop, int inc = 1) {
+    default_rwriter.wrt_r_namevector(start, stop, inc);
+}
+void wrt_r_namevector(const ivector& rowvec, int start = 0, int stop = 0) {
+    default_rwriter.wrt_r_namevector(rowvec, start, stop);
+}
+
+void open_r_list(const char* name) { default_rwriter.open_r_list(name); }
+void close_r_list() { default_rwriter.close_r_list(); }
+void open_r_info_list(const char* name, bool writestamp = true) {
+    default_rwriter.open_r_info_list(name, writestamp);
+}
+void close_r_info_list() { default_rwriter.close_r_info_list(); }
+void open_r_vector(const char* name) { default_rwriter.open_r_vector(name); }
+void close_r_vector() { default_rwriter.close_r_vector(); }
+void wrt_r_item(const char* name, const char* value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(const char* name, bool value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(int name, bool value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(const char* name, int value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(int name, int value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(const char* name, double value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(int name, double value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(const char* name, dvariable value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(int name, dvariable value) { default_rwriter.wrt_r_item(name, value); }
+void wrt_r_item(const char* name) { default_rwriter.wrt_r_item(name); }
+void wrt_r_item(int name) { default_rwriter.wrt_r_item(name); }
+
+void open_r_df(const char* name, int start = -1, int stop = -1, int writerow = 0) {
+    default_rwriter.open_r_df(name, start, stop, writerow);
+}
+void close_r_df() { default_rwriter.close_r_df(); }
+void wrt_r_df_col(const char* name, const dvector& xx, int shift = -999999,
+                  bool isna = false, bool* na_vector = NULL) {
+    default_rwriter.wrt_r_df_col(name, xx, shift, isna, na_vector);
+}
+void wrt_r_df_col(const char* name, const ivector& xx, int shift = -999999,
+                  bool isna = false, bool* na_vector = NULL) {
+    default_rwriter.wrt_r_df_col(name, xx, shift, isna, na_vector);
+}
+void wrt_r_df_col(const char* name, const dvar_vector& xx, int shift = -999999,
+                  bool isna = false, bool* na_vector = NULL) {
+    default_rwriter.wrt_r_df_col(name, xx, shift, isna, na_vector);
+}
+void wrt_r_df_col(const char* name, const int& start, const int& stop, int inc = 1,
+                  bool isna = false, bool* na_vector = NULL) {
+    default_rwriter.wrt_r_df_col(name, start, stop, inc, isna, na_vector);
+}
+
+void open_r_complete_vector(const char* name) { default_rwriter.open_r_complete_vector(name); }
+void close_r_complete_vector() { default_rwriter.close_r_complete_vector(); }
+void wrt_r_complete_vector(const char* name, const dvar_vector& xvec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, isna, na_vector);
+}
+void wrt_r_complete_vector(const char* name, const dvector& xvec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, isna, na_vector);
+}
+void wrt_r_complete_vector(const char* name, const ivector& xvec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, isna, na_vector);
+}
+void wrt_r_complete_vector(const char* name, const dvar_vector& xvec, const ivector& namevec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, namevec, isna, na_vector);
+}
+void wrt_r_complete_vector(const char* name, const dvector& xvec, const ivector& namevec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, namevec, isna, na_vector);
+}
+void wrt_r_complete_vector(const char* name, const ivector& xvec, const ivector& namevec,
+                           bool isna = false, ivector& na_vector = dum_vector) {
+    default_rwriter.wrt_r_complete_vector(name, xvec, namevec, isna, na_vector);
+}
+//======================================================================================
 // End File admb2r.cpp
 //=======================================================================================
 
@@ -11,6 +11,19 @@
 // expected population at age in year 1 can be either an exponential decline or user initial guesses for optional deviation calculations
 // compute Francis (2011) stage 2 multiplier for multinomial to adjust input Neff
 
+// update October 2026
+// F, Z, N at age, SSB, SR predicted recruits and catch at age are computed by popdy_kernel.cpp as a single
+// AD node with a hand-written adjoint; -adpop command line option uses the original element-wise code
+// F reference points (F30%SPR, F40%SPR, Fmsy, F0.1, Fmax) and F%SPR projections are found with Brent's method
+// on double precision SPR and YPR with analytic derivatives (refpt_solver.cpp) instead of 20-step bisections
+// SPR and YPR for the reference points come from the per-recruit engine shared with AMAK (em_input/common/per-recruit.cpp)
+// -mcbin command line option: mceval draws go to one fixed-width binary file, asap3MCMC.bin (see mcmc_sink.cpp),
+// instead of asap3MCMC.dat and asap3.bsn; with make_Rfile the chain is also exported to asap3MCMC.rdat (.rbin)
+// make_Rfile=2 writes the ADMB2R output as a binary .rbin file
+// adaptive phases (phase_scheduler.cpp): function evaluations and wall time by phase are written to asap3.phs;
+// with -collapsephases, once a phase ends where it started the later phases other than the last are not
+// iterated (maximum_function_evaluations 0), which can change the final estimates, so it is off by default
+
 // update April 2012
 // fix bug with which inconsistent year for M and WAA used in calculation of unexploited SSB per recruit
 // (was first year when all other calculations were last year, now everything last year)
@@ -51,13 +64,23 @@ TOP_OF_MAIN_SECTION
 GLOBALS_SECTION
   #include <admodel.h>
   #include <time.h>
+  #include <chrono>
   #include <admb2r.cpp> // modify the position of admb2r.cpp
+  #include <mcmc_sink.cpp> // binary MCMC output, used with -mcbin
+  #include <popdy_kernel.cpp> // closed-form adjoint for F, N at age, SSB and catch at age
+  #include <per-recruit.cpp> // per-recruit engine shared with AMAK (em_input/common, on the include path)
+  #include <refpt_solver.cpp> // SPR and YPR reference points by Brent's method
+  #include <phase_scheduler.cpp> // evaluations and wall time by phase, collapsed phases
   // #include <C:\ADMB\admb2r-1.15\admb2r\admb2r.cpp>
   time_t start,finish;
   long hour,minute,second;
   double elapsed_time;
   ofstream ageproMCMC("asap3.bsn");
   ofstream basicMCMC("asap3MCMC.dat"); 
+  mcmc_sink mcmcbin; // asap3MCMC.bin, replaces the two files above when run with -mcbin
+  popdy_kernel popdy; // buffers for get_numbers_at_age, reused every function evaluation
+  refpt_curve refpts; // SPR and YPR curve of the last year, set in get_Fref
+  phase_scheduler phases; // checked at every function evaluation, in phase_schedule
   ofstream inputlog("asap3input.log");
   //--- preprocessor macro from Larry Jacobson NMFS-Woods Hole
   #define ICHECK(object) inputlog << "#" #object "\n " << object << endl;
@@ -78,6 +101,10 @@ DATA_SECTION
  !!  pi=3.14159265358979;
   number CVfill
  !! CVfill=100.0;
+  int use_popdy_kernel // 1 = population dynamics as one AD node (popdy_kernel.cpp), 0 = run with -adpop: element-wise AD
+ !! use_popdy_kernel = (option_match(argc,argv,"-adpop") > -1) ? 0 : 1;
+  int collapse_phases // 1 = run with -collapsephases: collapse phases after one that does not move the parameters, 0 = every phase to its limits
+ !! collapse_phases = (option_match(argc,argv,"-collapsephases") > -1) ? 1 : 0;
 // basic dimensions
   init_int nyears
  !! ICHECK(nyears);
@@ -762,8 +789,37 @@ DATA_SECTION
 // MCMC Info*******************************
   init_int doMCMC
  !! ICHECK(doMCMC);
+  int mcmc_binary // 1 = run with -mcbin: one binary record per draw in asap3MCMC.bin
  LOCAL_CALCS
-  if (doMCMC == 1)
+  mcmc_binary = (option_match(argc,argv,"-mcbin") > -1);
+  if (mcmc_binary == 1 && doMCMC != 1)
+  {
+     // the binary sink is only opened for an MCMC run; keep the text files otherwise
+     cerr << "-mcbin ignored: doMCMC is off in the input file, MCMC output goes to asap3MCMC.dat and asap3.bsn" << endl;
+     mcmc_binary = 0;
+  }
+  if (doMCMC == 1 && mcmc_binary == 1)
+  {
+     // same columns as asap3.bsn followed by those of asap3MCMC.dat
+     vector<string> mcmc_names;
+     for (iage=1;iage<=nages;iage++)
+        mcmc_names.push_back(string((char*)(adstring("NAAbsn") + str(iage))));
+     for (iyear=1;iyear<=nyears;iyear++)
+        mcmc_names.push_back(string((char*)(adstring("F") + str(iyear+year1-1))));
+     for (iyear=1;iyear<=nyears;iyear++)
+        mcmc_names.push_back(string((char*)(adstring("SSB") + str(iyear+year1-1))));
+     for (iyear=1;iyear<=nyears;iyear++)
+        mcmc_names.push_back(string((char*)(adstring("Fmult_") + str(iyear+year1-1))));
+     for (iyear=1;iyear<=nyears;iyear++)
+        mcmc_names.push_back(string((char*)(adstring("totBjan1_") + str(iyear+year1-1))));
+     mcmc_names.push_back("MSY");
+     mcmc_names.push_back("SSBmsy");
+     mcmc_names.push_back("Fmsy");
+     mcmc_names.push_back("SSBmsy_ratio");
+     mcmc_names.push_back("Fmsy_ratio");
+     mcmcbin.open("asap3MCMC.bin", mcmc_names);
+  }
+  else if (doMCMC == 1)
   {
      basicMCMC << " ";
      for (iyear=1;iyear<=nyears;iyear++)
@@ -808,7 +864,7 @@ DATA_SECTION
   init_int Ravg_end
  !! ICHECK(Ravg_end);
   
-  init_int make_Rfile // option to create rdat file of input and output values, set to 1 to create the file, 0 to skip this feature
+  init_int make_Rfile // option to create rdat file of input and output values, set to 1 to create the file, 2 to write the binary rbin file instead, 0 to skip this feature
  !! ICHECK(make_Rfile); 
 
   init_int test_value
@@ -1034,7 +1090,6 @@ PARAMETER_SECTION
   number SPR_Fmult
   number YPR_Fmult
   number SPR
-  number SPRatio
   number YPR
   number S_F
   number R_F
@@ -1247,6 +1302,8 @@ PRELIMINARY_CALCS_SECTION
 
 //************************************************************************************************
 PROCEDURE_SECTION                          
+  if (sd_phase()) phases.sd_evaluation();
+  else if (!mceval_phase()) phase_schedule();
                                       //  if (debug==1) cout << "starting procedure section" << endl;
   get_SR();                          //  if (debug==1) cout << "got SR" << endl;
   get_selectivity();                  //  if (debug==1) cout << "got selectivity" << endl;
@@ -1357,6 +1414,7 @@ FUNCTION get_mortality_rates
              log_Fmult(ifleet,iyear)=log_Fmult_year1(ifleet);
      }
   }
+  if (use_popdy_kernel==1) return; // F, Z and S are computed with N at age in get_numbers_at_age
   FAA_tot=0.0;
   for (ifleet=1;ifleet<=nfleets;ifleet++)
   {
@@ -1385,26 +1443,36 @@ FUNCTION get_numbers_at_age
         NAA(1,iage)=NAA_year1_ini(iage)*mfexp(log_N_year1_devs(iage));
      }
   }
-// compute initial SSB to derive R in first year  
-  SSB(1)=0.0;
-  for (iage=2;iage<=nages;iage++)
+  if (use_popdy_kernel==1)
   {
-     SSB(1)+=NAA(1,iage)*SSBfracZ(1,iage)*fecundity(1,iage);  // note SSB in year 1 does not include age 1 to estimate pred_R in year 1
+// F, Z, S, N at age, SSB, predicted recruits and catch at age in one pass with its own adjoint
+     popdy_kernel_ad(popdy,log_Fmult,sel_by_fleet,proportion_release,release_mort,M,fecundity,fracyearSSB,
+                     log_recruit_devs,SR_alpha,SR_beta,FAA_by_fleet_dir,FAA_by_fleet_Discard,FAA_tot,Z,S,
+                     SSBfracZ,NAA,SSB,SR_pred_recruits,CAA_pred,Discard_pred);
   }
-  SR_pred_recruits(1)=SR_alpha*SSB(1)/(SR_beta+SSB(1));
-  NAA(1,1)=SR_pred_recruits(1)*mfexp(log_recruit_devs(1));
-  SSB(1)+=NAA(1,1)*SSBfracZ(1,1)*fecundity(1,1);   // now SSB in year 1 is complete and can be used for pred_R in year 2
-// fill out rest of matrix  
-  for (iyear=2;iyear<=nyears;iyear++)
+  else
   {
-     SR_pred_recruits(iyear)=SR_alpha*SSB(iyear-1)/(SR_beta+SSB(iyear-1));
-     NAA(iyear,1)=SR_pred_recruits(iyear)*mfexp(log_recruit_devs(iyear));
+// compute initial SSB to derive R in first year  
+     SSB(1)=0.0;
      for (iage=2;iage<=nages;iage++)
-         NAA(iyear,iage)=NAA(iyear-1,iage-1)*S(iyear-1,iage-1);
-     NAA(iyear,nages)+=NAA(iyear-1,nages)*S(iyear-1,nages);
-     SSB(iyear)=elem_prod(NAA(iyear),SSBfracZ(iyear))*fecundity(iyear);
+     {
+        SSB(1)+=NAA(1,iage)*SSBfracZ(1,iage)*fecundity(1,iage);  // note SSB in year 1 does not include age 1 to estimate pred_R in year 1
+     }
+     SR_pred_recruits(1)=SR_alpha*SSB(1)/(SR_beta+SSB(1));
+     NAA(1,1)=SR_pred_recruits(1)*mfexp(log_recruit_devs(1));
+     SSB(1)+=NAA(1,1)*SSBfracZ(1,1)*fecundity(1,1);   // now SSB in year 1 is complete and can be used for pred_R in year 2
+// fill out rest of matrix  
+     for (iyear=2;iyear<=nyears;iyear++)
+     {
+        SR_pred_recruits(iyear)=SR_alpha*SSB(iyear-1)/(SR_beta+SSB(iyear-1));
+        NAA(iyear,1)=SR_pred_recruits(iyear)*mfexp(log_recruit_devs(iyear));
+        for (iage=2;iage<=nages;iage++)
+            NAA(iyear,iage)=NAA(iyear-1,iage-1)*S(iyear-1,iage-1);
+        NAA(iyear,nages)+=NAA(iyear-1,nages)*S(iyear-1,nages);
+        SSB(iyear)=elem_prod(NAA(iyear),SSBfracZ(iyear))*fecundity(iyear);
+     }
+     SR_pred_recruits(nyears+1)=SR_alpha*SSB(nyears)/(SR_beta+SSB(nyears));
   }
-  SR_pred_recruits(nyears+1)=SR_alpha*SSB(nyears)/(SR_beta+SSB(nyears));
   for (iyear=1;iyear<=nyears;iyear++)
   {
      recruits(iyear)=NAA(iyear,1);
@@ -1447,8 +1515,8 @@ FUNCTION get_Freport
   if (Freport_wtopt==3) Freport=Freport_B;
   
 FUNCTION get_predicted_catch
-// assumes continuous F using Baranov equation
-  for (ifleet=1;ifleet<=nfleets;ifleet++)
+// assumes continuous F using Baranov equation (already done by popdy_kernel_ad unless -adpop)
+  for (ifleet=1;ifleet<=nfleets && use_popdy_kernel==0;ifleet++)
   {
      CAA_pred(ifleet)=elem_prod(elem_div(FAA_by_fleet_dir(ifleet),Z),elem_prod(1.0-S,NAA));
      Discard_pred(ifleet)=elem_prod(elem_div(FAA_by_fleet_Discard(ifleet),Z),elem_prod(1.0-S,NAA));
@@ -1639,143 +1707,51 @@ FUNCTION get_proj_sel
   proj_Discard_sel=Discard_F/max(dir_F);
 
 FUNCTION get_Fref
-// calculates a number of common F reference points using bisection algorithm
-  A=0.0;
-  B=5.0;
-  for (iloop=1;iloop<=20;iloop++)
-  {
-     C=(A+B)/2.0;
-     SPR_Fmult=C;
-     get_SPR();
-     if (SPR/SR_spawners_per_recruit<0.30)
-     {
-        B=C;
-     }
-     else
-     {
-        A=C;
-     }
-  }
-  F30SPR=C;
+// calculates a number of common F reference points using Brent's method on double precision SPR and YPR
+// with analytic derivatives (see refpt_solver.cpp), same brackets as the original 20-step bisections
+  refpts.set(M(nyears),fecundity(nyears),WAAcatchall(nyears),value(proj_dir_sel),value(proj_Discard_sel),
+             value(proj_nondir_F),fracyearSSB,SR_spawners_per_recruit,value(SR_alpha),value(SR_beta));
+  F30SPR=refpts.F_spr(0.30,0.0,5.0);
   Fref=F30SPR;
   get_Freport_ref();
   F30SPR_report=Fref_report;
+  SPR_Fmult=F30SPR;
+  get_SPR();
   F30SPR_slope=1.0/SPR;
-  A=0.0;
-  B=5.0;
-  for (iloop=1;iloop<=20;iloop++)
-  {
-     C=(A+B)/2.0;
-     SPR_Fmult=C;
-     get_SPR();
-     if (SPR/SR_spawners_per_recruit<0.40)
-     {
-        B=C;
-     }
-     else
-     {
-        A=C;
-     }
-  }
-  F40SPR=C;
+  F40SPR=refpts.F_spr(0.40,0.0,5.0);
   Fref=F40SPR;
   get_Freport_ref();
   F40SPR_report=Fref_report;
+  SPR_Fmult=F40SPR;
+  get_SPR();
   F40SPR_slope=1.0/SPR;
-  A=0.0;
-  B=3.0;
-  for (iloop=1;iloop<=20;iloop++)
-  {
-    C=(A+B)/2.0;
-    SPR_Fmult=C+delta;
-    get_SPR();
-    S_F=SR_alpha*SPR-SR_beta;
-    R_F=S_F/SPR;
-    YPR_Fmult=C+delta;
-    get_YPR();
-    slope=R_F*YPR;
-    SPR_Fmult=C;
-    get_SPR();
-    S_F=SR_alpha*SPR-SR_beta;
-    R_F=S_F/SPR;
-    YPR_Fmult=C;
-    get_YPR();
-    slope-=R_F*YPR;
-//    slope/=delta; only care pos or neg
-    if(slope>0.0) 
-    {
-       A=C;
-    }
-    else
-    {
-       B=C;
-    }
-  }
-  Fmsy=C;
+  Fmsy=refpts.F_msy(0.0,3.0);
   Fref=Fmsy;
   get_Freport_ref();
   Fmsy_report=Fref_report;
+  SPR_Fmult=Fmsy;
+  get_SPR();
+  S_F=SR_alpha*SPR-SR_beta;
+  R_F=S_F/SPR;
+  YPR_Fmult=Fmsy;
+  get_YPR();
   SSmsy=S_F;
   SSBmsy_report=SSmsy;
   if (SSmsy>0.0)
     SSBmsy_ratio=SSB(nyears)/SSmsy;
   MSY=YPR*R_F;
-  SPR_Fmult=Fmsy;
-  get_SPR();
   Fmsy_slope=1.0/SPR;
   YPR_Fmult=delta;
   get_YPR();
   slope_origin=YPR/delta;
-  A=0.0;
-  B=5.0;
-  for (iloop=1;iloop<=20;iloop++)
-  {
-     C=(A+B)/2.0;
-     YPR_Fmult=C+delta;
-     get_YPR();
-     slope=YPR;
-     YPR_Fmult=C;
-     get_YPR();
-     slope-=YPR;
-     slope/=delta;
-     if (slope<0.10*slope_origin)
-     {
-        B=C;
-     }
-     else
-     {
-        A=C;
-     }
-  }
-  F01=C;
+  F01=refpts.F_01(0.0,5.0);
   Fref=F01;
   get_Freport_ref();
   F01_report=Fref_report;
   SPR_Fmult=F01;
   get_SPR();
   F01_slope=1.0/SPR;
-  A=0.0;
-  B=10.0;
-  for (iloop=1;iloop<=20;iloop++)
-  {
-     C=(A+B)/2.0;
-     YPR_Fmult=C+delta;
-     get_YPR();
-     slope=YPR;
-     YPR_Fmult=C;
-     get_YPR();
-     slope-=YPR;
-     slope/=delta;
-     if (slope<0.0)
-     {
-        B=C;
-     }
-     else
-     {
-        A=C;
-     }
-  }
-  Fmax=C;
+  Fmax=refpts.F_max(0.0,10.0);
   Fref=Fmax;
   get_Freport_ref();
   Fmax_report=Fref_report;
@@ -1895,24 +1871,7 @@ FUNCTION project_into_future
     }
     else if (proj_what(iyear)==2)      // match F%SPR
     {
-       A=0.0;
-       B=5.0;
-       for (iloop=1;iloop<=20;iloop++)
-       {
-          C=(A+B)/2.0;
-          SPR_Fmult=C;
-          get_SPR();
-          SPRatio=SPR/SR_spawners_per_recruit;
-          if (SPRatio<proj_target(iyear))
-          {
-             B=C;
-          }
-          else
-          {
-             A=C;
-          }
-       }
-       proj_Fmult(iyear)=C;
+       proj_Fmult(iyear)=refpts.F_spr(proj_target(iyear),0.0,5.0); // refpts set in get_Fref
     }
     else if (proj_what(iyear)==3)      // project Fmsy
     {
@@ -2316,6 +2275,48 @@ FUNCTION compute_the_objective_function
   obj_fun+=fpenalty;
   // if (io==1) cout << "fpenalty " << fpenalty << endl;
 
+FUNCTION phase_schedule
+// counts the evaluation and, at the start of a phase, checks the phase before it (phase_scheduler.cpp);
+// with -collapsephases, once a phase has ended where it started, the phases from phases.collapse_from() to
+// the one before the last are limited to phases.collapse_maxfn function evaluations (ADMB reads the limit
+// when a phase starts)
+  // the parameters are copied only at the first evaluation of a phase
+  if (!phases.new_phase(current_phase()))
+  {
+     phases.evaluation(current_phase());
+     return;
+  }
+  int nphases=initial_params::max_number_phases;
+  if (phases.evaluation(current_phase(),nphases,estimated_parameters()) && collapse_phases==1 && phases.collapse_from()>0)
+  {
+     int nmax=maximum_function_evaluations.indexmax();
+     if (nmax<nphases)
+     {
+        dvector maxfn(1,nphases);
+        for (int p=1;p<=nphases;p++)
+           maxfn(p)=maximum_function_evaluations(p<nmax ? p : nmax);
+        maximum_function_evaluations.deallocate();
+        maximum_function_evaluations.allocate(1,nphases);
+        maximum_function_evaluations=maxfn;
+     }
+     for (int p=phases.collapse_from();p<nphases;p++)
+        maximum_function_evaluations(p)=phases.collapse_maxfn;
+  }
+
+FUNCTION dvector estimated_parameters()
+// values of all the parameters estimated in some phase, active yet or not, so the layout is the same in every phase
+  int n=0;
+  for (int ip=0;ip<initial_params::num_initial_params;ip++)
+     if ((initial_params::varsptr[ip])->phase_start>0)
+        n+=(initial_params::varsptr[ip])->size_count();
+  dvector x(1,n>0 ? n : 1);
+  x.initialize();
+  int ii=1;
+  for (int ip=0;ip<initial_params::num_initial_params;ip++)
+     if ((initial_params::varsptr[ip])->phase_start>0)
+        (initial_params::varsptr[ip])->copy_value_to_vector(x,ii);
+  return x;
+
 FUNCTION write_MCMC
 // first the output file for AgePro
   if (MCMCnyear_opt == 0)    // use final year
@@ -2374,6 +2375,23 @@ FUNCTION write_MCMC
   // end stuff Liz added
 
 
+// binary output: one fixed-width record per draw, no text formatting
+  if (mcmc_binary == 1)
+  {
+     mcmcbin.put(NAAbsn);
+     mcmcbin.put(Freport);
+     mcmcbin.put(SSB);
+     mcmcbin.put(tempFmult);
+     mcmcbin.put(rowsum(elem_prod(WAAjan1b, NAA)));
+     mcmcbin.put(MSY);
+     mcmcbin.put(SSmsy);
+     mcmcbin.put(Fmsy);
+     mcmcbin.put(SSBmsy_ratio);
+     mcmcbin.put(Fmsy_ratio);
+     mcmcbin.end_record();
+     return;
+  }
+
 // output the NAAbsn values  
   ageproMCMC << NAAbsn << endl;
   
@@ -3012,7 +3030,7 @@ REPORT_SECTION
   }
   report << "that's all" << endl;
   
-  if (make_Rfile==1 && last_phase())
+  if (make_Rfile>=1 && last_phase())
   {
     #include "make-Rfile_asap3.cxx"  // ADMB2R code in this file
   }
@@ -3034,4 +3052,34 @@ FINAL_SECTION
   cout<<"This run took: ";
   cout<<hour<<" hours, "<<minute<<" minutes, "<<second<<" seconds."<<endl<<endl<<endl;
 
+  // function evaluations and wall time by phase
+  phases.stop();
+  ofstream phsout("asap3.phs");
+  phases.write(phsout);
+  phsout.close();
+
+  // binary MCMC draws: write out the last block and, with make_Rfile, export the
+  // chain to asap3MCMC.rdat (or .rbin) as data frame "mcmc"
+  if (mcmcbin.is_open())
+  {
+    mcmcbin.close();
+    if (make_Rfile>=1 && mcmcbin.records()>0)
+    {
+      RWriter mcmcR("asap3MCMC.log");
+      if (make_Rfile==2)
+        mcmcR.open_r_file("asap3MCMC.rbin", 6, -99999, ADMB2R_BINARY);
+      else
+        mcmcR.open_r_file("asap3MCMC.rdat", 6, -99999);
+      mcmcR.open_r_info_list("info", true);
+        mcmcR.wrt_r_item("program", "ASAP3");
+        mcmcR.wrt_r_item("styr", year1);
+        mcmcR.wrt_r_item("nyears", nyears);
+        mcmcR.wrt_r_item("nages", nages);
+        mcmcR.wrt_r_item("draws", int(mcmcbin.records()));
+      mcmcR.close_r_info_list();
+      mcmcbin.export_r(mcmcR, "mcmc");
+      mcmcR.close_r_file();
+    }
+  }
+
 
@@ -4,6 +4,7 @@
 // Open the output file using the AD Model Builder template name, and
 // specify 6 digits of precision
 // use periods in R variable names instead of underscore
+// make_Rfile=2 writes the same objects to a binary .rbin file (read with R/read_rbin.R)
 
 // variables used for naming fleets and indices
 adstring ifleetchar;
@@ -12,7 +13,10 @@ adstring onenum(4);
 adstring onednm(4);
 adstring twodnm(4);
 
-open_r_file(adprogram_name + ".rdat", 6, -99999);
+if (make_Rfile==2)
+  open_r_file(adprogram_name + ".rbin", 6, -99999, ADMB2R_BINARY);
+else
+  open_r_file(adprogram_name + ".rdat", 6, -99999);
   
   // metadata 
   open_r_info_list("info", true);
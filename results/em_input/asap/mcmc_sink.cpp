@@ -0,0 +1,195 @@
+/********************************************************************************
+* mcmc_sink.cpp
+*
+* Append-only binary file for MCMC evaluation output.
+*
+* Each mceval draw is one fixed-width record of doubles, so writing a draw is a
+* copy into a buffer instead of formatting a line of text, and the whole chain can
+* be read back with one readBin() call in R.  The column names are written once in
+* the header, so the file describes itself.  Records are only ever appended; a
+* chain that stops early leaves every complete record readable.
+*
+* File layout (little-endian):
+*
+*   magic      8 bytes "MCMCSNK1"
+*   uint32     number of columns (ncol)
+*   uint32     0 (reserved)
+*   names      per column: uint32 length and bytes of the column name
+*   padding    zero bytes up to the next 8-byte boundary
+*   records    ncol float64 values per draw, in column order, until end of file
+*
+* The number of records is (file size - header size) / (8 * ncol).
+*
+* Requires admb2r.cpp to be included first (export_r writes through an RWriter).
+*
+* Version 1.0           17 Oct 2026     First version, for ASAP write_MCMC.
+*********************************************************************************/
+
+//=====================================================================================
+// mcmc_sink
+//
+// Usage: open() with the column names, then for every draw put() the values in column
+// order and call end_record().  close() writes any buffered records.  export_r()
+// writes the closed file as an R data frame through ADMB2R.
+//=====================================================================================
+class mcmc_sink {
+public:
+    mcmc_sink() : ncol(0), nput(0), nrec(0), header(0), OKflag(false) {}
+    ~mcmc_sink() { close(); }
+
+    //=================================================================================
+    // open
+    //
+    // Creates (or truncates) the file and writes the header.
+    //
+    // ARGUMENTS
+    //    fname - name of the binary file
+    //    colnames - one name per value in a record
+    //=================================================================================
+    void open(const char* fname, const vector<string>& colnames) {
+        close();
+        filename = fname;
+        names = colnames;
+        ncol = names.size();
+        nput = 0;
+        nrec = 0;
+        buf.clear();
+        buf.reserve(blockvalues + ncol);
+
+        file.open(fname, ios::out | ios::binary | ios::trunc);
+        OKflag = file.is_open() && ncol > 0;
+        if ( !OKflag ) {
+            cerr << "**** mcmc_sink: could not open " << fname << endl;
+            return;
+        }
+
+        string hdr(magic, 8);
+        put_uint32(hdr, (unsigned int) ncol);
+        put_uint32(hdr, 0);
+        for ( size_t k=0; k<ncol; k++ ) {
+            put_uint32(hdr, (unsigned int) names[k].size());
+            hdr += names[k];
+        }
+        while ( hdr.size() % 8 != 0 ) hdr += '\0';
+        header = hdr.size();
+        file.write(hdr.data(), hdr.size());
+    }
+
+    bool is_open() const { return file.is_open(); }
+    size_t records() const { return nrec; }
+
+    //=================================================================================
+    // put
+    //
+    // Appends values to the current record.  Overloaded for ADMB scalars and vectors;
+    // vectors are written in index order.
+    //=================================================================================
+    void put(double x) {
+        buf.push_back(x);
+        nput++;
+    }
+    void put(const prevariable& x) { put(value(x)); }
+    void put(const dvector& x) {
+        for ( int k=x.indexmin(); k<=x.indexmax(); k++ ) buf.push_back(x(k));
+        nput += x.indexmax() - x.indexmin() + 1;
+    }
+    void put(const dvar_vector& x) { put(value(x)); }
+
+    //=================================================================================
+    // end_record
+    //
+    // Closes the current draw.  A record with the wrong number of values is dropped
+    // so that the file stays fixed-width.
+    //=================================================================================
+    void end_record() {
+        if ( !OKflag ) {
+            buf.clear();
+            nput = 0;
+            return;
+        }
+        if ( nput != ncol ) {
+            cerr << "**** mcmc_sink: record has " << nput << " values, header has "
+                 << ncol << " columns; record dropped" << endl;
+            buf.resize(buf.size() - nput);
+        } else {
+            nrec++;
+            if ( buf.size() >= blockvalues ) flush();
+        }
+        nput = 0;
+    }
+
+    void flush() {
+        if ( !buf.empty() && file.is_open() ) {
+            file.write((const char*) &buf[0], buf.size() * sizeof(double));
+        }
+        buf.clear();
+    }
+
+    void close() {
+        if ( !file.is_open() ) return;
+        if ( nput != 0 ) buf.resize(buf.size() - nput);  // drop an unfinished record
+        nput = 0;
+        flush();
+        file.close();
+    }
+
+    //=================================================================================
+    // export_r
+    //
+    // Reads the closed file back and writes it as an R data frame with one row per
+    // draw and one column per header name.
+    //
+    // ARGUMENTS
+    //    r - an RWriter with an open output file
+    //    dfname - name of the data frame object
+    //=================================================================================
+    void export_r(RWriter& r, const char* dfname) {
+        if ( nrec == 0 ) return;
+
+        ifstream in(filename.c_str(), ios::in | ios::binary);
+        vector<double> data(nrec * ncol);
+        in.seekg(header);
+        in.read((char*) &data[0], data.size() * sizeof(double));
+        if ( !in ) {
+            cerr << "**** mcmc_sink: could not read back " << filename << endl;
+            return;
+        }
+
+        int n = (int) nrec;
+        dvector col(1, n);
+        r.open_r_df(dfname, 1, n);
+        r.wrt_r_df_col("draw", 1, n);
+        for ( size_t j=0; j<ncol; j++ ) {
+            for ( int k=1; k<=n; k++ ) col(k) = data[(k - 1) * ncol + j];
+            r.wrt_r_df_col(names[j].c_str(), col);
+        }
+        r.close_r_df();
+    }
+
+private:
+    mcmc_sink(const mcmc_sink&);            // not copyable: owns an open file
+    mcmc_sink& operator=(const mcmc_sink&);
+
+    static const size_t blockvalues = 1 << 15;  // 256 KB of doubles per write
+    static const char* magic;
+
+    static void put_uint32(string& s, unsigned int x) {
+        for ( int b=0; b<4; b++ ) s += char((x >> (8 * b)) & 0xFF);
+    }
+
+    ofstream file;
+    string filename;
+    vector<string> names;
+    vector<double> buf;
+    size_t ncol;                            // values per record
+    size_t nput;                            // values put into the current record
+    size_t nrec;                            // complete records written
+    size_t header;                          // header size in bytes
+    bool OKflag;
+};
+
+const char* mcmc_sink::magic = "MCMCSNK1";
+
+//======================================================================================
+// End File mcmc_sink.cpp
+//=======================================================================================
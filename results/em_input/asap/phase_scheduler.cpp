@@ -0,0 +1,171 @@
+/********************************************************************************
+* phase_scheduler.cpp
+*
+* Adaptive phases for ASAP: function evaluations and wall time by estimation
+* phase, and the phases that can be cut short once the parameters are at their
+* estimates.
+*
+* ADMB reads the maximum number of function evaluations for a phase from
+* maximum_function_evaluations (RUNTIME_SECTION) when the phase starts.  At the
+* first evaluation of each phase the estimated parameters are compared with their
+* values at the first evaluation of the phase before: if no value changed by more
+* than tol (relative), that phase ended where it started, so the start was already
+* at the optimum of the parameters active then.  The phases after the current one
+* and before the last can then be limited to collapse_maxfn evaluations; they only
+* guide the parameters towards the last phase (e.g. the F penalty that decreases
+* with the phase).  The last phase is never limited and runs to the convergence
+* criterion, but from wherever the others left the parameters, so with a phase
+* that activates new parameters collapsed it can end at a different optimum.
+* Collapsing is therefore up to the caller (off unless asked for); the counts
+* and times by phase are always kept.
+*
+* The evaluations of the Hessian and sdreport are counted in a row of their own
+* (sd_evaluation), not in the last phase.
+*
+* The parameter vector passed to evaluation() must have the same layout in every
+* phase (all the parameters estimated in some phase, active or not yet).
+*
+* Version 1.0           17 Oct 2026     First version.
+* Version 1.1           17 Oct 2026     Hessian and sdreport evaluations in their own row.
+*********************************************************************************/
+
+//=====================================================================================
+// phase_scheduler
+//
+// Usage: at every function evaluation of the minimization, if new_phase() is false call
+// evaluation(current), which only counts it; otherwise call evaluation() with the current
+// phase and the estimated parameters, which are only needed then.  When it returns true
+// a phase has started, and collapse_from() is the first phase that may be limited (0 if
+// none).  Call
+// sd_evaluation() instead for the evaluations of the Hessian and sdreport.  stop() at
+// the end of the run closes the time of the last phase, and write() reports the
+// evaluations and seconds by phase.
+//=====================================================================================
+class phase_scheduler {
+public:
+    phase_scheduler() : tol(1.e-6), collapse_maxfn(0), phase(0), first(0), in_sd(false),
+                        sd_evals(0), sd_seconds(0.) {}
+
+    //=================================================================================
+    // evaluation
+    //
+    // Counts the evaluation in the current phase.  At the first evaluation of a new
+    // phase, closes the time of the phase before and checks whether it moved.
+    //=================================================================================
+    bool evaluation(int current, int nphases, const dvector& x) {
+        if (current == phase) {
+            evaluation(current);
+            return false;
+        }
+        if (in_sd) {
+            stop();
+            in_sd = false;
+        }
+        if (evals.size() < size_t(nphases + 1)) {
+            evals.resize(nphases + 1, 0);
+            seconds.resize(nphases + 1, 0.);
+            moved.resize(nphases + 1, 1);
+        }
+        stop();
+        if (phase > 0 && !changed(x) && first == 0 && current < nphases - 1)
+            first = current + 1;
+        phase = current;
+        evals[phase]++;
+        xstart.deallocate();
+        xstart.allocate(x.indexmin(), x.indexmax());
+        xstart = x;
+        tstart = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    // whether an evaluation in phase current starts a new phase
+    bool new_phase(int current) const { return current != phase; }
+
+    // counts an evaluation in the current phase
+    void evaluation(int current) {
+        if (in_sd) {
+            stop();
+            in_sd = false;
+        }
+        evals[phase]++;
+    }
+
+    // first phase that may be limited to collapse_maxfn evaluations, 0 if none
+    int collapse_from() const { return first; }
+
+    //=================================================================================
+    // sd_evaluation
+    //
+    // Counts an evaluation of the Hessian or sdreport.  At the first, closes the time
+    // of the last phase.
+    //=================================================================================
+    void sd_evaluation() {
+        if (!in_sd) {
+            stop();
+            in_sd = true;
+            tstart = std::chrono::steady_clock::now();
+        }
+        sd_evals++;
+    }
+
+    //=================================================================================
+    // stop
+    //
+    // Adds the time since the start of the current phase (or of the Hessian and
+    // sdreport evaluations) to it.
+    //=================================================================================
+    void stop() {
+        std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        if (in_sd)
+            sd_seconds += std::chrono::duration<double>(t - tstart).count();
+        else if (phase > 0)
+            seconds[phase] += std::chrono::duration<double>(t - tstart).count();
+        tstart = t;
+    }
+
+    //=================================================================================
+    // write
+    //=================================================================================
+    void write(ostream& os) const {
+        os << "phase evaluations seconds moved" << endl;
+        for (size_t p = 1; p < evals.size(); p++) {
+            os << p << " " << evals[p] << " " << seconds[p] << " ";
+            if (int(p) < phase) os << moved[p];
+            else os << "NA";
+            os << endl;
+        }
+        if (sd_evals > 0)
+            os << "sd " << sd_evals << " " << sd_seconds << " NA" << endl;
+        if (first > 0)
+            os << "# phases " << first << " and after, except the last, could be limited to "
+               << collapse_maxfn << " evaluations" << endl;
+    }
+
+    double tol;                             // relative change for a parameter to have moved
+    int collapse_maxfn;                     // evaluations in a collapsed phase
+
+private:
+    // whether any parameter changed since the start of the phase before
+    bool changed(const dvector& x) {
+        int m = 0;
+        if (xstart.indexmax() == x.indexmax()) {
+            for (int i = x.indexmin(); i <= x.indexmax(); i++)
+                if (fabs(x(i) - xstart(i)) > tol * (1. + fabs(xstart(i)))) m = 1;
+        } else {
+            m = 1;
+        }
+        moved[phase] = m;
+        return m != 0;
+    }
+
+    vector<int> evals;                      // function evaluations by phase
+    vector<double> seconds;                 // wall time by phase
+    vector<int> moved;                      // whether each phase moved the parameters
+    dvector xstart;                         // estimated parameters at the start of the phase
+    std::chrono::steady_clock::time_point tstart;
+    int phase;                              // current phase, 0 before the first evaluation
+    int first;                              // first phase that may be collapsed
+    bool in_sd;                             // evaluations of the Hessian and sdreport started
+    int sd_evals;                           // their function evaluations
+    double sd_seconds;                      // and wall time
+};
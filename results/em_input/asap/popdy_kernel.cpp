@@ -0,0 +1,449 @@
+/********************************************************************************
+* popdy_kernel.cpp
+*
+* Hand-written forward and reverse (adjoint) code for the ASAP population
+* dynamics: fishing mortality by fleet, total mortality and survival, the
+* numbers-at-age recursion with the Beverton-Holt stock-recruitment curve,
+* spawning stock biomass, and Baranov catch and discards at age.
+*
+* With plain AD every multiply, exp and division in these fleet x year x age
+* loops is a node on the gradient stack.  Here the whole computation is one
+* node: the forward pass runs in doubles in preallocated buffers, and the
+* reverse pass maps the derivatives of all outputs back to the inputs with the
+* closed-form chain rule written out below.  The results are identical to the
+* element-wise code in asap3.tpl (run ASAP with -adpop to use that instead,
+* e.g. to compare gradients).
+*
+* Inputs (AD)    log_Fmult(f,y), sel_by_fleet(f,y,a), NAA(1,a) for a >= 2,
+*                log_recruit_devs(y), SR_alpha, SR_beta
+* Inputs (data)  proportion_release(f,y,a), release_mort(f), M(y,a),
+*                fecundity(y,a), fracyearSSB
+* Outputs        FAA_by_fleet_dir, FAA_by_fleet_Discard, FAA_tot, Z, S,
+*                SSBfracZ, NAA (except row 1 ages >= 2), SSB,
+*                SR_pred_recruits, CAA_pred, Discard_pred
+*
+* Version 1.0           17 Oct 2026     First version.
+*********************************************************************************/
+
+//=====================================================================================
+// popdy_kernel
+//
+// Double-precision forward and reverse pass on flat buffers.  Index (f,y,a) is
+// stored at (f*nyears + y)*nages + a, (y,a) at y*nages + a, all zero-based.
+// The forward buffers hold the state of the latest evaluation; reverse() uses
+// them, so it must follow the forward() of the same evaluation.
+//=====================================================================================
+class popdy_kernel {
+public:
+    popdy_kernel() : nf(0), ny(0), na(0), stamp(0) {}
+
+    void resize(int nfleets, int nyears, int nages) {
+        nf = nfleets;
+        ny = nyears;
+        na = nages;
+        size_t nfya = size_t(nf) * ny * na;
+        size_t nya = size_t(ny) * na;
+        pr.assign(nfya, 0.);  rm.assign(nf, 0.);  M.assign(nya, 0.);  fec.assign(nya, 0.);
+        logF.assign(size_t(nf) * ny, 0.);  sel.assign(nfya, 0.);  N1.assign(na, 0.);
+        rdev.assign(ny, 0.);
+        Fm.assign(size_t(nf) * ny, 0.);  Fd.assign(nfya, 0.);  Fr.assign(nfya, 0.);
+        Ftot.assign(nya, 0.);  Z.assign(nya, 0.);  S.assign(nya, 0.);  SZ.assign(nya, 0.);
+        N.assign(nya, 0.);  SSB.assign(ny, 0.);  R.assign(ny + 1, 0.);
+        CAA.assign(nfya, 0.);  Disc.assign(nfya, 0.);
+        bFd.assign(nfya, 0.);  bFr.assign(nfya, 0.);  bFtot.assign(nya, 0.);
+        bZ.assign(nya, 0.);  bS.assign(nya, 0.);  bSZ.assign(nya, 0.);  bN.assign(nya, 0.);
+        bSSB.assign(ny, 0.);  bR.assign(ny + 1, 0.);  bCAA.assign(nfya, 0.);
+        bDisc.assign(nfya, 0.);
+        blogF.assign(size_t(nf) * ny, 0.);  bsel.assign(nfya, 0.);  bN1.assign(na, 0.);
+        brdev.assign(ny, 0.);
+    }
+
+    //=================================================================================
+    // forward
+    //
+    // Same arithmetic, in the same order, as get_mortality_rates, the recursion in
+    // get_numbers_at_age and the Baranov equation in get_predicted_catch.
+    //=================================================================================
+    void forward() {
+        stamp++;
+        int f, y, a;
+        std::fill(Ftot.begin(), Ftot.end(), 0.);
+        for ( f=0; f<nf; f++ ) {
+            for ( y=0; y<ny; y++ ) {
+                double fm = exp(logF[fy(f,y)]);
+                Fm[fy(f,y)] = fm;
+                for ( a=0; a<na; a++ ) {
+                    size_t i = fya(f,y,a);
+                    Fd[i] = (fm * sel[i]) * (1.0 - pr[i]);
+                    Fr[i] = (fm * sel[i]) * (pr[i] * rm[f]);
+                    Ftot[ya(y,a)] += Fd[i] + Fr[i];
+                }
+            }
+        }
+        for ( size_t i=0; i<Z.size(); i++ ) {
+            Z[i] = Ftot[i] + M[i];
+            S[i] = exp(-1.0 * Z[i]);
+            SZ[i] = exp(-1.0 * frac * Z[i]);
+        }
+
+        // year 1: SSB without age 1 gives the year-1 recruitment
+        for ( a=1; a<na; a++ ) N[ya(0,a)] = N1[a];
+        SSB1a = 0.;
+        for ( a=1; a<na; a++ ) SSB1a += N[ya(0,a)] * SZ[ya(0,a)] * fec[ya(0,a)];
+        R[0] = alpha * SSB1a / (beta + SSB1a);
+        N[ya(0,0)] = R[0] * exp(rdev[0]);
+        SSB[0] = SSB1a + N[ya(0,0)] * SZ[ya(0,0)] * fec[ya(0,0)];
+        for ( y=1; y<ny; y++ ) {
+            R[y] = alpha * SSB[y-1] / (beta + SSB[y-1]);
+            N[ya(y,0)] = R[y] * exp(rdev[y]);
+            for ( a=1; a<na; a++ ) N[ya(y,a)] = N[ya(y-1,a-1)] * S[ya(y-1,a-1)];
+            N[ya(y,na-1)] += N[ya(y-1,na-1)] * S[ya(y-1,na-1)];
+            double ssb = 0.;
+            for ( a=0; a<na; a++ ) ssb += N[ya(y,a)] * SZ[ya(y,a)] * fec[ya(y,a)];
+            SSB[y] = ssb;
+        }
+        R[ny] = alpha * SSB[ny-1] / (beta + SSB[ny-1]);
+
+        // Baranov catch and discards
+        for ( f=0; f<nf; f++ ) {
+            for ( y=0; y<ny; y++ ) {
+                for ( a=0; a<na; a++ ) {
+                    size_t i = fya(f,y,a);
+                    size_t j = ya(y,a);
+                    CAA[i] = (Fd[i] / Z[j]) * ((1.0 - S[j]) * N[j]);
+                    Disc[i] = (Fr[i] / Z[j]) * ((1.0 - S[j]) * N[j]);
+                }
+            }
+        }
+    }
+
+    //=================================================================================
+    // reverse
+    //
+    // Given the derivatives of the objective with respect to the outputs (the b
+    // buffers of Fd, Fr, Ftot, Z, S, SZ, N, SSB, R, CAA and Disc), adds the
+    // derivatives with respect to the inputs to blogF, bsel, bN1, brdev, balpha
+    // and bbeta.  The output buffers are used as workspace.
+    //=================================================================================
+    void reverse() {
+        int f, y, a;
+        std::fill(blogF.begin(), blogF.end(), 0.);
+        std::fill(bsel.begin(), bsel.end(), 0.);
+        std::fill(bN1.begin(), bN1.end(), 0.);
+        std::fill(brdev.begin(), brdev.end(), 0.);
+        balpha = 0.;
+        bbeta = 0.;
+
+        // Baranov: C = F q with q = (1-S) N / Z
+        for ( f=0; f<nf; f++ ) {
+            for ( y=0; y<ny; y++ ) {
+                for ( a=0; a<na; a++ ) {
+                    size_t i = fya(f,y,a);
+                    size_t j = ya(y,a);
+                    double q = (1.0 - S[j]) * N[j] / Z[j];
+                    bFd[i] += bCAA[i] * q;
+                    bFr[i] += bDisc[i] * q;
+                    double bq = bCAA[i] * Fd[i] + bDisc[i] * Fr[i];
+                    bS[j] -= bq * N[j] / Z[j];
+                    bN[j] += bq * (1.0 - S[j]) / Z[j];
+                    bZ[j] -= bq * q / Z[j];
+                }
+            }
+        }
+
+        // recursion, last year first
+        sr_reverse(ny, SSB[ny-1], ny-1);
+        for ( y=ny-1; y>=1; y-- ) {
+            for ( a=0; a<na; a++ ) {
+                size_t j = ya(y,a);
+                bN[j] += bSSB[y] * SZ[j] * fec[j];
+                bSZ[j] += bSSB[y] * N[j] * fec[j];
+            }
+            size_t p = ya(y-1,na-1);
+            bN[p] += bN[ya(y,na-1)] * S[p];
+            bS[p] += bN[ya(y,na-1)] * N[p];
+            for ( a=1; a<na; a++ ) {
+                size_t q = ya(y-1,a-1);
+                bN[q] += bN[ya(y,a)] * S[q];
+                bS[q] += bN[ya(y,a)] * N[q];
+            }
+            double er = exp(rdev[y]);
+            bR[y] += bN[ya(y,0)] * er;
+            brdev[y] += bN[ya(y,0)] * N[ya(y,0)];
+            sr_reverse(y, SSB[y-1], y-1);
+        }
+        // year 1
+        double bSSB1a = bSSB[0];
+        bN[ya(0,0)] += bSSB[0] * SZ[ya(0,0)] * fec[ya(0,0)];
+        bSZ[ya(0,0)] += bSSB[0] * N[ya(0,0)] * fec[ya(0,0)];
+        bR[0] += bN[ya(0,0)] * exp(rdev[0]);
+        brdev[0] += bN[ya(0,0)] * N[ya(0,0)];
+        double d = beta + SSB1a;
+        bSSB1a += bR[0] * alpha * beta / (d * d);
+        balpha += bR[0] * SSB1a / d;
+        bbeta -= bR[0] * alpha * SSB1a / (d * d);
+        for ( a=1; a<na; a++ ) {
+            size_t j = ya(0,a);
+            bN[j] += bSSB1a * SZ[j] * fec[j];
+            bSZ[j] += bSSB1a * N[j] * fec[j];
+            bN1[a] = bN[j];
+        }
+
+        // mortality
+        for ( size_t j=0; j<Z.size(); j++ ) {
+            bZ[j] -= bSZ[j] * frac * SZ[j];
+            bZ[j] -= bS[j] * S[j];
+            bFtot[j] += bZ[j];
+        }
+        for ( f=0; f<nf; f++ ) {
+            for ( y=0; y<ny; y++ ) {
+                double fm = Fm[fy(f,y)];
+                double bfm = 0.;
+                for ( a=0; a<na; a++ ) {
+                    size_t i = fya(f,y,a);
+                    double bt = bFtot[ya(y,a)];
+                    double bd = bFd[i] + bt;
+                    double br = bFr[i] + bt;
+                    double kd = 1.0 - pr[i];
+                    double kr = pr[i] * rm[f];
+                    bsel[i] += fm * (bd * kd + br * kr);
+                    bfm += sel[i] * (bd * kd + br * kr);
+                }
+                blogF[fy(f,y)] += bfm * fm;
+            }
+        }
+    }
+
+    int nf, ny, na;
+    long stamp;                             // counts forward passes
+
+    // data
+    vector<double> pr, rm, M, fec;
+    double frac;
+    // inputs
+    vector<double> logF, sel, N1, rdev;
+    double alpha, beta;
+    // forward state and outputs
+    vector<double> Fm, Fd, Fr, Ftot, Z, S, SZ, N, SSB, R, CAA, Disc;
+    double SSB1a;
+    // adjoints of the outputs (set before reverse) and of the inputs (set by reverse)
+    vector<double> bFd, bFr, bFtot, bZ, bS, bSZ, bN, bSSB, bR, bCAA, bDisc;
+    vector<double> blogF, bsel, bN1, brdev;
+    double balpha, bbeta;
+
+private:
+    size_t fy(int f, int y) const { return size_t(f) * ny + y; }
+    size_t ya(int y, int a) const { return size_t(y) * na + a; }
+    size_t fya(int f, int y, int a) const { return (size_t(f) * ny + y) * na + a; }
+
+    // R[r] = alpha s / (beta + s) with s = SSB[y]
+    void sr_reverse(int r, double s, int y) {
+        double d = beta + s;
+        bSSB[y] += bR[r] * alpha * beta / (d * d);
+        balpha += bR[r] * s / d;
+        bbeta -= bR[r] * alpha * s / (d * d);
+    }
+};
+
+//=====================================================================================
+// ADMB glue
+//
+// popdy_kernel_ad copies the input values into the kernel, runs the forward pass,
+// writes the outputs into the model's dvar objects without recording anything on
+// the gradient stack, and registers dfpopdy_kernel as the single adjoint for all of
+// it.  The adjoint reads the derivatives of every output, runs the reverse pass and
+// adds the input derivatives.  Row 1 ages >= 2 of NAA is an input, so its total
+// derivative is written back after the restore.
+//=====================================================================================
+static void dfpopdy_kernel(void);
+
+// copy a dvar3_array into a flat kernel buffer, and back without recording
+static void popdy_get(const dvar3_array& x, vector<double>& v) {
+    size_t i = 0;
+    for ( int f=x.indexmin(); f<=x.indexmax(); f++ )
+        for ( int y=x(f).rowmin(); y<=x(f).rowmax(); y++ )
+            for ( int a=x(f,y).indexmin(); a<=x(f,y).indexmax(); a++ ) v[i++] = value(x(f,y,a));
+}
+static void popdy_put(dvar3_array& x, const vector<double>& v) {
+    size_t i = 0;
+    for ( int f=x.indexmin(); f<=x.indexmax(); f++ )
+        for ( int y=x(f).rowmin(); y<=x(f).rowmax(); y++ )
+            for ( int a=x(f,y).indexmin(); a<=x(f,y).indexmax(); a++ ) x(f,y).elem_value(a) = v[i++];
+}
+static void popdy_put(dvar_matrix& x, const vector<double>& v) {
+    size_t i = 0;
+    for ( int y=x.rowmin(); y<=x.rowmax(); y++ )
+        for ( int a=x(y).indexmin(); a<=x(y).indexmax(); a++ ) x(y).elem_value(a) = v[i++];
+}
+
+void popdy_kernel_ad(popdy_kernel& k,
+                     const dvar_matrix& log_Fmult, const dvar3_array& sel_by_fleet,
+                     const d3_array& proportion_release, const dvector& release_mort,
+                     const dmatrix& M, const dmatrix& fecundity, double fracyearSSB,
+                     const dvar_vector& log_recruit_devs,
+                     const prevariable& SR_alpha, const prevariable& SR_beta,
+                     dvar3_array& FAA_by_fleet_dir, dvar3_array& FAA_by_fleet_Discard,
+                     dvar_matrix& FAA_tot, dvar_matrix& Z, dvar_matrix& S,
+                     dvar_matrix& SSBfracZ, dvar_matrix& NAA, dvar_vector& SSB,
+                     dvar_vector& SR_pred_recruits,
+                     dvar3_array& CAA_pred, dvar3_array& Discard_pred)
+{
+    int nf = log_Fmult.rowsize();
+    int ny = log_Fmult.colsize();
+    int na = M.colsize();
+    if ( k.nf != nf || k.ny != ny || k.na != na ) {
+        // data only: copied once
+        k.resize(nf, ny, na);
+        size_t i = 0, j = 0;
+        for ( int f=1; f<=nf; f++ ) {
+            k.rm[f-1] = release_mort(f);
+            for ( int y=1; y<=ny; y++ )
+                for ( int a=1; a<=na; a++ ) k.pr[i++] = proportion_release(f,y,a);
+        }
+        for ( int y=1; y<=ny; y++ ) {
+            for ( int a=1; a<=na; a++, j++ ) {
+                k.M[j] = M(y,a);
+                k.fec[j] = fecundity(y,a);
+            }
+        }
+        k.frac = fracyearSSB;
+    }
+
+    // inputs
+    size_t i = 0;
+    for ( int f=1; f<=nf; f++ )
+        for ( int y=1; y<=ny; y++ ) k.logF[i++] = value(log_Fmult(f,y));
+    popdy_get(sel_by_fleet, k.sel);
+    for ( int a=2; a<=na; a++ ) k.N1[a-1] = value(NAA(1,a));
+    for ( int y=1; y<=ny; y++ ) k.rdev[y-1] = value(log_recruit_devs(y));
+    k.alpha = value(SR_alpha);
+    k.beta = value(SR_beta);
+
+    k.forward();
+
+    // outputs (row 1 of NAA is unchanged for ages >= 2)
+    popdy_put(FAA_by_fleet_dir, k.Fd);
+    popdy_put(FAA_by_fleet_Discard, k.Fr);
+    popdy_put(FAA_tot, k.Ftot);
+    popdy_put(Z, k.Z);
+    popdy_put(S, k.S);
+    popdy_put(SSBfracZ, k.SZ);
+    popdy_put(NAA, k.N);
+    for ( int y=1; y<=ny; y++ ) SSB.elem_value(y) = k.SSB[y-1];
+    for ( int y=1; y<=ny+1; y++ ) SR_pred_recruits.elem_value(y) = k.R[y-1];
+    popdy_put(CAA_pred, k.CAA);
+    popdy_put(Discard_pred, k.Disc);
+
+    // inputs first, then outputs, then the kernel so that the adjoint reads the
+    // kernel (and with it the dimensions) before anything else
+    save_identifier_string("popdy1");
+    log_Fmult.save_dvar_matrix_position();
+    for ( int f=1; f<=nf; f++ ) sel_by_fleet(f).save_dvar_matrix_position();
+    log_recruit_devs.save_dvar_vector_position();
+    SR_alpha.save_prevariable_position();
+    SR_beta.save_prevariable_position();
+    for ( int f=1; f<=nf; f++ ) FAA_by_fleet_dir(f).save_dvar_matrix_position();
+    for ( int f=1; f<=nf; f++ ) FAA_by_fleet_Discard(f).save_dvar_matrix_position();
+    FAA_tot.save_dvar_matrix_position();
+    Z.save_dvar_matrix_position();
+    S.save_dvar_matrix_position();
+    SSBfracZ.save_dvar_matrix_position();
+    NAA.save_dvar_matrix_position();
+    SSB.save_dvar_vector_position();
+    SR_pred_recruits.save_dvar_vector_position();
+    for ( int f=1; f<=nf; f++ ) CAA_pred(f).save_dvar_matrix_position();
+    for ( int f=1; f<=nf; f++ ) Discard_pred(f).save_dvar_matrix_position();
+    save_int_value(int(k.stamp));
+    save_pointer_value(&k);
+    save_identifier_string("popdy2");
+    gradient_structure::GRAD_STACK1->set_gradient_stack(dfpopdy_kernel);
+}
+
+// derivatives of nf per-fleet output matrices, last fleet first (reverse of saving)
+static void popdy_restore(vector<double>& b, int nf) {
+    size_t n = b.size() / nf;
+    for ( int f=nf; f>=1; f-- ) {
+        dvar_matrix_position pos = restore_dvar_matrix_position();
+        dmatrix d = restore_dvar_matrix_derivatives(pos);
+        size_t i = size_t(f-1) * n;
+        for ( int y=d.rowmin(); y<=d.rowmax(); y++ )
+            for ( int a=d(y).indexmin(); a<=d(y).indexmax(); a++ ) b[i++] = d(y,a);
+    }
+}
+static dvar_matrix_position popdy_restore(vector<double>& b) {
+    dvar_matrix_position pos = restore_dvar_matrix_position();
+    dmatrix d = restore_dvar_matrix_derivatives(pos);
+    size_t i = 0;
+    for ( int y=d.rowmin(); y<=d.rowmax(); y++ )
+        for ( int a=d(y).indexmin(); a<=d(y).indexmax(); a++ ) b[i++] = d(y,a);
+    return pos;
+}
+static void popdy_restore(vector<double>& b, const dvar_vector_position& pos) {
+    dvector d = restore_dvar_vector_derivatives(pos);
+    size_t i = 0;
+    for ( int y=d.indexmin(); y<=d.indexmax(); y++ ) b[i++] = d(y);
+}
+
+static void dfpopdy_kernel(void)
+{
+    verify_identifier_string("popdy2");
+    popdy_kernel& k = *(popdy_kernel*)restore_pointer_value();
+    int stamp = restore_int_value();
+    if ( stamp != int(k.stamp) ) {
+        cerr << "popdy_kernel: reverse pass does not belong to the latest forward pass" << endl;
+        ad_exit(1);
+    }
+    int nf = k.nf, ny = k.ny, na = k.na;
+
+    // derivatives of the outputs
+    popdy_restore(k.bDisc, nf);
+    popdy_restore(k.bCAA, nf);
+    popdy_restore(k.bR, restore_dvar_vector_position());
+    popdy_restore(k.bSSB, restore_dvar_vector_position());
+    dvar_matrix_position NAApos = popdy_restore(k.bN);
+    popdy_restore(k.bSZ);
+    popdy_restore(k.bS);
+    popdy_restore(k.bZ);
+    popdy_restore(k.bFtot);
+    popdy_restore(k.bFr, nf);
+    popdy_restore(k.bFd, nf);
+
+    // positions of the inputs
+    prevariable_position betapos = restore_prevariable_position();
+    prevariable_position alphapos = restore_prevariable_position();
+    dvar_vector_position rdevpos = restore_dvar_vector_position();
+    vector<dvar_matrix_position> selpos;
+    for ( int f=nf; f>=1; f-- ) selpos.push_back(restore_dvar_matrix_position());
+    dvar_matrix_position logFpos = restore_dvar_matrix_position();
+    verify_identifier_string("popdy1");
+
+    k.reverse();
+
+    dmatrix dlogF(1,nf,1,ny);
+    size_t i = 0;
+    for ( int f=1; f<=nf; f++ )
+        for ( int y=1; y<=ny; y++ ) dlogF(f,y) = k.blogF[i++];
+    dlogF.save_dmatrix_derivatives(logFpos);
+    dmatrix dsel(1,ny,1,na);
+    for ( int f=1; f<=nf; f++ ) {
+        for ( int y=1; y<=ny; y++ )
+            for ( int a=1; a<=na; a++ ) dsel(y,a) = k.bsel[(size_t(f-1) * ny + y-1) * na + a-1];
+        dsel.save_dmatrix_derivatives(selpos[nf-f]);
+    }
+    dvector drdev(1,ny);
+    for ( int y=1; y<=ny; y++ ) drdev(y) = k.brdev[y-1];
+    drdev.save_dvector_derivatives(rdevpos);
+    save_double_derivative(k.balpha, alphapos);
+    save_double_derivative(k.bbeta, betapos);
+    // NAA row 1 ages >= 2: the restore above cleared these slots, write back
+    // the total (downstream plus kernel) derivative
+    dmatrix dN1(1,ny,1,na);
+    dN1.initialize();
+    for ( int a=2; a<=na; a++ ) dN1(1,a) = k.bN1[a-1];
+    dN1.save_dmatrix_derivatives(NAApos);
+}
+
+
+//======================================================================================
+// End File popdy_kernel.cpp
+//=======================================================================================
@@ -0,0 +1,172 @@
+/********************************************************************************
+* refpt_solver.cpp
+*
+* Double-precision spawners per recruit and yield per recruit with analytic
+* derivatives with respect to the F multiplier, and a Brent root finder, for the
+* ASAP reference points (F30%SPR, F40%SPR, Fmsy, F0.1, Fmax) and the F%SPR
+* projection target.
+*
+* Each reference point is the root of a function g(F) on a bracket [a,b]:
+*
+*   F%SPR   g = SPR(F)/SPR0 - ratio,  SPR0 = unfished SPR (SR_spawners_per_recruit)
+*   Fmsy    g = d/dF [ R(F) YPR(F) ],  R(F) = alpha - beta/SPR(F)  (Beverton-Holt)
+*   F0.1    g = YPR'(F) - 0.1 YPR'(0)
+*   Fmax    g = YPR'(F)
+*
+* with g >= 0 to the left of the root.  This is the same convention as the
+* 20-step bisections it replaces: if g does not change sign on [a,b] the result
+* is the end point the bisection would have converged to.  Brent's method reaches
+* machine precision in a handful of evaluations, and no AD variables are created.
+*
+* The SPR and YPR calculations are those of get_SPR and get_YPR in asap3.tpl
+* (last year M, fecundity and catch weights, projection selectivities), done by
+* the per-recruit engine shared with AMAK (em_input/common/per-recruit.cpp), which must be
+* included first.
+*
+* Version 1.0           17 Oct 2026     First version.
+* Version 1.1           17 Oct 2026     SPR and YPR from the shared per-recruit engine.
+*********************************************************************************/
+
+//=====================================================================================
+// refpt_curve
+//
+// Usage: set() with the last-year biology and projection selectivities, then call
+// the solvers.  spr() and ypr() return the value and the derivative with respect
+// to the F multiplier.  evals counts calls of spr() and ypr().
+//=====================================================================================
+class refpt_curve {
+public:
+    refpt_curve() : nages(0), frac(0.), alpha(0.), beta(0.), evals(0) {}
+
+    void set(const dvector& M_, const dvector& fec_, const dvector& waa_,
+             const dvector& dir_sel_, const dvector& disc_sel_, const dvector& nondir_F_,
+             double frac_, double spr0_, double alpha_, double beta_) {
+        nages = M_.indexmax() - M_.indexmin() + 1;
+        curve.set(M_ + nondir_F_, dir_sel_ + disc_sel_, elem_prod(dir_sel_, waa_), fec_, waa_, frac_);
+        frac = frac_;
+        alpha = alpha_;
+        beta = beta_;
+        spr0 = spr0_;
+        dypr0 = 0.;
+        ypr(0.0, &dypr0);
+    }
+
+    //=================================================================================
+    // spr, ypr
+    //
+    // One point of the per-recruit curve, from the engine shared with AMAK
+    // (per-recruit.cpp), with the derivative with respect to the F multiplier.
+    //=================================================================================
+    double spr(double F, double* d) {
+        evals++;
+        return curve.phi(F, d);
+    }
+
+    double ypr(double F, double* d) {
+        evals++;
+        return curve.ypr(F, d);
+    }
+
+    //=================================================================================
+    // reference points
+    //=================================================================================
+    double F_spr(double ratio, double a, double b) {
+        target = ratio;
+        return brent(&refpt_curve::g_spr, a, b);
+    }
+    double F_msy(double a, double b) { return brent(&refpt_curve::g_msy, a, b); }
+    double F_01(double a, double b) { return brent(&refpt_curve::g_01, a, b); }
+    double F_max(double a, double b) { return brent(&refpt_curve::g_max, a, b); }
+
+    int nages;
+    double frac, alpha, beta;
+    double spr0;                            // unfished SPR
+    double dypr0;                           // YPR'(F) at F=0
+    long evals;
+
+private:
+    typedef double (refpt_curve::*gfun)(double);
+
+    double g_spr(double F) { return spr(F, 0) / spr0 - target; }
+    double g_msy(double F) {
+        double dspr, dypr;
+        double s = spr(F, &dspr);
+        double y = ypr(F, &dypr);
+        return beta * dspr / (s * s) * y + (alpha - beta / s) * dypr;
+    }
+    double g_01(double F) {
+        double dypr;
+        ypr(F, &dypr);
+        return dypr - 0.1 * dypr0;
+    }
+    double g_max(double F) {
+        double dypr;
+        ypr(F, &dypr);
+        return dypr;
+    }
+
+    //=================================================================================
+    // brent
+    //
+    // Brent's method (inverse quadratic interpolation, secant and bisection steps)
+    // for the root of g on [a,b], to machine precision.
+    //=================================================================================
+    double brent(gfun g, double a, double b) {
+        const double eps = 2.2e-16;
+        double fa = (this->*g)(a);
+        double fb = (this->*g)(b);
+        if ( fb >= 0.0 ) return b;          // no sign change: same end point as bisection
+        if ( fa < 0.0 ) return a;
+        double c = a, fc = fa, d = b - a, e = d;
+        for ( int iter=0; iter<100; iter++ ) {
+            if ( (fb > 0.0) == (fc > 0.0) ) {
+                c = a;  fc = fa;  d = b - a;  e = d;
+            }
+            if ( fabs(fc) < fabs(fb) ) {
+                a = b;  b = c;  c = a;
+                fa = fb;  fb = fc;  fc = fa;
+            }
+            double tol = 2.0 * eps * fabs(b) + 1.0e-15;
+            double m = 0.5 * (c - b);
+            if ( fabs(m) <= tol || fb == 0.0 ) break;
+            if ( fabs(e) >= tol && fabs(fa) > fabs(fb) ) {
+                double p, q, r, s = fb / fa;
+                if ( a == c ) {
+                    p = 2.0 * m * s;
+                    q = 1.0 - s;
+                } else {
+                    q = fa / fc;
+                    r = fb / fc;
+                    p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+                    q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+                }
+                if ( p > 0.0 ) q = -q;
+                else p = -p;
+                double pmax = 3.0 * m * q - fabs(tol * q);
+                if ( fabs(e * q) < pmax ) pmax = fabs(e * q);
+                if ( 2.0 * p < pmax ) {
+                    e = d;
+                    d = p / q;
+                } else {
+                    d = m;
+                    e = d;
+                }
+            } else {
+                d = m;
+                e = d;
+            }
+            a = b;
+            fa = fb;
+            b += (fabs(d) > tol) ? d : (m > 0.0 ? tol : -tol);
+            fb = (this->*g)(b);
+        }
+        return b;
+    }
+
+    per_recruit curve;
+    double target;
+};
+
+//======================================================================================
+// End File refpt_solver.cpp
+//=======================================================================================
@@ -0,0 +1,214 @@
+#include <admodel.h>
+#include <vector>
+#include "per-recruit.h"
+
+per_recruit::~per_recruit()
+{}
+
+per_recruit::per_recruit()
+: m_a1(1), m_a2(0), m_dFrac(0)
+{}
+
+per_recruit::per_recruit(const dvector& _M, const dvector& _zsel, const dvector& _ysel,
+                         const dvector& _spawn, const dvector& _wt, double _frac)
+{
+	set(_M, _zsel, _ysel, _spawn, _wt, _frac);
+}
+
+
+void per_recruit::set(const dvector& _M, const dvector& _zsel, const dvector& _ysel,
+                      const dvector& _spawn, const dvector& _wt, double _frac)
+{
+	/*
+	All vectors are by age and share the index range of M.  The values are
+	copied, so the arguments can be temporaries.
+	*/
+	m_a1 = _M.indexmin();
+	m_a2 = _M.indexmax();
+
+	m_dM.deallocate();
+	m_dZsel.deallocate();
+	m_dYsel.deallocate();
+	m_dSpawn.deallocate();
+	m_dWt.deallocate();
+	m_dM.allocate(m_a1,m_a2);
+	m_dZsel.allocate(m_a1,m_a2);
+	m_dYsel.allocate(m_a1,m_a2);
+	m_dSpawn.allocate(m_a1,m_a2);
+	m_dWt.allocate(m_a1,m_a2);
+	for(int a = m_a1; a <= m_a2; a++ )
+	{
+		m_dM(a)     = _M(a);
+		m_dZsel(a)  = _zsel(a);
+		m_dYsel(a)  = _ysel(a);
+		m_dSpawn(a) = _spawn(a);
+		m_dWt(a)    = _wt(a);
+	}
+	m_dFrac = _frac;
+}
+
+
+/*
+	Core loop for nF values of F and na ages (arrays start at the first
+	age).  Numbers per recruit start at 1 and are carried in n[]; dlogn[]
+	is L = d log(n)/dF, which is constant in F except at the plus group
+	(divided by 1-e^-Z), where dL/dF = zsel^2 e^-Z/(1-e^-Z)^2.
+
+	With q = F h(Z), h(Z) = (1-e^-Z)/Z, the yield term n ysel q has
+	first derivative n ysel (L q + q') and second derivative
+	n ysel ((L^2 + L') q + 2 L q' + q''); the spawning term t has t (L - frac
+	zsel) and t ((L - frac zsel)^2 + L').  Second derivatives are only
+	computed when d2phi/d2ypr are given (together with dphi/dypr).
+	Outputs with a null pointer are not computed.
+*/
+static void per_recruit_kernel(int na, const double* M, const double* zsel,
+                               const double* ysel, const double* spawn, const double* wt,
+                               double frac, const double* F, int nF,
+                               double* phi, double* ypr, double* bpr,
+                               double* dphi, double* dypr,
+                               double* d2phi = 0, double* d2ypr = 0)
+{
+	std::vector<double> vn(nF, 1.0);
+	std::vector<double> vdlogn(nF, 0.0);
+	double* n     = &vn[0];
+	double* dlogn = &vdlogn[0];
+
+	int i;
+	for( i = 0; i < nF; i++ )
+	{
+		phi[i] = 0;
+		if( ypr )  ypr[i]  = 0;
+		if( bpr )  bpr[i]  = 0;
+		if( dphi ) dphi[i] = 0;
+		if( dypr ) dypr[i] = 0;
+		if( d2phi ) d2phi[i] = 0;
+		if( d2ypr ) d2ypr[i] = 0;
+	}
+
+	for( int a = 0; a < na; a++ )
+	{
+		const double m  = M[a];
+		const double zs = zsel[a];
+		const double ys = ysel[a];
+		const double sp = spawn[a];
+		const double w  = wt[a];
+		const bool plus = (a == na - 1);
+
+		for( i = 0; i < nF; i++ )
+		{
+			double z = m + F[i] * zs;
+			double e = exp(-z);
+			double dL = 0;
+			if( plus )
+			{
+				n[i]     /= (1.0 - e);
+				dlogn[i] -= zs * e / (1.0 - e);
+				dL        = zs * zs * e / ((1.0 - e) * (1.0 - e));
+			}
+			double t = n[i] * sp * exp(-frac * z);
+			phi[i] += t;
+			if( dphi )
+			{
+				double k = dlogn[i] - frac * zs;
+				dphi[i] += t * k;
+				if( d2phi ) d2phi[i] += t * (k * k + dL);
+			}
+			if( ypr )
+			{
+				double h = (1.0 - e) / z;
+				ypr[i] += n[i] * F[i] * ys * h;
+				if( dypr )
+				{
+					double dh = (z * e - (1.0 - e)) / (z * z);
+					double q  = F[i] * h;
+					double dq = h + F[i] * dh * zs;
+					dypr[i] += n[i] * ys * (dlogn[i] * q + dq);
+					if( d2ypr )
+					{
+						double d2h = -e / z - 2.0 * (z * e - (1.0 - e)) / (z * z * z);
+						double d2q = 2.0 * dh * zs + F[i] * d2h * zs * zs;
+						double L   = dlogn[i];
+						d2ypr[i] += n[i] * ys * ((L * L + dL) * q + 2.0 * L * dq + d2q);
+					}
+				}
+			}
+			if( bpr ) bpr[i] += n[i] * w;
+			n[i]     *= e;
+			dlogn[i] -= zs;
+		}
+	}
+}
+
+
+void per_recruit::evaluate(const dvector& F, dvector& phi, dvector& ypr, dvector& bpr) const
+{
+	int f1 = F.indexmin();
+	int nF = F.indexmax() - f1 + 1;
+	phi.deallocate();   phi.allocate(f1,F.indexmax());
+	ypr.deallocate();   ypr.allocate(f1,F.indexmax());
+	bpr.deallocate();   bpr.allocate(f1,F.indexmax());
+	per_recruit_kernel(m_a2 - m_a1 + 1, &m_dM(m_a1), &m_dZsel(m_a1),
+	                   &m_dYsel(m_a1), &m_dSpawn(m_a1), &m_dWt(m_a1),
+	                   m_dFrac, &F(f1), nF, &phi(f1), &ypr(f1), &bpr(f1), 0, 0);
+}
+
+
+void per_recruit::evaluate(const dvector& F, dvector& phi, dvector& ypr, dvector& bpr,
+                           dvector& dphi, dvector& dypr) const
+{
+	int f1 = F.indexmin();
+	int nF = F.indexmax() - f1 + 1;
+	phi.deallocate();   phi.allocate(f1,F.indexmax());
+	ypr.deallocate();   ypr.allocate(f1,F.indexmax());
+	bpr.deallocate();   bpr.allocate(f1,F.indexmax());
+	dphi.deallocate();  dphi.allocate(f1,F.indexmax());
+	dypr.deallocate();  dypr.allocate(f1,F.indexmax());
+	per_recruit_kernel(m_a2 - m_a1 + 1, &m_dM(m_a1), &m_dZsel(m_a1),
+	                   &m_dYsel(m_a1), &m_dSpawn(m_a1), &m_dWt(m_a1),
+	                   m_dFrac, &F(f1), nF, &phi(f1), &ypr(f1), &bpr(f1), &dphi(f1), &dypr(f1));
+}
+
+
+double per_recruit::phi(double F, double* dphi) const
+{
+	double p;
+	per_recruit_kernel(m_a2 - m_a1 + 1, &m_dM(m_a1), &m_dZsel(m_a1),
+	                   &m_dYsel(m_a1), &m_dSpawn(m_a1), &m_dWt(m_a1),
+	                   m_dFrac, &F, 1, &p, 0, 0, dphi, 0);
+	return p;
+}
+
+
+double per_recruit::ypr(double F, double* dypr) const
+{
+	double p, y;
+	per_recruit_kernel(m_a2 - m_a1 + 1, &m_dM(m_a1), &m_dZsel(m_a1),
+	                   &m_dYsel(m_a1), &m_dSpawn(m_a1), &m_dWt(m_a1),
+	                   m_dFrac, &F, 1, &p, &y, 0, 0, dypr);
+	return y;
+}
+
+
+void per_recruit::derivatives(double F, double* phi, double* ypr) const
+{
+	per_recruit_kernel(m_a2 - m_a1 + 1, &m_dM(m_a1), &m_dZsel(m_a1),
+	                   &m_dYsel(m_a1), &m_dSpawn(m_a1), &m_dWt(m_a1),
+	                   m_dFrac, &F, 1, &phi[0], &ypr[0], 0, &phi[1], &ypr[1], &phi[2], &ypr[2]);
+}
+
+
+/*
+	One step of a safeguarded Newton iteration for the root of g, with the
+	root bracketed by lo (g > 0) and hi (g < 0).  The bracket is narrowed
+	with the current point, then the Newton step x - g/dg is taken if it
+	stays inside the bracket, otherwise the bracket is bisected.
+*/
+double per_recruit_newton_step(double x, double g, double dg, double& lo, double& hi)
+{
+	if( g > 0 ) lo = x;
+	else        hi = x;
+	double xn = (dg != 0) ? x - g / dg : lo - 1.0;
+	if( !(xn > lo && xn < hi) )
+		xn = 0.5 * (lo + hi);
+	return xn;
+}
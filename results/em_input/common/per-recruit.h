@@ -0,0 +1,69 @@
+/**
+	This is a class for evaluating per-recruit quantities (spawning biomass,
+	yield and total biomass per recruit) of an age-structured population in
+	equilibrium, for a whole vector of F multipliers in one call.
+
+	Everything is in doubles, for use where no derivatives with respect to
+	the model parameters are needed (F profiles, reference point searches,
+	the operating model).  The age loop is the outer loop and the F values
+	are the inner loop over contiguous arrays, so the compiler can vectorise
+	it over F.
+
+	Mortality at age is Z = M + F zsel, with M any F-independent mortality
+	(natural mortality plus fixed non-directed F) and zsel the total
+	selectivity.  Yield per recruit is the Baranov catch F ysel (1-e^-Z)/Z
+	summed over ages, where ysel is selectivity times catch weight (summed
+	over fleets with their share of F).  Spawning biomass per recruit
+	discounts the numbers by the mortality up to the spawning time, e^-frac Z.
+	The last age is a plus group.
+
+	Used by AMAK (Profile_F) and ASAP (refpt_solver.cpp).  Both models
+	include per-recruit.cpp from this directory (em_input/common), which
+	must be on the include path when they are built (-I).
+*/
+
+#include <admodel.h>
+
+#ifndef PER_RECRUIT_H
+#define PER_RECRUIT_H
+
+class per_recruit
+{
+private:
+	int         m_a1;
+	int         m_a2;
+
+	dvector     m_dM;		// F-independent mortality at age.
+	dvector     m_dZsel;	// dZ/dF at age.
+	dvector     m_dYsel;	// Catch weight times the selectivity of the retained catch.
+	dvector     m_dSpawn;	// Spawning output at age (weight times maturity, or fecundity).
+	dvector     m_dWt;		// Weight at age for total biomass.
+	double      m_dFrac;	// Fraction of the year before spawning.
+
+public:
+	~per_recruit();
+	per_recruit();
+	per_recruit(const dvector& _M, const dvector& _zsel, const dvector& _ysel,
+	            const dvector& _spawn, const dvector& _wt, double _frac);
+
+	/* setters */
+	void set(const dvector& _M, const dvector& _zsel, const dvector& _ysel,
+	         const dvector& _spawn, const dvector& _wt, double _frac);
+
+	/* batched evaluation over F, results indexed like F */
+	void evaluate(const dvector& F, dvector& phi, dvector& ypr, dvector& bpr) const;
+	void evaluate(const dvector& F, dvector& phi, dvector& ypr, dvector& bpr,
+	              dvector& dphi, dvector& dypr) const;
+
+	/* single F, with optional derivatives with respect to F */
+	double phi(double F, double* dphi = 0) const;
+	double ypr(double F, double* dypr = 0) const;
+
+	/* value, first and second derivative with respect to F at a single F */
+	void derivatives(double F, double* phi, double* ypr) const;
+};
+
+double per_recruit_newton_step(double x, double g, double dg, double& lo, double& hi);
+
+
+#endif